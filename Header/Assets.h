@@ -0,0 +1,117 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <initializer_list>
+#include <condition_variable>
+#include "Model.h"
+#include "MeshPool.h"
+#include "TextureManager.h"
+
+enum AssetType { ASSET_MODEL, ASSET_TEXTURE };
+
+// LOADING covers both the queue of the loader thread and the upload waiting for the
+// next updateAssets. A handle whose asset was evicted reports EVICTED.
+enum AssetState { ASSET_LOADING, ASSET_READY, ASSET_FAILED, ASSET_EVICTED };
+
+// Index into AssetManager::assets plus the generation of that slot, so a handle kept
+// past an eviction never reaches the asset that reuses the slot.
+struct AssetHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+struct Asset {
+    AssetType type = ASSET_MODEL;
+    AssetState state = ASSET_LOADING;
+    std::string path;
+    uint32_t generation = 0;
+    int refs = 0;
+    // Frame of the last release; unreferenced assets are evicted oldest first.
+    uint64_t lastUsed = 0;
+    // Built-in assets have no file to load again and are never evicted.
+    bool builtin = false;
+    // Heap allocated so pointers handed out stay put while the table grows.
+    std::unique_ptr<Model> model;
+    TextureHandle texture = kNoTexture;
+};
+
+// File work done on the loader thread, waiting for its GL half.
+struct AssetLoad {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+    AssetType type = ASSET_MODEL;
+    std::string path;
+    bool ok = false;
+    ParsedModel model;
+    PreparedTexture texture;
+};
+
+struct AssetStats {
+    int requests = 0;
+    int hits = 0;
+    int loads = 0;
+    int failed = 0;
+    int evictions = 0;
+    size_t cpuBytes = 0;
+    size_t gpuBytes = 0;
+};
+
+// Models and textures by handle, deduplicated by the file they resolve to and counted by
+// reference. Files are read and parsed on a loader thread; updateAssets uploads them on
+// the GL thread and then evicts unreferenced assets, least recently released first,
+// while the total of CPU and GPU bytes is over budgetBytes.
+struct AssetManager {
+    MeshPool* meshes = nullptr;
+    TextureManager* textures = nullptr;
+    size_t budgetBytes = (size_t)256 << 20;
+    std::vector<Asset> assets;
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<std::string, uint32_t> byPath;
+    uint64_t frame = 0;
+
+    std::thread loader;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<AssetLoad> queue;
+    std::vector<AssetLoad> finished;
+    int inFlight = 0;
+    bool quit = false;
+
+    AssetStats stats;
+};
+
+const AssetHandle kNoAsset = AssetHandle();
+
+void startAssetManager(AssetManager& manager, MeshPool& meshes, TextureManager& textures);
+// Joins the loader and frees every asset, referenced or not.
+void stopAssetManager(AssetManager& manager);
+
+// The first candidate that exists is loaded; each acquire adds a reference. kNoAsset
+// when no candidate exists.
+AssetHandle acquireModel(AssetManager& manager, std::initializer_list<std::string> candidates);
+AssetHandle acquireTexture(AssetManager& manager, const std::string& path);
+// Takes ownership of a model built in code, already uploaded to the pool.
+AssetHandle addBuiltinModel(AssetManager& manager, const std::string& name, Model&& model);
+void releaseAsset(AssetManager& manager, AssetHandle handle);
+
+AssetState assetState(const AssetManager& manager, AssetHandle handle);
+// nullptr / kNoTexture until the asset is ready.
+const Model* assetModel(const AssetManager& manager, AssetHandle handle);
+TextureHandle assetTexture(const AssetManager& manager, AssetHandle handle);
+void assetBytes(const AssetManager& manager, const Asset& asset, size_t& cpuBytes, size_t& gpuBytes);
+
+// Once per frame on the GL thread.
+void updateAssets(AssetManager& manager);
+// Blocks until everything requested so far is loaded and uploaded.
+void waitForAssets(AssetManager& manager);
+// Swaps a hot-reloaded model in place, so pointers to it stay valid.
+bool reloadModelAsset(AssetManager& manager, const std::string& path, ParsedModel& parsed);
+void printAssetReport(const AssetManager& manager);
@@ -0,0 +1,5 @@
+#pragma once
+
+// Runs the CPU benchmarks named on the command line (all of them when none are given).
+// Started with `Kostur --bench [name...]`; no window or GL context is created.
+int runBenchmarks(int argc, char** argv);
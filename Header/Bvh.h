@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+#include <glm/glm.hpp>
+#include "Culling.h"
+
+// 32-byte node, two per cache line. Interior nodes keep their children next to each
+// other at leftOrFirst and leftOrFirst + 1 (always an even index, so a sibling pair
+// shares one line); leaves store count > 0 primitives starting at leftOrFirst. Node 1
+// is padding.
+struct alignas(32) BvhNode {
+    float minX, minY, minZ;
+    uint32_t leftOrFirst;
+    float maxX, maxY, maxZ;
+    uint32_t count;
+};
+
+static_assert(sizeof(BvhNode) == 32, "BvhNode must stay half a cache line");
+
+// std::allocator only guarantees 16-byte alignment before C++17.
+template <typename T>
+struct CacheLineAllocator {
+    typedef T value_type;
+    CacheLineAllocator() = default;
+    template <typename U> CacheLineAllocator(const CacheLineAllocator<U>&) {}
+    T* allocate(size_t n) {
+        void* p = nullptr;
+#ifdef _MSC_VER
+        p = _aligned_malloc(n * sizeof(T), 64);
+#else
+        if (posix_memalign(&p, 64, n * sizeof(T)) != 0) p = nullptr;
+#endif
+        if (!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t) {
+#ifdef _MSC_VER
+        _aligned_free(p);
+#else
+        free(p);
+#endif
+    }
+    template <typename U> bool operator==(const CacheLineAllocator<U>&) const { return true; }
+    template <typename U> bool operator!=(const CacheLineAllocator<U>&) const { return false; }
+};
+
+struct Bvh {
+    std::vector<BvhNode, CacheLineAllocator<BvhNode>> nodes;
+    std::vector<uint32_t> primitives;
+    // Edges from the root to the deepest leaf; bounds the traversal stacks.
+    int depth = 0;
+};
+
+// Triangle BVH in model space; triangles are stored in leaf order.
+struct MeshBvh {
+    Bvh tree;
+    std::vector<glm::vec3> triangles;
+};
+
+struct RayHit {
+    float t = 1e30f;
+    uint32_t primitive = 0;
+    uint32_t instance = 0;
+};
+
+// Prizes and other meshes placed with a translation and per-axis scale.
+struct BvhInstance {
+    const MeshBvh* mesh = nullptr;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+    uint32_t id = 0;
+};
+
+struct SceneBvh {
+    Bvh tree;
+    std::vector<BvhInstance> instances;
+};
+
+// Binned SAH build over primitive bounds.
+void buildBvh(Bvh& bvh, const std::vector<AABB>& primitiveBounds, int maxLeafSize = 4);
+void buildMeshBvh(MeshBvh& mesh, const std::vector<glm::vec3>& triangles);
+void buildSceneBvh(SceneBvh& scene, const std::vector<BvhInstance>& instances);
+
+bool intersectRay(const MeshBvh& mesh, glm::vec3 origin, glm::vec3 dir, RayHit& hit);
+bool intersectRay(const SceneBvh& scene, glm::vec3 origin, glm::vec3 dir, RayHit& hit);
+bool overlapsCapsule(const MeshBvh& mesh, glm::vec3 a, glm::vec3 b, float radius);
+// Appends the ids of all instances whose triangles come within radius of segment ab.
+int overlapsCapsule(const SceneBvh& scene, glm::vec3 a, glm::vec3 b, float radius, std::vector<uint32_t>& ids);
@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+struct AABB {
+    glm::vec3 min = glm::vec3(-0.5f);
+    glm::vec3 max = glm::vec3(0.5f);
+};
+
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.8660254f;
+};
+
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+struct CullStats {
+    int tested = 0;
+    int culled = 0;
+    int occluded = 0;
+    int clusters = 0;
+    int clustersCulled = 0;
+};
+
+// World-space boxes in center/extent form, SoA and padded to a multiple of 8 so the
+// SIMD kernels never need a scalar tail.
+struct BoundsBatch {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<uint8_t> visible;
+    size_t count = 0;
+};
+
+Frustum extractFrustum(const glm::mat4& viewProj);
+AABB transformAABB(const AABB& local, const glm::mat4& model);
+BoundingSphere boundingSphere(const AABB& box);
+bool isVisible(const Frustum& frustum, const AABB& box);
+bool isVisible(const Frustum& frustum, const BoundingSphere& sphere);
+
+void clearBounds(BoundsBatch& batch);
+void addBounds(BoundsBatch& batch, const AABB& worldBox);
+int cullBounds(const Frustum& frustum, BoundsBatch& batch);
@@ -0,0 +1,50 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Culling.h"
+#include "Meshlet.h"
+#include "MeshPool.h"
+#include "StreamRing.h"
+#include "Shaders.h"
+#include "TextureManager.h"
+
+struct DrawItem {
+    MeshRange mesh;
+    glm::vec3 color = glm::vec3(1.0f);
+    float alpha = 1.0f;
+    bool useTex = false;
+    TextureRegion texture;
+    // Meshes split into meshlets submit only their surviving clusters.
+    const MeshletMesh* meshlets = nullptr;
+};
+
+// Opaque draws are queued with their model matrix and local bounds. World bounds and
+// normal matrices are computed for the whole list at once; survivors become indirect
+// commands over the shared mesh pool, with baseInstance selecting each draw's row in
+// the instance buffer.
+struct DrawList {
+    std::vector<DrawItem> items;
+    std::vector<glm::mat4> models;
+    std::vector<AABB> localBounds;
+    std::vector<glm::mat3> normalMatrices;
+    BoundsBatch bounds;
+    std::vector<DrawElementsIndirectCommand> commands;
+    // Textured commands follow texturedStart, grouped by array texture.
+    size_t texturedStart = 0;
+};
+
+void clearDrawList(DrawList& list);
+void queueDraw(DrawList& list, const MeshRange& mesh, const glm::mat4& model, glm::vec3 color, float alpha = 1.0f, const TextureRegion* texture = nullptr, const AABB& localBounds = AABB());
+void queueMeshletDraw(DrawList& list, const MeshRange& mesh, const MeshletMesh& meshlets, const glm::mat4& model, glm::vec3 color, const AABB& localBounds);
+// Computes world bounds and clears the visible flag of draws outside the frustum. Further
+// culling, such as occlusion, may clear more flags before the commands are built.
+void cullDrawList(DrawList& list, const Frustum& frustum, CullStats& stats);
+// Turns the still visible draws into commands. Meshlets of those draws are culled against
+// the frustum and their normal cones as seen from eye.
+void buildDrawCommands(DrawList& list, const Frustum& frustum, glm::vec3 eye, CullStats& stats);
+// Instance rows and commands are written straight into the frame's stream ring. Each
+// texture state is drawn with its cheapest shader variant, or everything with the
+// depth-only one for shadow passes; textured draws bind once per array texture and
+// select their layer and rectangle per instance.
+void submitDrawList(DrawList& list, MeshPool& pool, StreamRing& ring, ShaderLibrary& shaders, bool depthOnly = false);
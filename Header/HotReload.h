@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Model.h"
+#include "Util.h"
+#include "TextureCache.h"
+#include "TextureManager.h"
+
+enum ReloadKind { RELOAD_SHADER, RELOAD_MODEL, RELOAD_TEXTURE };
+
+// A changed file with its slow half (reading, parsing, decoding) already done; only the
+// GL upload is left for the main thread.
+struct ReloadedAsset {
+    ReloadKind kind = RELOAD_SHADER;
+    std::string path;
+    std::string text;
+    ParsedModel model;
+    DecodedImage image;
+    // Contents hash of a texture, taken from the bytes image was decoded from.
+    uint64_t hash = 0;
+    // Filled for textures when compressTextures is set.
+    CompressedImage compressed;
+};
+
+struct WatchedFile {
+    std::string path;
+    ReloadKind kind = RELOAD_SHADER;
+    long long stamp = 0;
+    long long seen = 0;
+};
+
+// Background thread that polls the watched files and prepares reloads of the ones that
+// changed. A file is taken once it stops changing for one poll, so half-written saves
+// from an editor are skipped.
+struct HotReload {
+    std::vector<WatchedFile> files;
+    std::vector<ReloadedAsset> ready;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool quit = false;
+    int intervalMs = 250;
+    bool compressTextures = false;
+    int reloads = 0;
+};
+
+// Files are added before the watcher starts.
+void watchFile(HotReload& reload, const std::string& path, ReloadKind kind);
+void startHotReload(HotReload& reload);
+void stopHotReload(HotReload& reload);
+// Moves out everything prepared since the last call; used once per frame.
+size_t takeReloadedAssets(HotReload& reload, std::vector<ReloadedAsset>& out);
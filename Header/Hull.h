@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "Culling.h"
+
+// Convex hull in model space. Planes are stored as (normal, d) with dot(normal, p) <= d
+// for every point inside.
+struct ConvexHull {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec4> planes;
+    AABB bounds;
+    float volume = 0.0f;
+};
+
+// Quickhull, stopping once maxVertices are on the hull; the farthest outside point is
+// always added next, so an early stop only shaves off the smallest features.
+ConvexHull buildConvexHull(const std::vector<glm::vec3>& points, int maxVertices = 48);
+ConvexHull makeBoxHull(const AABB& box);
+
+// Approximate convex decomposition of a triangle soup: the piece with the largest hull
+// is split at its centroid along whichever axis shrinks the total hull volume most,
+// until maxPieces is reached or no split saves enough volume.
+std::vector<ConvexHull> decomposeConvex(const std::vector<glm::vec3>& triangles, int maxPieces = 4, int maxVertices = 32);
+
+// SAT over face normals of hulls placed at center with per-axis scale. The normal points
+// from a to b.
+bool intersectHulls(const ConvexHull& a, glm::vec3 centerA, glm::vec3 scaleA,
+    const ConvexHull& b, glm::vec3 centerB, glm::vec3 scaleB, glm::vec3& normal, float& depth);
+bool intersectSphereHull(glm::vec3 sphereCenter, float radius,
+    const ConvexHull& hull, glm::vec3 center, glm::vec3 scale, glm::vec3& normal, float& depth);
+bool hullOverlapsBox(const ConvexHull& hull, glm::vec3 center, glm::vec3 scale, const AABB& box);
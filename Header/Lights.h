@@ -0,0 +1,79 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "ThreadPool.h"
+#include "StreamRing.h"
+#include "Shaders.h"
+
+// Froxel grid: screen tiles in x and y, exponential depth slices in z.
+const int kClusterX = 16;
+const int kClusterY = 9;
+const int kClusterZ = 24;
+const int kClusterCount = kClusterX * kClusterY * kClusterZ;
+// Must match the array size of the Lights block in shader.frag.
+const int kMaxLights = 256;
+const int kMaxLightsPerCluster = 64;
+
+// Point light, or a spot light when spotCos > -1 (cosine of the cone half angle around
+// direction). Light fades to zero at radius; specular scales the highlight.
+struct Light {
+    glm::vec3 position = glm::vec3(0.0f);
+    float radius = 5.0f;
+    glm::vec3 color = glm::vec3(1.0f);
+    float specular = 1.0f;
+    glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    float spotCos = -1.0f;
+};
+
+// std140 layout of one entry of the Lights uniform block.
+struct GpuLight {
+    glm::vec4 positionRadius;
+    glm::vec4 color;
+    glm::vec4 directionCos;
+};
+
+struct LightStats {
+    int lights = 0;
+    int maxPerCluster = 0;
+    int references = 0;
+    double assignMs = 0.0;
+};
+
+// Lights are assigned to clusters on the CPU every frame, one depth slice per job. The
+// fragment shader finds its cluster from gl_FragCoord and view depth, then reads an
+// (offset, count) pair and the light indices from a texture buffer; light data comes
+// from a uniform block.
+struct ClusteredLights {
+    std::vector<Light> lights;
+
+    glm::mat4 projection = glm::mat4(0.0f);
+    float nearPlane = 0.1f;
+    float farPlane = 100.0f;
+    // View-space bounds of every cluster, rebuilt when the projection changes.
+    std::vector<glm::vec3> clusterMin, clusterMax;
+    // Per slice: bounds of each tile column, for rejecting a light before testing rows.
+    std::vector<glm::vec3> columnMin, columnMax;
+
+    std::vector<glm::vec4> viewSpheres;
+    std::vector<std::vector<uint16_t>> sliceIndices;
+    std::vector<uint32_t> sliceCounts;
+    // Grid of (offset, count) pairs followed by the light index list, as uploaded.
+    std::vector<uint32_t> clusterData;
+
+    unsigned int clusterBuffer = 0;
+    unsigned int clusterTexture = 0;
+    size_t clusterCapacity = 0;
+    LightStats stats;
+};
+
+void initClusteredLights(ClusteredLights& cl);
+void deleteClusteredLights(ClusteredLights& cl);
+void clearLights(ClusteredLights& cl);
+void addLight(ClusteredLights& cl, const Light& light);
+// CPU side only: fills clusterData for this view.
+void assignLights(ClusteredLights& cl, ThreadPool& threads, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane);
+// Streams the light block through the ring, uploads the cluster lists and fills the
+// cluster lookup parameters of frame.
+void uploadLights(ClusteredLights& cl, StreamRing& ring, FrameUniforms& frame, int viewportWidth, int viewportHeight);
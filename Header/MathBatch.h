@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "Culling.h"
+
+// Translation, rotation (unit quaternion x, y, z, w) and scale per instance, SoA.
+struct TRSBatch {
+    std::vector<float> px, py, pz;
+    std::vector<float> qx, qy, qz, qw;
+    std::vector<float> sx, sy, sz;
+    size_t count = 0;
+};
+
+void clearTRS(TRSBatch& batch);
+void addTRS(TRSBatch& batch, glm::vec3 position, glm::vec4 rotation = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec3 scale = glm::vec3(1.0f));
+
+// Batched kernels, dispatched to AVX2, SSE or scalar code at runtime. Results match
+// glm's translate * rotate * scale, transformAABB and transpose(inverse(mat3(m))).
+void composeTRS(const TRSBatch& batch, glm::mat4* out);
+void transformAABBs(const glm::mat4* models, const AABB* local, size_t count, BoundsBatch& out);
+void computeNormalMatrices(const glm::mat4* models, glm::mat3* out, size_t count);
+
+// Scalar versions, kept callable for tests and benchmarks.
+void composeTRSScalar(const TRSBatch& batch, size_t begin, size_t end, glm::mat4* out);
+void transformAABBsScalar(const glm::mat4* models, const AABB* local, size_t begin, size_t end, float* center[3], float* extent[3]);
+void computeNormalMatricesScalar(const glm::mat4* models, glm::mat3* out, size_t begin, size_t end);
+
+// Vertex stream kernels over SoA float arrays, used by the OBJ importer.
+void minMaxFloats(const float* values, size_t count, float& lo, float& hi);
+// values[i] = (values[i] - offset) * scale
+void offsetScaleFloats(float* values, size_t count, float offset, float scale);
+// Unit face normal of each triangle (x, y, z hold 3 * triangles vertices) written to its
+// three vertices; degenerate triangles get +Y.
+void flatTriangleNormals(const float* x, const float* y, const float* z, float* nx, float* ny, float* nz, size_t vertexCount);
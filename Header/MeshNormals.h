@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// Corner streams of an expanded triangle list, three corners per triangle. Corners that
+// share positionId are the same source vertex and are welded for smoothing.
+struct CornerStreams {
+    std::vector<float> x, y, z;
+    std::vector<float> nx, ny, nz;
+    std::vector<float> u, v;
+    std::vector<int> positionId;
+    std::vector<int> texcoordId;
+    std::vector<float> tx, ty, tz, tw;
+};
+
+void resizeCorners(CornerStreams& streams, size_t corners);
+
+// Angle-weighted vertex normals. Faces around a vertex only blend when their normals are
+// within creaseAngle (radians) of each other, so hard edges stay hard.
+void generateSmoothNormals(CornerStreams& streams, float creaseAngle);
+
+// Per-corner tangents (xyz) and bitangent sign (w), accumulated the MikkTSpace way: face
+// tangents projected onto the vertex normal, angle weighted, split on UV seams, normal
+// discontinuities and mirrored UVs.
+void generateTangents(CornerStreams& streams);
@@ -0,0 +1,73 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Vertex format shared by every mesh in the pool.
+struct PoolVertex {
+    float x, y, z;
+    float nx, ny, nz;
+    float u, v;
+    float tx, ty, tz, tw;
+};
+
+// Per-draw data read through instanced attributes (model at 3-6, color at 7, normal
+// matrix at 9-11, texture rectangle at 12 and array layer at 13), so a multi-draw picks
+// its row with baseInstance.
+struct DrawInstance {
+    glm::mat4 model;
+    glm::vec4 color;
+    glm::mat3 normalMatrix;
+    glm::vec4 texRect;
+    float texLayer;
+};
+
+static_assert(sizeof(DrawInstance) == 34 * sizeof(float), "DrawInstance must stay tightly packed");
+
+// Where a mesh lives in the pool. Indices are relative to firstVertex, which draws pass
+// as baseVertex, so a mesh can move without rewriting its indices.
+struct MeshRange {
+    uint32_t firstVertex = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+struct PoolSpan {
+    uint32_t offset;
+    uint32_t count;
+};
+
+// First-fit free list over [0, capacity), sorted by offset and coalesced on free.
+struct PoolAllocator {
+    uint32_t capacity = 0;
+    std::vector<PoolSpan> freeSpans;
+};
+
+bool poolAllocate(PoolAllocator& allocator, uint32_t count, uint32_t& offset);
+void poolFree(PoolAllocator& allocator, uint32_t offset, uint32_t count);
+void poolGrow(PoolAllocator& allocator, uint32_t newCapacity);
+
+// One VAO over a shared vertex and index buffer. Buffers double (with a GPU-side copy)
+// when an upload does not fit. Per-draw instance data is streamed from elsewhere;
+// instanceBuffer is the buffer the VAO's instance attributes currently point at.
+struct MeshPool {
+    unsigned int VAO = 0;
+    unsigned int vertexBuffer = 0;
+    unsigned int indexBuffer = 0;
+    unsigned int instanceBuffer = 0;
+    PoolAllocator vertices;
+    PoolAllocator indices;
+};
+
+void initMeshPool(MeshPool& pool, uint32_t vertexCapacity, uint32_t indexCapacity);
+MeshRange uploadMesh(MeshPool& pool, const PoolVertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+// Non-indexed position/normal/uv triangles (8 floats per vertex), as the built-in meshes use.
+MeshRange uploadTriangles(MeshPool& pool, const float* interleaved, uint32_t vertexCount);
+void releaseMesh(MeshPool& pool, const MeshRange& mesh);
+void deleteMeshPool(MeshPool& pool);
+
+// Points locations 3-7 and 9-13 of the bound VAO at DrawInstance records starting at
+// offset bytes into instanceBuffer.
+void bindInstanceAttributes(unsigned int instanceBuffer, size_t offset = 0);
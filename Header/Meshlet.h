@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "Culling.h"
+
+// Layout of one glMultiDrawElementsIndirect command.
+struct DrawElementsIndirectCommand {
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+
+// A small cluster of triangles: a contiguous index range plus bounds for culling. The
+// cluster faces away from the eye when dot(normalize(coneApex - eye), coneAxis) >=
+// coneCutoff; clusters whose normals spread too far get a cutoff above 1.
+struct Meshlet {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+    glm::vec3 coneApex = glm::vec3(0.0f);
+    glm::vec3 coneAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+    float coneCutoff = 2.0f;
+};
+
+struct MeshletMesh {
+    std::vector<uint32_t> indices;
+    std::vector<Meshlet> meshlets;
+};
+
+const size_t kMeshletMaxVertices = 64;
+const size_t kMeshletMaxTriangles = 124;
+
+void buildMeshlets(MeshletMesh& out, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+    size_t maxVertices = kMeshletMaxVertices, size_t maxTriangles = kMeshletMaxTriangles);
+
+// Culls the clusters of one instance against the frustum and their normal cones and
+// appends the survivors as draw commands, merging clusters that are adjacent in the index
+// buffer. Returns the number of clusters that survived.
+int cullMeshlets(const MeshletMesh& mesh, const glm::mat4& model, const Frustum& frustum, glm::vec3 eye,
+    std::vector<DrawElementsIndirectCommand>& commands);
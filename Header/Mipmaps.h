@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "Util.h"
+#include "ThreadPool.h"
+
+// One RGBA8 level; colour is sRGB encoded, alpha linear.
+struct MipLevel {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+// RGBA floats in linear light. Levels are filtered from the previous level in this form,
+// so the chain is quantised once per level and never re-read from 8 bits.
+struct LinearImage {
+    int width = 0;
+    int height = 0;
+    std::vector<float> pixels;
+};
+
+// Full chain down to 1x1; grey and grey-alpha images are expanded to RGBA. Each level is
+// a 2x2 box filter of the one above, averaged in linear light (odd edges repeat the last
+// texel). Levels depend on each other, so the rows of each level are what is split
+// across the pool when one is given.
+void buildMipChain(const DecodedImage& image, std::vector<MipLevel>& levels, ThreadPool* threads = nullptr);
+
+// Sizes dst to half of src, at least 1x1.
+void halveLinearImage(const LinearImage& src, LinearImage& dst);
+// Filters rows [rowBegin, rowEnd) of dst from src; dispatched to AVX2, SSE or scalar code
+// at runtime.
+void downsampleRows(const LinearImage& src, LinearImage& dst, size_t rowBegin, size_t rowEnd);
+// Scalar version, kept callable for benchmarks.
+void downsampleRowsScalar(const LinearImage& src, LinearImage& dst, size_t rowBegin, size_t rowEnd);
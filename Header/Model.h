@@ -1,16 +1,38 @@
 #pragma once
 #include <GL/glew.h>
 #include <string>
+#include <vector>
 #include <glm/glm.hpp>
+#include "Culling.h"
+#include "Hull.h"
+#include "Bvh.h"
+#include "Meshlet.h"
+#include "MeshPool.h"
 
 struct Model {
-    unsigned int VAO = 0;
-    int vertexCount = 0;
+    // Range in the shared mesh pool; indexCount is 0 until a mesh is loaded.
+    MeshRange mesh;
+    MeshletMesh meshlets;
     glm::vec3 center = glm::vec3(0.0f);
     float scale = 1.0f; 
     float halfHeight = 0.5f; 
     glm::vec3 halfExtents = glm::vec3(0.5f); 
+    AABB bounds;
+    BoundingSphere sphere;
+    ConvexHull hull;
+    std::vector<ConvexHull> hullPieces;
+    MeshBvh bvh;
+    // File the mesh was loaded from, empty for built-in meshes.
+    std::string source;
 };
 
-Model loadOBJWithCandidates(const std::initializer_list<std::string>& candidates);
-Model loadOBJ(const std::string& path);
+// An OBJ parsed on the CPU and not yet in the pool, so parsing can run off the GL thread.
+struct ParsedModel {
+    Model model;
+    std::vector<PoolVertex> vertices;
+};
+
+Model loadOBJWithCandidates(MeshPool& pool, const std::initializer_list<std::string>& candidates);
+Model loadOBJ(const std::string& path, MeshPool& pool);
+bool parseOBJ(const std::string& path, ParsedModel& parsed);
+Model uploadParsedModel(ParsedModel& parsed, MeshPool& pool);
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <glm/glm.hpp>
+#include "Culling.h"
+
+// Software occlusion culling: large static occluders are rasterized into a low-res
+// depth buffer on a worker thread, reduced into a max-depth (hierarchical Z) pyramid,
+// and draw-list bounds are then tested against the pyramid on the main thread.
+struct OcclusionCuller {
+    int width = 0;
+    int height = 0;
+    std::vector<std::vector<float>> levels;
+    std::vector<int> levelWidth, levelHeight;
+
+    glm::mat4 viewProj = glm::mat4(1.0f);
+    std::vector<AABB> occluders;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool jobPending = false;
+    bool jobDone = true;
+    bool quit = false;
+};
+
+void startOcclusionCuller(OcclusionCuller& culler, int width, int height);
+void stopOcclusionCuller(OcclusionCuller& culler);
+void beginOcclusionFrame(OcclusionCuller& culler, const glm::mat4& viewProj, const std::vector<AABB>& occluders);
+int cullOccluded(OcclusionCuller& culler, BoundsBatch& batch);
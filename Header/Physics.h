@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Culling.h"
+#include "Prizes.h"
+
+struct Contact {
+    uint32_t a = 0;
+    int32_t b = -1;
+    glm::vec3 normal = glm::vec3(0.0f, 1.0f, 0.0f);
+    float depth = 0.0f;
+};
+
+struct PhysicsStats {
+    int bodies = 0;
+    int awake = 0;
+    int pairsTested = 0;
+    int contacts = 0;
+    int islands = 0;
+    int sweptBodies = 0;
+    int sweptHits = 0;
+};
+
+// Translational rigid bodies for prizes (toys stay axis-aligned, so there is no angular
+// state). Bodies collide as boxes, spheres or their mesh's convex hull; static geometry
+// is a list of boxes and bodies are binned into a uniform grid spanning the cabinet
+// interior for the broadphase. Fast bodies are swept against the static boxes, so one
+// step per frame is enough without tunnelling through the chute floor.
+struct PhysicsWorld {
+    std::vector<AABB> statics;
+    glm::vec3 gridMin = glm::vec3(-2.0f, 0.0f, -2.0f);
+    glm::vec3 gridMax = glm::vec3(2.0f, 7.0f, 2.0f);
+    float fixedStep = 1.0f / 75.0f;
+    int maxSubSteps = 8;
+    int solverIterations = 8;
+    float accumulator = 0.0f;
+
+    float cellSize = 0.5f;
+    int dims[3] = { 1, 1, 1 };
+    std::vector<uint32_t> cellOfBody;
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellBodies;
+    std::vector<Contact> contacts;
+    std::vector<int> islandParent;
+    std::vector<uint8_t> islandRest;
+    std::vector<uint8_t> islandFast;
+    PhysicsStats stats;
+};
+
+void initPhysicsWorld(PhysicsWorld& world, const std::vector<AABB>& statics);
+void stepPhysics(PhysicsWorld& world, PrizeStore& store, const std::vector<const Model*>& meshes, float dt);
+void stepPhysicsFixed(PhysicsWorld& world, PrizeStore& store, const std::vector<const Model*>& meshes, float h);
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "Model.h"
+#include "DrawList.h"
+#include "MathBatch.h"
+
+enum PrizeFlag : uint8_t {
+    PRIZE_CAUGHT = 1 << 0,
+    PRIZE_FALLING = 1 << 1,
+    PRIZE_DROPPED = 1 << 2,
+    PRIZE_TAKEN = 1 << 3,
+    PRIZE_ASLEEP = 1 << 4
+};
+
+enum PrizeShape : uint8_t {
+    SHAPE_BOX = 0,
+    SHAPE_SPHERE = 1,
+    SHAPE_HULL = 2
+};
+
+// Prize entities as dense component arrays; an entity is an index into all of them.
+// Meshes are referenced by handle into a shared Model table, so systems never branch
+// on which prize they are looking at.
+struct PrizeStore {
+    std::vector<glm::vec3> position;
+    std::vector<glm::vec3> scale;
+    std::vector<glm::vec3> velocity;
+    std::vector<glm::vec3> halfExtents;
+    std::vector<uint8_t> shape;
+    std::vector<float> sleepTimer;
+    std::vector<uint8_t> flags;
+    std::vector<uint32_t> mesh;
+    std::vector<glm::vec3> color;
+
+    // Scratch for composing every visible prize's model matrix in one batch.
+    TRSBatch transforms;
+    std::vector<glm::mat4> models;
+};
+
+size_t prizeCount(const PrizeStore& store);
+// meshes is indexed by PrizeStore::mesh; the models are owned by the asset manager and
+// must stay loaded while prizes use them.
+uint32_t addPrize(PrizeStore& store, const std::vector<const Model*>& meshes, glm::vec3 position, glm::vec3 color, uint32_t mesh, glm::vec3 scale = glm::vec3(1.0f), PrizeShape shape = SHAPE_BOX);
+// Recomputes the half extents of every prize using mesh, after that model was swapped.
+void refreshPrizeExtents(PrizeStore& store, const std::vector<const Model*>& meshes, uint32_t mesh);
+bool anyPrize(const PrizeStore& store, uint8_t required, uint8_t excluded);
+int findPrizeInVolume(const PrizeStore& store, const std::vector<const Model*>& meshes, const AABB& volume);
+void buildPrizeBvh(const PrizeStore& store, const std::vector<const Model*>& meshes, SceneBvh& bvh);
+int findMostTouchedPrize(const PrizeStore& store, const std::vector<uint32_t>& touched);
+int takeDroppedPrizes(PrizeStore& store);
+int releaseCaughtPrizes(PrizeStore& store);
+int markPrizesInside(PrizeStore& store, const AABB& region, uint8_t flag);
+
+void updateCaughtPrizes(PrizeStore& store, glm::vec3 clawPos);
+void queuePrizeDraws(PrizeStore& store, const std::vector<const Model*>& meshes, DrawList& list);
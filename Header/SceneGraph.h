@@ -0,0 +1,20 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// Flat transform hierarchy. Nodes are stored in contiguous arrays with every parent
+// placed before its children, so one forward pass propagates dirty flags and world
+// matrices; nodes before the first dirty index are never visited.
+struct TransformHierarchy {
+    std::vector<int> parent;
+    std::vector<glm::mat4> local;
+    std::vector<glm::mat4> world;
+    std::vector<uint8_t> dirty;
+    size_t firstDirty = 0;
+};
+
+int addNode(TransformHierarchy& h, int parent, const glm::mat4& local);
+void setLocal(TransformHierarchy& h, int node, const glm::mat4& local);
+int updateWorldTransforms(TransformHierarchy& h);
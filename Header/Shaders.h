@@ -0,0 +1,111 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "StreamRing.h"
+
+// Feature bits of a shader variant. Each set bit becomes a #define in both stages, so a
+// variant only contains the code its draws need.
+enum ShaderFeature : uint32_t {
+    SHADER_TEXTURED = 1u << 0,
+    // Key light and ambient.
+    SHADER_LIT = 1u << 1,
+    // Clustered point and spot lights; only meaningful together with SHADER_LIT.
+    SHADER_LOCAL_LIGHTS = 1u << 2,
+    SHADER_ALPHA_TEST = 1u << 3,
+    // Model matrix, colour and normal matrix come from instanced attributes.
+    SHADER_INSTANCED = 1u << 4
+};
+
+// Binding points set once per variant when it is linked.
+const GLuint kLightsBlockBinding = 0;
+const GLuint kFrameBlockBinding = 1;
+const int kMaterialTextureUnit = 0;
+const int kClusterTextureUnit = 1;
+const int kShadowTextureUnit = 2;
+
+// std140 layout of the Frame uniform block shared by all variants.
+struct FrameUniforms {
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec4 viewPos = glm::vec4(0.0f);
+    glm::vec4 lightPos = glm::vec4(0.0f);
+    glm::vec4 lightColor = glm::vec4(1.0f);
+    glm::vec4 ambientFill = glm::vec4(0.0f);
+    // x: shininess, y: specular strength.
+    glm::vec4 material = glm::vec4(32.0f, 0.5f, 0.0f, 0.0f);
+    // Tile size in pixels (x, y), then the log-depth to slice scale and bias.
+    glm::vec4 clusterParams = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+    // World space to shadow map texture space of the shadowed spot light.
+    glm::mat4 shadowMatrix = glm::mat4(1.0f);
+    // x: index of the shadowed light, -1 for none; y: shadow map texel size.
+    glm::vec4 shadowParams = glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f);
+};
+
+// A variant whose compile and link were issued but not yet collected.
+struct PendingShader {
+    uint32_t features = 0;
+    unsigned int program = 0;
+    unsigned int vertexShader = 0;
+    unsigned int fragmentShader = 0;
+    bool cached = false;
+    uint64_t key = 0;
+    std::chrono::steady_clock::time_point requested;
+};
+
+// Variants of one vertex/fragment pair, built on first use and cached by feature key.
+// Linked programs are also saved as driver binaries under cacheDirectory, keyed by a hash
+// of the specialised sources and the GL vendor, renderer and version; a binary the
+// driver rejects is deleted and the variant compiled from source again.
+struct ShaderLibrary {
+    // Sources the programs were built from.
+    std::string vertexSource;
+    std::string fragmentSource;
+    // Latest text of each stage, built or not, so a stage edited alongside the other
+    // is rebuilt with it even when it failed on its own.
+    std::string latestVertexSource;
+    std::string latestFragmentSource;
+    std::unordered_map<uint32_t, unsigned int> programs;
+    std::vector<PendingShader> pending;
+    std::string cacheDirectory;
+    std::string driverKey;
+    int cacheHits = 0;
+    int cacheMisses = 0;
+    // Time the calling thread spent in the library, including waits for the driver.
+    double buildMs = 0.0;
+};
+
+// An empty cacheDirectory disables the binary cache.
+bool initShaderLibrary(ShaderLibrary& lib, const char* vertexPath, const char* fragmentPath, const char* cacheDirectory = "ShaderCache");
+// Issues compiles for the listed variants without waiting; with KHR_parallel_shader_compile
+// the driver builds them on its own threads while the caller carries on.
+void requestShaderVariants(ShaderLibrary& lib, const uint32_t* features, size_t count);
+// Collects requested variants the driver reports complete and returns how many are still
+// building. Without the extension nothing can be checked without blocking, so they stay
+// pending until first use.
+size_t pollShaderVariants(ShaderLibrary& lib);
+// Returns 0 if the variant failed to build; the failure is cached too. A variant that is
+// still pending is waited for here.
+unsigned int getShaderVariant(ShaderLibrary& lib, uint32_t features);
+unsigned int useShaderVariant(ShaderLibrary& lib, uint32_t features);
+// Rebuilds every variant built so far from new sources. The old programs stay in use
+// unless all of them rebuild.
+bool reloadShaderSources(ShaderLibrary& lib, const std::string& vertexSource, const std::string& fragmentSource);
+// Records new text for one stage (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER) and reloads
+// from the latest text of both.
+bool reloadShaderStage(ShaderLibrary& lib, GLenum stage, const std::string& source);
+void deleteShaderLibrary(ShaderLibrary& lib);
+
+// Cheapest variant for a surface: textured surfaces are unlit and alpha tested, the rest
+// get the full lighting.
+uint32_t surfaceVariant(bool textured, bool instanced);
+// Neither lit nor textured, for depth-only passes into targets without colour.
+uint32_t shadowVariant(bool instanced);
+// Offset alignment for uniform blocks bound from a shared buffer.
+size_t uniformBlockAlignment();
+// Streams the block through the ring and binds it for every variant.
+void bindFrameUniforms(StreamRing& ring, const FrameUniforms& frame);
@@ -0,0 +1,51 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Culling.h"
+#include "DrawList.h"
+#include "Lights.h"
+
+struct ShadowStats {
+    int staticRenders = 0;
+    int dynamicRenders = 0;
+    // Frames whose shadow map was reused untouched.
+    int reused = 0;
+    // Dynamic casters inside the light's frustum in the last frame.
+    int casters = 0;
+    // CPU time spent issuing shadow passes.
+    double renderMs = 0.0;
+};
+
+// Shadow map for one spot light. Static casters are rendered once into their own depth
+// layer and only again when the light moves. The sampled map is that layer copied, plus
+// the dynamic casters on top, and is rebuilt only in frames where something visible to
+// the light moved, so an idle machine costs no shadow rendering at all.
+struct SpotShadow {
+    int size = 0;
+    unsigned int staticTexture = 0;
+    unsigned int staticFramebuffer = 0;
+    unsigned int texture = 0;
+    unsigned int framebuffer = 0;
+
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    Frustum frustum;
+    bool staticValid = false;
+    bool dynamicValid = false;
+    // Hash of the dynamic casters drawn into the current map.
+    uint64_t dynamicKey = 0;
+    ShadowStats stats;
+};
+
+bool initSpotShadow(SpotShadow& shadow, int size = 1024);
+void deleteSpotShadow(SpotShadow& shadow);
+// Points the shadow at the light; the static layer is dropped if it moved.
+void setSpotShadowLight(SpotShadow& shadow, const Light& light, float nearPlane = 0.05f);
+// Renders the static layer from casters when it is missing; casters are cleared either way.
+void renderStaticShadows(SpotShadow& shadow, DrawList& casters, MeshPool& pool, StreamRing& ring, ShaderLibrary& shaders);
+// Refreshes the sampled map if the visible dynamic casters differ from the last update.
+void renderDynamicShadows(SpotShadow& shadow, DrawList& casters, MeshPool& pool, StreamRing& ring, ShaderLibrary& shaders);
+// Fills the shadow fields of frame and binds the map for lightIndex.
+void bindSpotShadow(const SpotShadow& shadow, FrameUniforms& frame, int lightIndex);
@@ -0,0 +1,17 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define KANDZA_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define KANDZA_SIMD_X86 0
+#endif
+
+// MSVC accepts AVX intrinsics in any function; GCC/Clang need the target enabled per function.
+#if defined(__GNUC__) || defined(__clang__)
+#define KANDZA_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define KANDZA_TARGET_AVX2
+#endif
+
+bool cpuHasAVX2();
@@ -0,0 +1,49 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include <cstddef>
+
+const int kStreamRegions = 3;
+
+// A uniform block range bound from the current region.
+struct StreamBinding {
+    GLuint index = 0;
+    size_t offset = 0;
+    size_t bytes = 0;
+    size_t alignment = 1;
+};
+
+// Per-frame upload buffer split into one region per frame in flight. With
+// ARB_buffer_storage the buffer stays persistently and coherently mapped, so the CPU
+// writes straight into GPU-visible memory, and a fence per region keeps it from
+// overwriting data a queued frame still reads. Without it, writes go to a CPU copy that
+// is uploaded with glBufferSubData into a buffer orphaned every frame.
+struct StreamRing {
+    unsigned int buffer = 0;
+    size_t regionBytes = 0;
+    int region = 0;
+    size_t head = 0;
+    GLsync fences[kStreamRegions] = {};
+    unsigned char* mapped = nullptr;
+    std::vector<unsigned char> staging;
+    // Bound this frame; growing the ring copies them to the new buffer and binds them again.
+    std::vector<StreamBinding> bindings;
+    // Frames that had to wait for the GPU before writing.
+    int stalls = 0;
+};
+
+void initStreamRing(StreamRing& ring, size_t regionBytes);
+// Waits until the GPU is done with the next region and makes it current.
+void beginStreamFrame(StreamRing& ring);
+// Fences the commands that read the current region.
+void endStreamFrame(StreamRing& ring);
+// Reserves bytes in the current region. offset is from the start of the buffer and a
+// multiple of alignment, which need not be a power of two, so records of any size can
+// be addressed by index. A full region grows the ring after waiting for the GPU, which
+// also replaces the buffer object; only ranges bound through streamBindUniforms follow it.
+unsigned char* streamAllocate(StreamRing& ring, size_t bytes, size_t alignment, size_t& offset);
+// glBindBufferRange on GL_UNIFORM_BUFFER for a range allocated with alignment this frame.
+void streamBindUniforms(StreamRing& ring, GLuint index, size_t offset, size_t bytes, size_t alignment);
+// Makes written bytes visible to the GPU; nothing to do for the coherent mapping.
+void streamCommit(StreamRing& ring, size_t offset, size_t bytes);
+void deleteStreamRing(StreamRing& ring);
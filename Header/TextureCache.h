@@ -0,0 +1,69 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "Util.h"
+#include "ThreadPool.h"
+
+// Block-compressed mip chain, level 0 first.
+struct CompressedImage {
+    // GL_COMPRESSED_RGB_S3TC_DXT1_EXT (BC1) or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT (BC3).
+    GLenum format = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<std::vector<unsigned char>> levels;
+};
+
+struct TextureCacheStats {
+    int textures = 0;
+    int hits = 0;
+    int misses = 0;
+    // Wall time of whole loads, and the part of it spent encoding on misses.
+    double loadMs = 0.0;
+    double encodeMs = 0.0;
+    // Mip chains as uploaded, against the same chains as RGBA8.
+    size_t compressedBytes = 0;
+    size_t uncompressedBytes = 0;
+};
+
+// Images are compressed on first load and kept as KTX 1.1 files under directory, named
+// by a hash of the source path, size and modification time; later loads upload the
+// stored mip chain without decoding or mipmapping anything.
+struct TextureCache {
+    std::string directory = "TextureCache";
+    // Mips and blocks are encoded on this pool when set.
+    ThreadPool* threads = nullptr;
+    TextureCacheStats stats;
+};
+
+// rgba holds a 4x4 block of texels, row by row.
+void encodeBC1Block(const unsigned char* rgba, unsigned char* out);
+void encodeBC3Block(const unsigned char* rgba, unsigned char* out);
+// BC1 unless some texel is not fully opaque, then BC3; mips come from buildMipChain.
+void compressImage(const DecodedImage& image, CompressedImage& out, ThreadPool* threads = nullptr);
+
+bool writeKTX(const std::string& path, const CompressedImage& image);
+bool readKTX(const std::string& path, CompressedImage& image);
+
+bool compressedTexturesSupported();
+// target is GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY; an array gets the image as its only layer.
+void uploadCompressedImage(unsigned texture, const CompressedImage& image, GLenum target = GL_TEXTURE_2D);
+// The cached mip chain of filePath, encoded and stored first on a miss.
+bool loadCompressedImage(TextureCache& cache, const char* filePath, CompressedImage& image);
+
+// A chain read from the cache or encoded on a miss, with what the stats need.
+struct CompressedLoad {
+    CompressedImage image;
+    bool cached = false;
+    double ms = 0.0;
+    double encodeMs = 0.0;
+};
+
+// loadCompressedImage for a file whose contents are already in bytes; they are decoded
+// only on a miss. Touches neither the stats nor the pool, so it may run on any thread.
+bool prepareCompressedImage(const TextureCache& cache, const char* filePath, const std::vector<unsigned char>& bytes, CompressedLoad& load);
+// Adds a prepared load to the stats; on the thread that owns the cache.
+void countCompressedLoad(TextureCache& cache, const char* filePath, const CompressedLoad& load);
+// Falls back to loadImageToTexture when S3TC is not available.
+unsigned loadCompressedTexture(TextureCache& cache, const char* filePath);
@@ -0,0 +1,128 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "Util.h"
+#include "TextureCache.h"
+#include "Mipmaps.h"
+
+// Where a texture's 0..1 UVs land: a layer of a GL_TEXTURE_2D_ARRAY and the rectangle
+// inside it (offset in xy, size in zw).
+struct TextureRegion {
+    unsigned texture = 0;
+    float layer = 0.0f;
+    glm::vec4 rect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+};
+
+typedef int TextureHandle;
+const TextureHandle kNoTexture = -1;
+
+// Rows of equal-height slots filling one atlas layer bottom up.
+struct AtlasShelf {
+    int y = 0;
+    int height = 0;
+    int used = 0;
+};
+
+struct AtlasSlot {
+    int x = 0, y = 0, width = 0, height = 0;
+};
+
+// RGBA8 copy of one layer, kept to re-upload it when the array grows. Slots of unloaded
+// images are reused before the shelves grow.
+struct AtlasLayer {
+    DecodedImage image;
+    std::vector<AtlasShelf> shelves;
+    std::vector<AtlasSlot> freeSlots;
+    int top = 0;
+};
+
+// One distinct image. Paths with the same file contents share it.
+struct ManagedImage {
+    uint64_t hash = 0;
+    TextureRegion region;
+    // Packed slot including the gutter, or layer -1 for a texture of its own.
+    int layer = -1;
+    int x = 0, y = 0, width = 0, height = 0;
+    // GPU bytes of the slot's mips or of the whole texture, and of the slot's CPU copy.
+    size_t bytes = 0;
+    size_t cpuBytes = 0;
+    // Paths loaded with these contents; 0 once unloaded.
+    int users = 0;
+};
+
+// image is -1 once the path is unloaded.
+struct ManagedTexture {
+    std::string path;
+    int image = -1;
+};
+
+struct TextureManagerStats {
+    int requests = 0;
+    int pathHits = 0;
+    int contentHits = 0;
+    int packed = 0;
+    int standalone = 0;
+    // Textures bound by textured draws; one per distinct array.
+    int arrays = 0;
+    size_t atlasBytes = 0;
+    size_t standaloneBytes = 0;
+    double loadMs = 0.0;
+};
+
+// Textures up to maxPackedSize are packed into layers of one array texture, with a gutter
+// of repeated edge texels so the first few mips do not bleed between neighbours. Larger
+// ones come from the KTX cache as single-layer arrays, so every textured draw samples a
+// sampler2DArray and draws sharing an array need no rebinds.
+struct TextureManager {
+    int layerSize = 1024;
+    int maxPackedSize = 512;
+    unsigned atlas = 0;
+    int atlasCapacity = 0;
+    std::vector<AtlasLayer> layers;
+    std::vector<ManagedImage> images;
+    // Handles index textures; a handle stays valid across reloads.
+    std::vector<ManagedTexture> textures;
+    std::unordered_map<std::string, TextureHandle> byPath;
+    std::unordered_map<uint64_t, int> byContent;
+    TextureCache cache;
+    TextureManagerStats stats;
+};
+
+// The file work of a load: contents hashed and, from the same bytes, decoded for the
+// atlas or turned into a standalone mip chain (read from the KTX cache or encoded when
+// S3TC is there, RGBA8 otherwise). Touches no GL or manager state, so it may run on any
+// thread.
+struct PreparedTexture {
+    std::string path;
+    uint64_t hash = 0;
+    int width = 0;
+    int height = 0;
+    DecodedImage image;
+    CompressedLoad compressed;
+    std::vector<MipLevel> mips;
+};
+
+// Whole file and the hash loads are matched by; decode from these bytes so the pixels
+// are the ones hashed.
+bool readTextureFile(const char* filePath, std::vector<unsigned char>& bytes, uint64_t& hash);
+bool prepareTexture(const TextureManager& manager, const char* filePath, PreparedTexture& prepared);
+// The GL half: packs or uploads what prepareTexture made.
+TextureHandle addTexture(TextureManager& manager, const PreparedTexture& prepared);
+// Loads a file once per path and once per distinct contents; kNoTexture on failure.
+TextureHandle loadTexture(TextureManager& manager, const char* filePath);
+// Forgets the path; its storage is freed when no other path shares the contents. The
+// handle then maps to an empty region.
+void unloadTexture(TextureManager& manager, TextureHandle handle);
+const TextureRegion& textureRegion(const TextureManager& manager, TextureHandle handle);
+// The path's share of its image; paths with the same contents split the bytes evenly.
+void textureBytes(const TextureManager& manager, TextureHandle handle, size_t& cpuBytes, size_t& gpuBytes);
+// Swaps new contents in for every handle of path. hash comes from readTextureFile with the
+// bytes image was decoded from. A packed image keeps its slot when it still fits;
+// compressed is used for standalone textures when it has levels.
+bool reloadTexture(TextureManager& manager, const std::string& path, uint64_t hash, const DecodedImage& image, const CompressedImage& compressed);
+void deleteTextureManager(TextureManager& manager);
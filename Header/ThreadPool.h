@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+// Fixed set of worker threads for data-parallel loops. parallelFor hands out chunks of
+// [0, count) to the workers and the calling thread and returns once all have run.
+struct ThreadPool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::function<void(size_t, size_t)> job;
+    size_t count = 0;
+    size_t grain = 1;
+    std::atomic<size_t> next{ 0 };
+    int busy = 0;
+    unsigned long long generation = 0;
+    bool quit = false;
+};
+
+// threads = 0 uses one worker less than the hardware threads (the caller is the last).
+void startThreadPool(ThreadPool& pool, int threads = 0);
+void stopThreadPool(ThreadPool& pool);
+// fn(begin, end) is called for consecutive chunks of at most grain items.
+void parallelFor(ThreadPool& pool, size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
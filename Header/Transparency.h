@@ -0,0 +1,42 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Culling.h"
+#include "MeshPool.h"
+#include "StreamRing.h"
+#include "Shaders.h"
+
+struct TransparentInstance {
+    glm::mat4 model;
+    glm::vec4 color;
+    glm::vec3 center;
+};
+
+struct DepthSortScratch {
+    std::vector<uint32_t> keys;
+    std::vector<uint32_t> temp;
+};
+
+// Collects blended instances for one frame, sorts them back to front by view depth
+// and submits them with a single instanced draw of a mesh in the shared pool. Instance
+// rows are written into the frame's stream ring.
+struct TransparencyPass {
+    MeshRange mesh;
+    std::vector<TransparentInstance> instances;
+    BoundsBatch bounds;
+    std::vector<float> depths;
+    std::vector<uint32_t> order;
+    std::vector<glm::mat4> sortedModels;
+    std::vector<glm::mat3> normalMatrices;
+    DepthSortScratch scratch;
+};
+
+void initTransparencyPass(TransparencyPass& pass, const MeshRange& mesh);
+void addTransparentInstance(TransparencyPass& pass, const glm::mat4& model, glm::vec3 color, float alpha);
+void cullTransparencyPass(TransparencyPass& pass, const Frustum& frustum, CullStats& stats);
+void drawTransparencyPass(TransparencyPass& pass, MeshPool& pool, StreamRing& ring, ShaderLibrary& shaders, const glm::mat4& view);
+void deleteTransparencyPass(TransparencyPass& pass);
+
+void sortBackToFront(const std::vector<float>& depths, std::vector<uint32_t>& order, DepthSortScratch& scratch);
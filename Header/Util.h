@@ -2,8 +2,22 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <string>
+#include <vector>
+
+// Pixels as stb_image returns them, flipped for GL's bottom-left origin.
+struct DecodedImage {
+    std::vector<unsigned char> pixels;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+};
+
 int endProgram(std::string message);
-unsigned int createShader(const char* vsSource, const char* fsSource);
+// Decoding touches no GL state and may run on any thread; the upload must not.
+bool decodeImage(const char* filePath, DecodedImage& image);
+// Same from the file's bytes already in memory; filePath only names it in errors.
+bool decodeImage(const unsigned char* data, size_t size, const char* filePath, DecodedImage& image);
+void uploadImageToTexture(unsigned texture, const DecodedImage& image);
 unsigned loadImageToTexture(const char* filePath);
 GLFWcursor* loadImageToCursor(const char* filePath);
 
@@ -4,64 +4,126 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+flat in float TexLayer;
+in vec4 ObjectColor;
+in float ViewDepth;
 
-uniform vec3 objectColor;
-uniform vec3 lightPos;
-uniform vec3 lightColor;
-uniform vec3 spotlightPos;
-uniform float alpha;
-uniform bool useTexture;
-uniform sampler2D uTex;
-uniform vec3 viewPos;
-uniform float shininess;
-uniform float specularStrength;
+// Must match FrameUniforms in Shaders.h.
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+    vec4 ambientFill;
+    vec4 material;       // x: shininess, y: specular strength
+    vec4 clusterParams;  // tile size, log-depth scale and bias
+    mat4 shadowMatrix;   // world to shadow map of the shadowed spot light
+    vec4 shadowParams;   // x: its light index or -1, y: shadow map texel size
+};
 
-uniform vec3 pointLightPos;
-uniform vec3 pointLightColor;
+#ifdef TEXTURED
+uniform sampler2DArray uTex;
+#endif
+
+#ifdef LOCAL_LIGHTS
+// Must match kClusterX/Y/Z and kMaxLights in Lights.h.
+const int kClusterX = 16;
+const int kClusterY = 9;
+const int kClusterZ = 24;
+
+struct LightData {
+    vec4 positionRadius;
+    vec4 color;         // w: specular scale
+    vec4 directionCos;  // w: spot cone cosine, -1 for point lights
+};
+
+layout (std140) uniform Lights {
+    LightData lights[256];
+};
+
+// Per cluster an (offset, count) pair, then the light index list.
+uniform usamplerBuffer clusterData;
+uniform sampler2DShadow shadowMap;
+
+// 3x3 PCF; each tap is itself a bilinear 2x2 comparison.
+float spotShadow() {
+    vec4 coord = shadowMatrix * vec4(FragPos, 1.0);
+    if (coord.w <= 0.0) return 1.0;
+    vec3 p = coord.xyz / coord.w;
+    if (p.z >= 1.0) return 1.0;
+    float lit = 0.0;
+    for (int y = -1; y <= 1; ++y)
+        for (int x = -1; x <= 1; ++x)
+            lit += texture(shadowMap, vec3(p.xy + vec2(x, y) * shadowParams.y, p.z));
+    return lit / 9.0;
+}
+
+vec3 clusteredLighting(vec3 norm, vec3 viewDir, float shininess, float specularStrength) {
+    int x = clamp(int(gl_FragCoord.x / clusterParams.x), 0, kClusterX - 1);
+    int y = clamp(int(gl_FragCoord.y / clusterParams.y), 0, kClusterY - 1);
+    int z = clamp(int(log(max(ViewDepth, 1e-4)) * clusterParams.z + clusterParams.w), 0, kClusterZ - 1);
+    int cluster = y + kClusterY * (x + kClusterX * z);
+    int offset = int(texelFetch(clusterData, 2 * cluster).r);
+    int count = int(texelFetch(clusterData, 2 * cluster + 1).r);
+    int listStart = 2 * kClusterX * kClusterY * kClusterZ + offset;
+
+    vec3 result = vec3(0.0);
+    for (int i = 0; i < count; ++i) {
+        int index = int(texelFetch(clusterData, listStart + i).r);
+        LightData light = lights[index];
+        vec3 toLight = light.positionRadius.xyz - FragPos;
+        float dist = length(toLight);
+        if (dist >= light.positionRadius.w) continue;
+        vec3 dir = toLight / max(dist, 1e-4);
+        if (light.directionCos.w > -1.0 && dot(-dir, light.directionCos.xyz) <= light.directionCos.w) continue;
+        float ratio = dist / light.positionRadius.w;
+        float falloff = 1.0 - ratio * ratio * ratio * ratio;
+        falloff *= falloff;
+        if (index == int(shadowParams.x)) falloff *= spotShadow();
+
+        float diff = max(dot(norm, dir), 0.0);
+        vec3 halfDir = normalize(dir + viewDir);
+        float spec = pow(max(dot(norm, halfDir), 0.0), shininess);
+        result += falloff * (diff + specularStrength * spec * light.color.w) * light.color.rgb;
+    }
+    return result;
+}
+#endif
 
 void main() {
+    vec4 color = ObjectColor;
+#ifdef TEXTURED
+    vec4 texColor = texture(uTex, vec3(TexCoords, TexLayer));
+#ifdef ALPHA_TEST
+    if(texColor.a < 0.1) discard;
+#endif
+    color = vec4(texColor.rgb, texColor.a * ObjectColor.a);
+#endif
+
+#ifdef LIT
+    float shininess = max(material.x, 1.0);
+    float specularStrength = material.y;
     float ambientStrength = 0.6;
     vec3 baseAmbient = vec3(0.45);
-    vec3 ambient = baseAmbient + ambientStrength * (lightColor + pointLightColor) * 0.5;
+    vec3 ambient = baseAmbient + ambientStrength * (lightColor.rgb + ambientFill.rgb) * 0.5;
 
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
+    vec3 lightDir = normalize(lightPos.xyz - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
-
-    vec3 plDir = normalize(pointLightPos - FragPos);
-    float diff2 = max(dot(norm, plDir), 0.0);
-    vec3 diffuse2 = diff2 * pointLightColor;
+    vec3 diffuse = diff * lightColor.rgb;
 
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
     vec3 halfDir = normalize(lightDir + viewDir);
-    float specFactor = pow(max(dot(norm, halfDir), 0.0), max(shininess, 1.0));
-    vec3 specular = specularStrength * specFactor * lightColor;
-
-    vec3 halfDir2 = normalize(plDir + viewDir);
-    float specFactor2 = pow(max(dot(norm, halfDir2), 0.0), max(shininess, 1.0));
-    vec3 specular2 = specularStrength * specFactor2 * pointLightColor;
-
-    vec3 spotDir = vec3(0.0, -1.0, 0.0);
-    vec3 lightToFrag = normalize(FragPos - spotlightPos);
-    float theta = dot(lightToFrag, normalize(spotDir));
-    
-    vec3 spotlight = vec3(0.0);
-    if(theta > 0.95) {
-        float spotDiff = max(dot(norm, -lightToFrag), 0.0);
-        spotlight = spotDiff * vec3(1.0, 1.0, 0.8) * 2.0;
-        vec3 spotHalf = normalize(-lightToFrag + viewDir);
-        float spotSpec = pow(max(dot(norm, spotHalf), 0.0), max(shininess,1.0));
-        spotlight += specularStrength * spotSpec * vec3(1.0, 1.0, 0.8) * 0.5;
-    }
+    float specFactor = pow(max(dot(norm, halfDir), 0.0), shininess);
+    vec3 specular = specularStrength * specFactor * lightColor.rgb;
 
-    if(useTexture) {
-        vec4 texColor = texture(uTex, TexCoords);
-        if(texColor.a < 0.1) discard;
-        FragColor = vec4(texColor.rgb, texColor.a * alpha);
-        return;
-    } else {
-        vec3 result = (ambient + diffuse + diffuse2 + specular + specular2 + spotlight) * objectColor;
-        FragColor = vec4(result, alpha);
-    }
+    vec3 lighting = ambient + diffuse + specular;
+#ifdef LOCAL_LIGHTS
+    lighting += clusteredLighting(norm, viewDir, shininess, specularStrength);
+#endif
+    color.rgb *= lighting;
+#endif
+
+    FragColor = color;
 }
\ No newline at end of file
@@ -2,19 +2,75 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#ifdef INSTANCED
+layout (location = 3) in mat4 aInstanceModel;
+layout (location = 7) in vec4 aInstanceColor;
+layout (location = 9) in mat3 aInstanceNormal;
+#ifdef TEXTURED
+layout (location = 12) in vec4 aInstanceTexRect;
+layout (location = 13) in float aInstanceTexLayer;
+#endif
+#endif
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
+flat out float TexLayer;
+out vec4 ObjectColor;
+out float ViewDepth;
 
+// Must match FrameUniforms in Shaders.h.
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+    vec4 ambientFill;
+    vec4 material;
+    vec4 clusterParams;
+    mat4 shadowMatrix;
+    vec4 shadowParams;
+};
+
+#ifndef INSTANCED
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix;
+uniform vec3 objectColor;
+uniform float alpha;
+#ifdef TEXTURED
+// Layer and rectangle of the texture inside its array; see TextureRegion.
+uniform vec4 texRect;
+uniform float texLayer;
+#endif
+#endif
 
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
+#ifdef INSTANCED
+    mat4 modelMat = aInstanceModel;
+    mat3 normalMat = aInstanceNormal;
+    ObjectColor = aInstanceColor;
+#else
+    mat4 modelMat = model;
+    mat3 normalMat = normalMatrix;
+    ObjectColor = vec4(objectColor, alpha);
+#endif
+    FragPos = vec3(modelMat * vec4(aPos, 1.0));
     // Raunanje normale u world space-u (korekcija skaliranja)
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = normalMat * aNormal;
     TexCoords = aTexCoords;
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+#ifdef TEXTURED
+#ifdef INSTANCED
+    vec4 rect = aInstanceTexRect;
+    TexLayer = aInstanceTexLayer;
+#else
+    vec4 rect = texRect;
+    TexLayer = texLayer;
+#endif
+    // Clamped like GL_CLAMP_TO_EDGE so UVs never reach a neighbour in the atlas.
+    TexCoords = rect.xy + clamp(aTexCoords, 0.0, 1.0) * rect.zw;
+#endif
+    vec4 viewSpace = view * vec4(FragPos, 1.0);
+    ViewDepth = -viewSpace.z;
+    gl_Position = projection * viewSpace;
 }
\ No newline at end of file
@@ -0,0 +1,301 @@
+#include "../Header/Assets.h"
+#include <iostream>
+#include <algorithm>
+#include <sys/stat.h>
+
+namespace {
+
+bool fileExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+void loaderLoop(AssetManager* manager) {
+    std::unique_lock<std::mutex> lock(manager->mutex);
+    for (;;) {
+        manager->wake.wait(lock, [&] { return manager->quit || !manager->queue.empty(); });
+        if (manager->quit) return;
+        AssetLoad load = std::move(manager->queue.front());
+        manager->queue.pop_front();
+        lock.unlock();
+        // Only the texture manager's packing limits are read here, and they never change.
+        if (load.type == ASSET_MODEL) load.ok = parseOBJ(load.path, load.model);
+        else load.ok = prepareTexture(*manager->textures, load.path.c_str(), load.texture);
+        lock.lock();
+        manager->finished.push_back(std::move(load));
+        --manager->inFlight;
+        manager->idle.notify_all();
+    }
+}
+
+const Asset* findAsset(const AssetManager& manager, AssetHandle handle) {
+    if (handle.index >= manager.assets.size()) return nullptr;
+    const Asset& asset = manager.assets[handle.index];
+    return asset.generation == handle.generation ? &asset : nullptr;
+}
+
+AssetHandle handleOf(const AssetManager& manager, uint32_t index) {
+    AssetHandle handle;
+    handle.index = index;
+    handle.generation = manager.assets[index].generation;
+    return handle;
+}
+
+uint32_t newAsset(AssetManager& manager, AssetType type, const std::string& path) {
+    uint32_t index;
+    if (!manager.freeSlots.empty()) {
+        index = manager.freeSlots.back();
+        manager.freeSlots.pop_back();
+    } else {
+        index = (uint32_t)manager.assets.size();
+        manager.assets.emplace_back();
+    }
+    Asset& asset = manager.assets[index];
+    asset.type = type;
+    asset.state = ASSET_LOADING;
+    asset.path = path;
+    asset.refs = 1;
+    asset.lastUsed = manager.frame;
+    manager.byPath[path] = index;
+    return index;
+}
+
+AssetHandle acquire(AssetManager& manager, AssetType type, const std::string& path) {
+    ++manager.stats.requests;
+    std::unordered_map<std::string, uint32_t>::const_iterator known = manager.byPath.find(path);
+    if (known != manager.byPath.end()) {
+        ++manager.assets[known->second].refs;
+        ++manager.stats.hits;
+        return handleOf(manager, known->second);
+    }
+    const uint32_t index = newAsset(manager, type, path);
+    AssetLoad load;
+    load.index = index;
+    load.generation = manager.assets[index].generation;
+    load.type = type;
+    load.path = path;
+    {
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        manager.queue.push_back(std::move(load));
+        ++manager.inFlight;
+    }
+    manager.wake.notify_one();
+    return handleOf(manager, index);
+}
+
+// GL half of the loads the loader thread has finished.
+void uploadFinished(AssetManager& manager) {
+    std::vector<AssetLoad> loads;
+    {
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        loads.swap(manager.finished);
+    }
+    for (AssetLoad& load : loads) {
+        Asset& asset = manager.assets[load.index];
+        if (asset.generation != load.generation || asset.state != ASSET_LOADING) continue;
+        if (load.ok && load.type == ASSET_MODEL) {
+            asset.model.reset(new Model(uploadParsedModel(load.model, *manager.meshes)));
+            load.ok = asset.model->mesh.indexCount != 0;
+        } else if (load.ok) {
+            asset.texture = addTexture(*manager.textures, load.texture);
+            load.ok = asset.texture != kNoTexture;
+        }
+        asset.state = load.ok ? ASSET_READY : ASSET_FAILED;
+        ++(load.ok ? manager.stats.loads : manager.stats.failed);
+    }
+}
+
+void freeAsset(AssetManager& manager, uint32_t index) {
+    Asset& asset = manager.assets[index];
+    if (asset.model) releaseMesh(*manager.meshes, asset.model->mesh);
+    asset.model.reset();
+    if (asset.texture != kNoTexture) unloadTexture(*manager.textures, asset.texture);
+    asset.texture = kNoTexture;
+    std::unordered_map<std::string, uint32_t>::iterator known = manager.byPath.find(asset.path);
+    if (known != manager.byPath.end() && known->second == index) manager.byPath.erase(known);
+    asset.path.clear();
+    asset.state = ASSET_EVICTED;
+    asset.refs = 0;
+    asset.builtin = false;
+    ++asset.generation;
+    manager.freeSlots.push_back(index);
+}
+
+size_t hullBytes(const ConvexHull& hull) {
+    return hull.vertices.size() * sizeof(glm::vec3) + hull.planes.size() * sizeof(glm::vec4);
+}
+
+const char* stateName(AssetState state) {
+    switch (state) {
+    case ASSET_LOADING: return "ucitava se";
+    case ASSET_READY: return "spremno";
+    case ASSET_FAILED: return "neuspelo";
+    default: return "izbaceno";
+    }
+}
+
+// Ready assets only; the rest hold nothing yet or anymore.
+void totalBytes(const AssetManager& manager, size_t& cpuBytes, size_t& gpuBytes) {
+    cpuBytes = gpuBytes = 0;
+    for (const Asset& asset : manager.assets) {
+        if (asset.state != ASSET_READY) continue;
+        size_t c, g;
+        assetBytes(manager, asset, c, g);
+        cpuBytes += c;
+        gpuBytes += g;
+    }
+}
+
+}
+
+void startAssetManager(AssetManager& manager, MeshPool& meshes, TextureManager& textures) {
+    manager.meshes = &meshes;
+    manager.textures = &textures;
+    manager.quit = false;
+    manager.loader = std::thread(loaderLoop, &manager);
+}
+
+void stopAssetManager(AssetManager& manager) {
+    if (manager.loader.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(manager.mutex);
+            manager.quit = true;
+        }
+        manager.wake.notify_all();
+        manager.loader.join();
+    }
+    manager.queue.clear();
+    manager.finished.clear();
+    manager.inFlight = 0;
+    for (uint32_t i = 0; i < manager.assets.size(); ++i)
+        if (manager.assets[i].state != ASSET_EVICTED) freeAsset(manager, i);
+}
+
+AssetHandle acquireModel(AssetManager& manager, std::initializer_list<std::string> candidates) {
+    std::vector<std::string> tried;
+    for (const std::string& path : candidates) {
+        if (std::find(tried.begin(), tried.end(), path) != tried.end()) continue;
+        tried.push_back(path);
+        if (manager.byPath.count(path) || fileExists(path)) return acquire(manager, ASSET_MODEL, path);
+    }
+    std::cout << "Model nije pronadjen: " << (tried.empty() ? std::string() : tried.front()) << std::endl;
+    return kNoAsset;
+}
+
+AssetHandle acquireTexture(AssetManager& manager, const std::string& path) {
+    return acquire(manager, ASSET_TEXTURE, path);
+}
+
+AssetHandle addBuiltinModel(AssetManager& manager, const std::string& name, Model&& model) {
+    const uint32_t index = newAsset(manager, ASSET_MODEL, name);
+    Asset& asset = manager.assets[index];
+    asset.model.reset(new Model(std::move(model)));
+    asset.state = ASSET_READY;
+    asset.builtin = true;
+    return handleOf(manager, index);
+}
+
+void releaseAsset(AssetManager& manager, AssetHandle handle) {
+    if (!findAsset(manager, handle)) return;
+    Asset& asset = manager.assets[handle.index];
+    if (asset.refs > 0 && --asset.refs == 0) asset.lastUsed = manager.frame;
+}
+
+AssetState assetState(const AssetManager& manager, AssetHandle handle) {
+    const Asset* asset = findAsset(manager, handle);
+    return asset ? asset->state : ASSET_EVICTED;
+}
+
+const Model* assetModel(const AssetManager& manager, AssetHandle handle) {
+    const Asset* asset = findAsset(manager, handle);
+    return asset && asset->state == ASSET_READY ? asset->model.get() : nullptr;
+}
+
+TextureHandle assetTexture(const AssetManager& manager, AssetHandle handle) {
+    const Asset* asset = findAsset(manager, handle);
+    return asset && asset->state == ASSET_READY ? asset->texture : kNoTexture;
+}
+
+void assetBytes(const AssetManager& manager, const Asset& asset, size_t& cpuBytes, size_t& gpuBytes) {
+    cpuBytes = gpuBytes = 0;
+    if (asset.texture != kNoTexture) textureBytes(*manager.textures, asset.texture, cpuBytes, gpuBytes);
+    if (!asset.model) return;
+    const Model& m = *asset.model;
+    cpuBytes = sizeof(Model) + m.meshlets.indices.size() * sizeof(uint32_t) + m.meshlets.meshlets.size() * sizeof(Meshlet)
+        + m.bvh.tree.nodes.size() * sizeof(BvhNode) + m.bvh.tree.primitives.size() * sizeof(uint32_t) + m.bvh.triangles.size() * sizeof(glm::vec3)
+        + hullBytes(m.hull);
+    for (const ConvexHull& piece : m.hullPieces) cpuBytes += hullBytes(piece);
+    gpuBytes = (size_t)m.mesh.vertexCount * sizeof(PoolVertex) + (size_t)m.mesh.indexCount * sizeof(uint32_t);
+}
+
+void updateAssets(AssetManager& manager) {
+    uploadFinished(manager);
+
+    for (uint32_t i = 0; i < manager.assets.size(); ++i)
+        if (manager.assets[i].state == ASSET_FAILED && manager.assets[i].refs == 0) freeAsset(manager, i);
+    size_t cpu, gpu;
+    totalBytes(manager, cpu, gpu);
+    while (cpu + gpu > manager.budgetBytes) {
+        int oldest = -1;
+        for (uint32_t i = 0; i < manager.assets.size(); ++i) {
+            const Asset& asset = manager.assets[i];
+            if (asset.state != ASSET_READY || asset.refs > 0 || asset.builtin) continue;
+            if (oldest < 0 || asset.lastUsed < manager.assets[oldest].lastUsed) oldest = (int)i;
+        }
+        if (oldest < 0) break;
+        size_t c, g;
+        assetBytes(manager, manager.assets[oldest], c, g);
+        std::cout << "Izbaceno iz memorije: " << manager.assets[oldest].path << " (" << (c + g) / 1024 << " KB)" << std::endl;
+        freeAsset(manager, (uint32_t)oldest);
+        ++manager.stats.evictions;
+        // Summed again, since freeing one path of a shared image only moves its share to
+        // the other paths.
+        totalBytes(manager, cpu, gpu);
+    }
+    manager.stats.cpuBytes = cpu;
+    manager.stats.gpuBytes = gpu;
+    ++manager.frame;
+}
+
+void waitForAssets(AssetManager& manager) {
+    {
+        std::unique_lock<std::mutex> lock(manager.mutex);
+        manager.idle.wait(lock, [&] { return manager.inFlight == 0; });
+    }
+    updateAssets(manager);
+}
+
+bool reloadModelAsset(AssetManager& manager, const std::string& path, ParsedModel& parsed) {
+    std::unordered_map<std::string, uint32_t>::const_iterator known = manager.byPath.find(path);
+    if (known == manager.byPath.end()) return false;
+    Asset& asset = manager.assets[known->second];
+    if (asset.state != ASSET_READY || !asset.model) return false;
+    Model fresh = uploadParsedModel(parsed, *manager.meshes);
+    if (fresh.mesh.indexCount == 0) return false;
+    releaseMesh(*manager.meshes, asset.model->mesh);
+    *asset.model = std::move(fresh);
+    return true;
+}
+
+void printAssetReport(const AssetManager& manager) {
+    int live = 0, ready = 0, loading = 0, failed = 0;
+    for (const Asset& asset : manager.assets) {
+        if (asset.state == ASSET_EVICTED) continue;
+        ++live;
+        ready += asset.state == ASSET_READY;
+        loading += asset.state == ASSET_LOADING;
+        failed += asset.state == ASSET_FAILED;
+    }
+    std::cout << "Resursi: " << live << " (" << ready << " spremno, " << loading << " se ucitava, " << failed << " neuspelo), CPU "
+        << manager.stats.cpuBytes / 1024 << " KB + GPU " << manager.stats.gpuBytes / 1024 << " KB od " << (manager.budgetBytes >> 20)
+        << " MB; zahteva " << manager.stats.requests << ", deljeno " << manager.stats.hits << ", izbaceno " << manager.stats.evictions << std::endl;
+    for (const Asset& asset : manager.assets) {
+        if (asset.state == ASSET_EVICTED) continue;
+        size_t cpu, gpu;
+        assetBytes(manager, asset, cpu, gpu);
+        std::cout << "  " << (asset.type == ASSET_MODEL ? "model " : "tekstura ") << asset.path << " [" << stateName(asset.state) << ", "
+            << asset.refs << " ref] CPU " << cpu / 1024 << " KB, GPU " << gpu / 1024 << " KB" << std::endl;
+    }
+    if (manager.textures && manager.textures->atlas != 0)
+        std::cout << "  atlas tekstura: " << manager.textures->layers.size() << " slojeva, " << manager.textures->stats.atlasBytes / 1024 << " KB u VRAM" << std::endl;
+}
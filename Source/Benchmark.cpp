@@ -0,0 +1,338 @@
+#include "../Header/Benchmark.h"
+#include "../Header/Physics.h"
+#include "../Header/Bvh.h"
+#include "../Header/MathBatch.h"
+#include "../Header/Simd.h"
+#include "../Header/Lights.h"
+#include "../Header/ThreadPool.h"
+#include "../Header/TextureCache.h"
+#include "../Header/Mipmaps.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock BenchClock;
+
+double elapsedMs(BenchClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+void benchPhysics() {
+    const std::vector<AABB> colliders = {
+        { glm::vec3(-2.0f, 0.0f, -2.0f), glm::vec3(2.0f, 1.15f, 2.0f) },
+        { glm::vec3(-2.0f, 4.8f, -2.0f), glm::vec3(2.0f, 5.2f, 2.0f) },
+        { glm::vec3(1.95f, 0.1f, -2.15f), glm::vec3(2.15f, 4.8f, 2.15f) },
+        { glm::vec3(-2.15f, 0.1f, -2.15f), glm::vec3(-1.95f, 4.8f, 2.15f) },
+        { glm::vec3(-2.15f, 0.1f, 1.95f), glm::vec3(2.15f, 4.8f, 2.15f) },
+        { glm::vec3(-2.15f, 0.1f, -2.15f), glm::vec3(2.15f, 4.8f, -1.95f) }
+    };
+    Model blobModel;
+    std::vector<glm::vec3> blob;
+    for (int i = 0; i < 400; ++i) {
+        float t = i * 2.399963f, y = 1.0f - 2.0f * (i + 0.5f) / 400.0f, r = std::sqrt(1.0f - y * y);
+        blob.push_back(glm::vec3(std::cos(t) * r, y * 0.8f, std::sin(t) * r) * 0.5f);
+    }
+    blobModel.hull = buildConvexHull(blob, 32);
+    const std::vector<const Model*> meshes = { &blobModel };
+    const PrizeShape shapes[] = { SHAPE_BOX, SHAPE_SPHERE, SHAPE_HULL };
+    const int steps = 600;
+
+    for (int bodies : { 100, 250, 500 }) {
+        PrizeStore store;
+        for (int i = 0; i < bodies; ++i) {
+            glm::vec3 pos(-1.6f + 0.4f * (i % 9), 1.2f + 0.35f * (i / 81), -1.6f + 0.4f * ((i / 9) % 9));
+            addPrize(store, meshes, pos, glm::vec3(1.0f), 0, glm::vec3(0.3f), shapes[i % 3]);
+        }
+        PhysicsWorld world;
+        initPhysicsWorld(world, colliders);
+
+        BenchClock::time_point start = BenchClock::now();
+        int awakeSteps = 0;
+        for (int s = 0; s < steps; ++s) {
+            stepPhysicsFixed(world, store, meshes, world.fixedStep);
+            awakeSteps += world.stats.awake;
+        }
+        double ms = elapsedMs(start);
+
+        std::cout << "physics " << bodies << " tela: " << ms / steps << " ms/korak, "
+            << (double)bodies * steps / ms << " tela/ms, "
+            << (double)awakeSteps / ms << " budnih tela/ms, na kraju budno " << world.stats.awake << std::endl;
+    }
+}
+
+// Lumpy sphere with about 40k triangles, the size of the dog toy.
+std::vector<glm::vec3> makeBumpySphere(int rings, int segments) {
+    auto point = [&](int r, int s) {
+        float phi = 3.14159265f * r / rings, theta = 6.2831853f * s / segments;
+        float bump = 0.5f + 0.04f * std::sin(phi * 9.0f) * std::cos(theta * 7.0f);
+        return glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta)) * bump;
+    };
+    std::vector<glm::vec3> tris;
+    for (int r = 0; r < rings; ++r) {
+        for (int s = 0; s < segments; ++s) {
+            glm::vec3 p00 = point(r, s), p10 = point(r, s + 1), p01 = point(r + 1, s), p11 = point(r + 1, s + 1);
+            tris.push_back(p00); tris.push_back(p01); tris.push_back(p10);
+            tris.push_back(p10); tris.push_back(p01); tris.push_back(p11);
+        }
+    }
+    return tris;
+}
+
+void benchRays() {
+    std::vector<glm::vec3> tris = makeBumpySphere(140, 143);
+    BenchClock::time_point start = BenchClock::now();
+    MeshBvh bvh;
+    buildMeshBvh(bvh, tris);
+    std::cout << "bvh " << tris.size() / 3 << " trouglova: izgradnja " << elapsedMs(start) << " ms, " << bvh.tree.nodes.size() << " cvorova" << std::endl;
+
+    const int rays = 200000;
+    std::vector<glm::vec3> origins(rays), dirs(rays);
+    uint32_t seed = 12345;
+    auto rnd = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) * (1.0f / 16777216.0f) * 2.0f - 1.0f; };
+    for (int i = 0; i < rays; ++i) {
+        origins[i] = glm::normalize(glm::vec3(rnd(), rnd(), rnd())) * 2.0f;
+        dirs[i] = glm::normalize(glm::vec3(rnd(), rnd(), rnd()) * 0.4f - origins[i]);
+    }
+
+    start = BenchClock::now();
+    int hits = 0;
+    for (int i = 0; i < rays; ++i) {
+        RayHit hit;
+        if (intersectRay(bvh, origins[i], dirs[i], hit)) ++hits;
+    }
+    double ms = elapsedMs(start);
+    std::cout << "bvh zraci: " << rays / ms / 1000.0 << " Mzraka/s (" << hits << "/" << rays << " pogodaka)" << std::endl;
+
+    const int capsules = 50000;
+    start = BenchClock::now();
+    hits = 0;
+    for (int i = 0; i < capsules; ++i) {
+        glm::vec3 a = origins[i] * 0.3f;
+        if (overlapsCapsule(bvh, a, a + dirs[i] * 0.4f, 0.06f)) ++hits;
+    }
+    ms = elapsedMs(start);
+    std::cout << "bvh kapsule: " << capsules / ms << " upita/ms (" << hits << "/" << capsules << " dodira)" << std::endl;
+}
+
+void benchMath() {
+    const int instances = 10000, repeats = 200;
+    TRSBatch trs;
+    std::vector<glm::vec3> axes(instances);
+    std::vector<float> angles(instances);
+    std::vector<AABB> local(instances);
+    for (int i = 0; i < instances; ++i) {
+        axes[i] = glm::normalize(glm::vec3(std::sin(i * 0.7f), 1.0f, std::cos(i * 1.3f)));
+        angles[i] = i * 0.01f;
+        glm::vec3 pos(std::sin(i * 0.37f) * 2.0f, 0.5f + (i % 13) * 0.1f, std::cos(i * 0.53f) * 2.0f);
+        glm::vec3 scale(0.2f + (i % 5) * 0.1f, 0.3f + (i % 3) * 0.2f, 0.25f);
+        float s = std::sin(angles[i] * 0.5f);
+        addTRS(trs, pos, glm::vec4(axes[i] * s, std::cos(angles[i] * 0.5f)), scale);
+        local[i].min = glm::vec3(-0.5f, -0.3f - (i % 7) * 0.05f, -0.5f);
+        local[i].max = glm::vec3(0.5f, 0.4f, 0.5f + (i % 4) * 0.1f);
+    }
+
+    std::vector<glm::mat4> perObject(instances), batched(instances);
+    std::vector<glm::mat3> normalsGlm(instances), normalsBatch(instances);
+    BoundsBatch boundsGlm, boundsBatch;
+
+    BenchClock::time_point start = BenchClock::now();
+    volatile float sink = 0.0f;
+    for (int r = 0; r < repeats; ++r) {
+        clearBounds(boundsGlm);
+        for (int i = 0; i < instances; ++i) {
+            glm::vec3 pos(trs.px[i], trs.py[i], trs.pz[i]);
+            perObject[i] = glm::translate(glm::mat4(1.0f), pos) * glm::rotate(glm::mat4(1.0f), angles[i], axes[i])
+                * glm::scale(glm::mat4(1.0f), glm::vec3(trs.sx[i], trs.sy[i], trs.sz[i]));
+            addBounds(boundsGlm, transformAABB(local[i], perObject[i]));
+            normalsGlm[i] = glm::transpose(glm::inverse(glm::mat3(perObject[i])));
+        }
+        sink += normalsGlm[r][0][0];
+    }
+    double glmMs = elapsedMs(start) / repeats;
+
+    start = BenchClock::now();
+    for (int r = 0; r < repeats; ++r) {
+        clearBounds(boundsBatch);
+        composeTRS(trs, batched.data());
+        transformAABBs(batched.data(), local.data(), instances, boundsBatch);
+        computeNormalMatrices(batched.data(), normalsBatch.data(), instances);
+        sink += normalsBatch[r][0][0];
+    }
+    double batchMs = elapsedMs(start) / repeats;
+
+    float maxError = 0.0f;
+    for (int i = 0; i < instances; ++i) {
+        for (int c = 0; c < 4; ++c)
+            for (int k = 0; k < 4; ++k) maxError = std::max(maxError, std::fabs(perObject[i][c][k] - batched[i][c][k]));
+        for (int c = 0; c < 3; ++c)
+            for (int k = 0; k < 3; ++k) maxError = std::max(maxError, std::fabs(normalsGlm[i][c][k] - normalsBatch[i][c][k]));
+        maxError = std::max(maxError, std::fabs(boundsGlm.centerX[i] - boundsBatch.centerX[i]));
+        maxError = std::max(maxError, std::fabs(boundsGlm.extentY[i] - boundsBatch.extentY[i]));
+    }
+    std::cout << "matrice " << instances << " instanci: glm " << glmMs << " ms, batch " << batchMs << " ms (x" << glmMs / batchMs
+        << "), " << (cpuHasAVX2() ? "AVX2" : "SSE/skalar") << ", max greska " << maxError << std::endl;
+}
+
+void benchLights() {
+    const int repeats = 200;
+    ClusteredLights cl;
+    for (int i = 0; i < kMaxLights; ++i) {
+        Light l;
+        l.position = glm::vec3(std::sin(i * 0.71f) * 8.0f, 0.2f + (i % 9) * 0.5f, std::cos(i * 0.37f) * 8.0f);
+        l.radius = 1.0f + (i % 5) * 0.75f;
+        addLight(cl, l);
+    }
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 10.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0, 1, 0));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+    ThreadPool single, pool;
+    startThreadPool(pool);
+    double ms[2];
+    ThreadPool* pools[2] = { &single, &pool };
+    for (int p = 0; p < 2; ++p) {
+        assignLights(cl, *pools[p], view, projection, 0.1f, 100.0f);
+        BenchClock::time_point start = BenchClock::now();
+        for (int r = 0; r < repeats; ++r) assignLights(cl, *pools[p], view, projection, 0.1f, 100.0f);
+        ms[p] = elapsedMs(start) / repeats;
+    }
+    size_t threadCount = pool.workers.size() + 1;
+    stopThreadPool(pool);
+    std::cout << "klasteri " << kMaxLights << " svetala, " << kClusterCount << " klastera: 1 nit " << ms[0] << " ms, "
+        << threadCount << " niti " << ms[1] << " ms, " << cl.stats.references << " referenci, najvise " << cl.stats.maxPerCluster << std::endl;
+}
+
+// CPU side of both texture load paths: stb_image decoding (the GPU then builds mips)
+// against reading the cached compressed chain.
+void benchTextures() {
+    const int repeats = 10;
+    const char* files[] = { "Resources/img.png", "Resources/Toy2/11706_toy_dog_diffuse_v2.jpg" };
+    const char* temp = "bench_texture.ktx";
+    for (const char* file : files) {
+        DecodedImage image;
+        BenchClock::time_point start = BenchClock::now();
+        for (int r = 0; r < repeats; ++r)
+            if (!decodeImage(file, image)) return;
+        double decodeMs = elapsedMs(start) / repeats;
+
+        CompressedImage compressed;
+        start = BenchClock::now();
+        compressImage(image, compressed);
+        double encodeMs = elapsedMs(start);
+        writeKTX(temp, compressed);
+        start = BenchClock::now();
+        for (int r = 0; r < repeats; ++r) readKTX(temp, compressed);
+        double readMs = elapsedMs(start) / repeats;
+        std::remove(temp);
+
+        size_t bytes = 0, rgbaBytes = 0;
+        int w = image.width, h = image.height;
+        for (const std::vector<unsigned char>& level : compressed.levels) {
+            bytes += level.size();
+            rgbaBytes += (size_t)w * h * 4;
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+        std::cout << "teksture " << file << " " << image.width << "x" << image.height << ": stb_image " << decodeMs << " ms, KTX " << readMs << " ms (x"
+            << decodeMs / readMs << "), " << (compressed.format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? "BC1" : "BC3") << " kodiranje " << encodeMs << " ms, "
+            << bytes / 1024 << " KB umesto " << rgbaBytes / 1024 << " KB" << std::endl;
+    }
+}
+
+void benchMips() {
+    const int size = 2048, repeats = 5;
+    DecodedImage image;
+    image.width = image.height = size;
+    image.channels = 4;
+    image.pixels.resize((size_t)size * size * 4);
+    for (size_t i = 0; i < image.pixels.size(); ++i) image.pixels[i] = (unsigned char)((i * 2654435761u) >> 13);
+    const double megapixels = (double)size * size / 1e6;
+
+    // Filter kernel alone, over a chain whose levels are allocated up front.
+    std::vector<LinearImage> chain(1);
+    chain[0].width = chain[0].height = size;
+    chain[0].pixels.resize((size_t)size * size * 4);
+    for (size_t i = 0; i < chain[0].pixels.size(); ++i) chain[0].pixels[i] = image.pixels[i] / 255.0f;
+    while (chain.back().width > 1 || chain.back().height > 1) {
+        LinearImage next;
+        halveLinearImage(chain.back(), next);
+        chain.push_back(next);
+    }
+    const LinearImage& source = chain[0];
+    double kernelMs[2];
+    float maxError = 0.0f;
+    for (int simd = 0; simd < 2; ++simd) {
+        BenchClock::time_point start = BenchClock::now();
+        for (int r = 0; r < repeats; ++r) {
+            for (size_t l = 1; l < chain.size(); ++l) {
+                if (simd) downsampleRows(chain[l - 1], chain[l], 0, chain[l].height);
+                else downsampleRowsScalar(chain[l - 1], chain[l], 0, chain[l].height);
+            }
+        }
+        kernelMs[simd] = elapsedMs(start) / repeats;
+    }
+    LinearImage half, halfScalar;
+    halveLinearImage(source, half);
+    halveLinearImage(source, halfScalar);
+    downsampleRows(source, half, 0, half.height);
+    downsampleRowsScalar(source, halfScalar, 0, halfScalar.height);
+    for (size_t i = 0; i < half.pixels.size(); ++i) maxError = std::max(maxError, std::fabs(half.pixels[i] - halfScalar.pixels[i]));
+
+    // Whole chain with gamma conversion, on one thread and on the pool.
+    ThreadPool single, pool;
+    startThreadPool(pool);
+    double chainMs[2];
+    ThreadPool* pools[2] = { &single, &pool };
+    std::vector<MipLevel> levels;
+    for (int p = 0; p < 2; ++p) {
+        BenchClock::time_point start = BenchClock::now();
+        for (int r = 0; r < repeats; ++r) buildMipChain(image, levels, pools[p]);
+        chainMs[p] = elapsedMs(start) / repeats;
+    }
+    size_t threadCount = pool.workers.size() + 1;
+    stopThreadPool(pool);
+    std::cout << "mipovi " << size << "x" << size << " (" << levels.size() << " nivoa): filter skalar " << megapixels / kernelMs[0] * 1000.0 << " MP/s, "
+        << (cpuHasAVX2() ? "AVX2 " : "SSE ") << megapixels / kernelMs[1] * 1000.0 << " MP/s, max greska " << maxError << std::endl;
+    std::cout << "mipovi ceo lanac sa gamom: 1 nit " << megapixels / chainMs[0] * 1000.0 << " MP/s (" << chainMs[0] << " ms), " << threadCount << " niti "
+        << megapixels / chainMs[1] * 1000.0 << " MP/s (" << chainMs[1] << " ms)" << std::endl;
+}
+
+struct Benchmark {
+    const char* name;
+    void (*run)();
+};
+
+const Benchmark benchmarks[] = {
+    { "physics", benchPhysics },
+    { "rays", benchRays },
+    { "math", benchMath },
+    { "lights", benchLights },
+    { "textures", benchTextures },
+    { "mips", benchMips }
+};
+
+}
+
+int runBenchmarks(int argc, char** argv) {
+    int ran = 0;
+    for (const Benchmark& b : benchmarks) {
+        bool selected = argc == 0;
+        for (int i = 0; i < argc && !selected; ++i) selected = std::strcmp(argv[i], b.name) == 0;
+        if (!selected) continue;
+        b.run();
+        ++ran;
+    }
+    if (ran == 0) {
+        std::cout << "Nepoznat benchmark. Dostupni:";
+        for (const Benchmark& b : benchmarks) std::cout << " " << b.name;
+        std::cout << std::endl;
+        return 1;
+    }
+    return 0;
+}
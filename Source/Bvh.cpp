@@ -0,0 +1,412 @@
+#include "../Header/Bvh.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+const int kBins = 12;
+const int kMaxLeafSize = 16;
+const int kStackSize = 64;
+
+float surfaceArea(const AABB& box) {
+    glm::vec3 e = box.max - box.min;
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+AABB emptyBox() {
+    AABB box;
+    box.min = glm::vec3(1e30f);
+    box.max = glm::vec3(-1e30f);
+    return box;
+}
+
+void grow(AABB& box, const AABB& other) {
+    box.min = glm::min(box.min, other.min);
+    box.max = glm::max(box.max, other.max);
+}
+
+void setNodeBounds(BvhNode& node, const AABB& box) {
+    node.minX = box.min.x; node.minY = box.min.y; node.minZ = box.min.z;
+    node.maxX = box.max.x; node.maxY = box.max.y; node.maxZ = box.max.z;
+}
+
+AABB nodeBounds(const BvhNode& node) {
+    AABB box;
+    box.min = glm::vec3(node.minX, node.minY, node.minZ);
+    box.max = glm::vec3(node.maxX, node.maxY, node.maxZ);
+    return box;
+}
+
+// Slab test; returns the entry distance or 1e30 on a miss.
+float rayNode(const BvhNode& node, glm::vec3 origin, glm::vec3 invDir, float tMax) {
+    float tx1 = (node.minX - origin.x) * invDir.x, tx2 = (node.maxX - origin.x) * invDir.x;
+    float tmin = std::min(tx1, tx2), tmax = std::max(tx1, tx2);
+    float ty1 = (node.minY - origin.y) * invDir.y, ty2 = (node.maxY - origin.y) * invDir.y;
+    tmin = std::max(tmin, std::min(ty1, ty2)); tmax = std::min(tmax, std::max(ty1, ty2));
+    float tz1 = (node.minZ - origin.z) * invDir.z, tz2 = (node.maxZ - origin.z) * invDir.z;
+    tmin = std::max(tmin, std::min(tz1, tz2)); tmax = std::min(tmax, std::max(tz1, tz2));
+    return (tmax >= tmin && tmin < tMax && tmax > 0.0f) ? tmin : 1e30f;
+}
+
+bool rayTriangle(glm::vec3 origin, glm::vec3 dir, const glm::vec3* tri, float& t) {
+    glm::vec3 e1 = tri[1] - tri[0];
+    glm::vec3 e2 = tri[2] - tri[0];
+    glm::vec3 p = glm::cross(dir, e2);
+    float det = glm::dot(e1, p);
+    if (std::fabs(det) < 1e-12f) return false;
+    float invDet = 1.0f / det;
+    glm::vec3 s = origin - tri[0];
+    float u = glm::dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f) return false;
+    glm::vec3 q = glm::cross(s, e1);
+    float v = glm::dot(dir, q) * invDet;
+    if (v < 0.0f || u + v > 1.0f) return false;
+    t = glm::dot(e2, q) * invDet;
+    return t > 0.0f;
+}
+
+glm::vec3 closestPointOnTriangle(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) return a;
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) return b;
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) return c;
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    float denom = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+float segmentSegmentDistance2(glm::vec3 p1, glm::vec3 q1, glm::vec3 p2, glm::vec3 q2) {
+    glm::vec3 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+    float a = glm::dot(d1, d1), e = glm::dot(d2, d2), f = glm::dot(d2, r);
+    float s = 0.0f, t = 0.0f;
+    if (a <= 1e-12f && e <= 1e-12f) return glm::dot(r, r);
+    if (a <= 1e-12f) {
+        t = glm::clamp(f / e, 0.0f, 1.0f);
+    } else {
+        float c = glm::dot(d1, r);
+        if (e <= 1e-12f) {
+            s = glm::clamp(-c / a, 0.0f, 1.0f);
+        } else {
+            float b = glm::dot(d1, d2);
+            float denom = a * e - b * b;
+            s = denom != 0.0f ? glm::clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+            t = (b * s + f) / e;
+            if (t < 0.0f) { t = 0.0f; s = glm::clamp(-c / a, 0.0f, 1.0f); }
+            else if (t > 1.0f) { t = 1.0f; s = glm::clamp((b - c) / a, 0.0f, 1.0f); }
+        }
+    }
+    glm::vec3 diff = (p1 + d1 * s) - (p2 + d2 * t);
+    return glm::dot(diff, diff);
+}
+
+bool segmentNearTriangle(glm::vec3 a, glm::vec3 b, const glm::vec3* tri, float radius2) {
+    float t;
+    glm::vec3 dir = b - a;
+    if (rayTriangle(a, dir, tri, t) && t <= 1.0f) return true;
+    glm::vec3 pa = closestPointOnTriangle(a, tri[0], tri[1], tri[2]) - a;
+    if (glm::dot(pa, pa) <= radius2) return true;
+    glm::vec3 pb = closestPointOnTriangle(b, tri[0], tri[1], tri[2]) - b;
+    if (glm::dot(pb, pb) <= radius2) return true;
+    for (int e = 0; e < 3; ++e)
+        if (segmentSegmentDistance2(a, b, tri[e], tri[(e + 1) % 3]) <= radius2) return true;
+    return false;
+}
+
+// Conservative: the node box grown by the radius against the segment.
+bool segmentNearNode(const BvhNode& node, glm::vec3 a, glm::vec3 b, float radius) {
+    glm::vec3 lo = glm::vec3(node.minX, node.minY, node.minZ) - glm::vec3(radius);
+    glm::vec3 hi = glm::vec3(node.maxX, node.maxY, node.maxZ) + glm::vec3(radius);
+    glm::vec3 d = b - a;
+    float t0 = 0.0f, t1 = 1.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (std::fabs(d[axis]) < 1e-12f) {
+            if (a[axis] < lo[axis] || a[axis] > hi[axis]) return false;
+            continue;
+        }
+        float inv = 1.0f / d[axis];
+        float ta = (lo[axis] - a[axis]) * inv, tb = (hi[axis] - a[axis]) * inv;
+        t0 = std::max(t0, std::min(ta, tb));
+        t1 = std::min(t1, std::max(ta, tb));
+        if (t0 > t1) return false;
+    }
+    return true;
+}
+
+// Depth-first traversal keeps at most one pending sibling per level plus the node being
+// entered. Trees deeper than the fixed array, which the SAH build allows for degenerate
+// input, get a heap stack instead of losing nodes.
+struct TraversalStack {
+    uint32_t local[kStackSize];
+    std::vector<uint32_t> heap;
+    uint32_t* data = local;
+    int top = 0;
+
+    explicit TraversalStack(const Bvh& tree) {
+        if (tree.depth + 2 > kStackSize) {
+            heap.resize(tree.depth + 2);
+            data = heap.data();
+        }
+    }
+    void push(uint32_t node) { data[top++] = node; }
+    uint32_t pop() { return data[--top]; }
+    bool empty() const { return top == 0; }
+};
+
+glm::vec3 safeInverse(glm::vec3 d) {
+    return glm::vec3(d.x != 0.0f ? 1.0f / d.x : 1e30f, d.y != 0.0f ? 1.0f / d.y : 1e30f, d.z != 0.0f ? 1.0f / d.z : 1e30f);
+}
+
+}
+
+void buildBvh(Bvh& bvh, const std::vector<AABB>& bounds, int maxLeafSize) {
+    const uint32_t n = (uint32_t)bounds.size();
+    bvh.nodes.clear();
+    bvh.depth = 0;
+    bvh.primitives.resize(n);
+    for (uint32_t i = 0; i < n; ++i) bvh.primitives[i] = i;
+    if (n == 0) return;
+
+    std::vector<glm::vec3> centroids(n);
+    for (uint32_t i = 0; i < n; ++i) centroids[i] = (bounds[i].min + bounds[i].max) * 0.5f;
+
+    bvh.nodes.reserve(2 * n + 1);
+    bvh.nodes.resize(2);
+    bvh.nodes[0].leftOrFirst = 0;
+    bvh.nodes[0].count = n;
+
+    // Node index and its depth.
+    std::vector<std::pair<uint32_t, int>> stack;
+    stack.push_back(std::make_pair(0u, 0));
+    AABB binBounds[kBins];
+    uint32_t binCount[kBins];
+    float rightArea[kBins];
+    uint32_t rightCount[kBins];
+
+    while (!stack.empty()) {
+        const uint32_t nodeIndex = stack.back().first;
+        const int depth = stack.back().second;
+        stack.pop_back();
+        bvh.depth = std::max(bvh.depth, depth);
+        BvhNode& node = bvh.nodes[nodeIndex];
+        const uint32_t first = node.leftOrFirst, count = node.count;
+
+        AABB box = emptyBox(), centroidBox = emptyBox();
+        for (uint32_t i = first; i < first + count; ++i) {
+            uint32_t p = bvh.primitives[i];
+            grow(box, bounds[p]);
+            centroidBox.min = glm::min(centroidBox.min, centroids[p]);
+            centroidBox.max = glm::max(centroidBox.max, centroids[p]);
+        }
+        setNodeBounds(node, box);
+        if ((int)count <= maxLeafSize) continue;
+
+        int bestAxis = -1, bestSplit = 0;
+        float bestCost = 1e30f;
+        for (int axis = 0; axis < 3; ++axis) {
+            float lo = centroidBox.min[axis], extent = centroidBox.max[axis] - lo;
+            if (extent <= 1e-9f) continue;
+            float scale = kBins / extent;
+            for (int b = 0; b < kBins; ++b) { binBounds[b] = emptyBox(); binCount[b] = 0; }
+            for (uint32_t i = first; i < first + count; ++i) {
+                uint32_t p = bvh.primitives[i];
+                int b = std::min(kBins - 1, (int)((centroids[p][axis] - lo) * scale));
+                binCount[b]++;
+                grow(binBounds[b], bounds[p]);
+            }
+            AABB acc = emptyBox();
+            uint32_t accCount = 0;
+            for (int b = kBins - 1; b > 0; --b) {
+                accCount += binCount[b];
+                if (binCount[b]) grow(acc, binBounds[b]);
+                rightArea[b] = accCount ? surfaceArea(acc) : 0.0f;
+                rightCount[b] = accCount;
+            }
+            acc = emptyBox();
+            accCount = 0;
+            for (int b = 0; b < kBins - 1; ++b) {
+                accCount += binCount[b];
+                if (binCount[b]) grow(acc, binBounds[b]);
+                if (accCount == 0 || rightCount[b + 1] == 0) continue;
+                float cost = surfaceArea(acc) * accCount + rightArea[b + 1] * rightCount[b + 1];
+                if (cost < bestCost) { bestCost = cost; bestAxis = axis; bestSplit = b; }
+            }
+        }
+
+        float leafCost = surfaceArea(box) * count;
+        if (bestAxis < 0 || (bestCost >= leafCost && (int)count <= kMaxLeafSize)) continue;
+
+        float lo = centroidBox.min[bestAxis];
+        float scale = kBins / (centroidBox.max[bestAxis] - lo);
+        uint32_t* begin = bvh.primitives.data() + first;
+        uint32_t* mid = std::partition(begin, begin + count, [&](uint32_t p) {
+            return std::min(kBins - 1, (int)((centroids[p][bestAxis] - lo) * scale)) <= bestSplit;
+        });
+        uint32_t leftCount = (uint32_t)(mid - begin);
+        if (leftCount == 0 || leftCount == count) continue;
+
+        uint32_t left = (uint32_t)bvh.nodes.size();
+        bvh.nodes.resize(left + 2);
+        BvhNode& parent = bvh.nodes[nodeIndex];
+        bvh.nodes[left].leftOrFirst = first;
+        bvh.nodes[left].count = leftCount;
+        bvh.nodes[left + 1].leftOrFirst = first + leftCount;
+        bvh.nodes[left + 1].count = count - leftCount;
+        parent.leftOrFirst = left;
+        parent.count = 0;
+        stack.push_back(std::make_pair(left + 1, depth + 1));
+        stack.push_back(std::make_pair(left, depth + 1));
+    }
+}
+
+void buildMeshBvh(MeshBvh& mesh, const std::vector<glm::vec3>& triangles) {
+    const size_t triCount = triangles.size() / 3;
+    std::vector<AABB> bounds(triCount);
+    for (size_t t = 0; t < triCount; ++t) {
+        bounds[t].min = glm::min(triangles[t * 3], glm::min(triangles[t * 3 + 1], triangles[t * 3 + 2]));
+        bounds[t].max = glm::max(triangles[t * 3], glm::max(triangles[t * 3 + 1], triangles[t * 3 + 2]));
+    }
+    buildBvh(mesh.tree, bounds, 4);
+
+    // Store triangles in leaf order so a leaf reads one contiguous run.
+    mesh.triangles.resize(triCount * 3);
+    for (size_t i = 0; i < triCount; ++i) {
+        uint32_t t = mesh.tree.primitives[i];
+        mesh.triangles[i * 3] = triangles[t * 3];
+        mesh.triangles[i * 3 + 1] = triangles[t * 3 + 1];
+        mesh.triangles[i * 3 + 2] = triangles[t * 3 + 2];
+    }
+}
+
+void buildSceneBvh(SceneBvh& scene, const std::vector<BvhInstance>& instances) {
+    scene.instances = instances;
+    std::vector<AABB> bounds;
+    bounds.reserve(instances.size());
+    for (const BvhInstance& inst : instances) {
+        AABB local = inst.mesh && !inst.mesh->tree.nodes.empty() ? nodeBounds(inst.mesh->tree.nodes[0]) : AABB();
+        AABB world;
+        world.min = glm::min(local.min * inst.scale, local.max * inst.scale) + inst.position;
+        world.max = glm::max(local.min * inst.scale, local.max * inst.scale) + inst.position;
+        bounds.push_back(world);
+    }
+    buildBvh(scene.tree, bounds, 1);
+}
+
+bool intersectRay(const MeshBvh& mesh, glm::vec3 origin, glm::vec3 dir, RayHit& hit) {
+    if (mesh.tree.nodes.empty()) return false;
+    const glm::vec3 invDir = safeInverse(dir);
+    const BvhNode* nodes = mesh.tree.nodes.data();
+    TraversalStack stack(mesh.tree);
+    bool found = false;
+    if (rayNode(nodes[0], origin, invDir, hit.t) >= 1e30f) return false;
+    stack.push(0);
+
+    while (!stack.empty()) {
+        const BvhNode& node = nodes[stack.pop()];
+        if (node.count > 0) {
+            for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+                float t;
+                if (rayTriangle(origin, dir, &mesh.triangles[i * 3], t) && t < hit.t) {
+                    hit.t = t;
+                    hit.primitive = mesh.tree.primitives[i];
+                    found = true;
+                }
+            }
+            continue;
+        }
+        uint32_t near = node.leftOrFirst, far = node.leftOrFirst + 1;
+        float tNear = rayNode(nodes[near], origin, invDir, hit.t);
+        float tFar = rayNode(nodes[far], origin, invDir, hit.t);
+        if (tFar < tNear) { std::swap(near, far); std::swap(tNear, tFar); }
+        if (tFar < 1e30f) stack.push(far);
+        if (tNear < 1e30f) stack.push(near);
+    }
+    return found;
+}
+
+bool intersectRay(const SceneBvh& scene, glm::vec3 origin, glm::vec3 dir, RayHit& hit) {
+    if (scene.tree.nodes.empty()) return false;
+    const glm::vec3 invDir = safeInverse(dir);
+    TraversalStack stack(scene.tree);
+    bool found = false;
+    stack.push(0);
+
+    while (!stack.empty()) {
+        const BvhNode& node = scene.tree.nodes[stack.pop()];
+        if (rayNode(node, origin, invDir, hit.t) >= 1e30f) continue;
+        if (node.count > 0) {
+            for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+                const BvhInstance& inst = scene.instances[scene.tree.primitives[i]];
+                if (!inst.mesh) continue;
+                // Ray parameters are unchanged by the instance's translation and scale.
+                if (intersectRay(*inst.mesh, (origin - inst.position) / inst.scale, dir / inst.scale, hit)) {
+                    hit.instance = inst.id;
+                    found = true;
+                }
+            }
+            continue;
+        }
+        stack.push(node.leftOrFirst + 1);
+        stack.push(node.leftOrFirst);
+    }
+    return found;
+}
+
+bool overlapsCapsule(const MeshBvh& mesh, glm::vec3 a, glm::vec3 b, float radius) {
+    if (mesh.tree.nodes.empty()) return false;
+    const float radius2 = radius * radius;
+    TraversalStack stack(mesh.tree);
+    stack.push(0);
+
+    while (!stack.empty()) {
+        const BvhNode& node = mesh.tree.nodes[stack.pop()];
+        if (!segmentNearNode(node, a, b, radius)) continue;
+        if (node.count > 0) {
+            for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+                if (segmentNearTriangle(a, b, &mesh.triangles[i * 3], radius2)) return true;
+            continue;
+        }
+        stack.push(node.leftOrFirst + 1);
+        stack.push(node.leftOrFirst);
+    }
+    return false;
+}
+
+int overlapsCapsule(const SceneBvh& scene, glm::vec3 a, glm::vec3 b, float radius, std::vector<uint32_t>& ids) {
+    if (scene.tree.nodes.empty()) return 0;
+    int hits = 0;
+    TraversalStack stack(scene.tree);
+    stack.push(0);
+
+    while (!stack.empty()) {
+        const BvhNode& node = scene.tree.nodes[stack.pop()];
+        if (!segmentNearNode(node, a, b, radius)) continue;
+        if (node.count > 0) {
+            for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+                const BvhInstance& inst = scene.instances[scene.tree.primitives[i]];
+                if (!inst.mesh) continue;
+                // Non-uniform scale turns the capsule into an ellipsoid sweep; the smallest
+                // axis gives a radius that never misses a contact.
+                float minScale = std::min(inst.scale.x, std::min(inst.scale.y, inst.scale.z));
+                if (overlapsCapsule(*inst.mesh, (a - inst.position) / inst.scale, (b - inst.position) / inst.scale, radius / minScale)) {
+                    ids.push_back(inst.id);
+                    ++hits;
+                }
+            }
+            continue;
+        }
+        stack.push(node.leftOrFirst + 1);
+        stack.push(node.leftOrFirst);
+    }
+    return hits;
+}
@@ -0,0 +1,159 @@
+#include "../Header/Culling.h"
+#include "../Header/Simd.h"
+#include <cmath>
+
+namespace {
+    const size_t kBatchWidth = 8;
+
+#if !KANDZA_SIMD_X86
+    void cullScalar(const Frustum& frustum, BoundsBatch& b, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            bool inside = true;
+            for (int p = 0; p < 6 && inside; ++p) {
+                const glm::vec4& pl = frustum.planes[p];
+                float d = pl.x * b.centerX[i] + pl.y * b.centerY[i] + pl.z * b.centerZ[i] + pl.w;
+                float r = std::fabs(pl.x) * b.extentX[i] + std::fabs(pl.y) * b.extentY[i] + std::fabs(pl.z) * b.extentZ[i];
+                inside = d + r >= 0.0f;
+            }
+            b.visible[i] = inside ? 1 : 0;
+        }
+    }
+#else
+    void cullSSE(const Frustum& frustum, BoundsBatch& b, size_t padded) {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        for (size_t i = 0; i < padded; i += 4) {
+            __m128 cx = _mm_loadu_ps(&b.centerX[i]), cy = _mm_loadu_ps(&b.centerY[i]), cz = _mm_loadu_ps(&b.centerZ[i]);
+            __m128 ex = _mm_loadu_ps(&b.extentX[i]), ey = _mm_loadu_ps(&b.extentY[i]), ez = _mm_loadu_ps(&b.extentZ[i]);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                const glm::vec4& pl = frustum.planes[p];
+                __m128 nx = _mm_set1_ps(pl.x), ny = _mm_set1_ps(pl.y), nz = _mm_set1_ps(pl.z);
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(pl.w)));
+                __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), ex), _mm_mul_ps(_mm_andnot_ps(signMask, ny), ey)),
+                    _mm_mul_ps(_mm_andnot_ps(signMask, nz), ez));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+            }
+            int mask = _mm_movemask_ps(inside);
+            for (int k = 0; k < 4; ++k) b.visible[i + k] = (uint8_t)((mask >> k) & 1);
+        }
+    }
+
+    KANDZA_TARGET_AVX2
+    void cullAVX2(const Frustum& frustum, BoundsBatch& b, size_t padded) {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        for (size_t i = 0; i < padded; i += 8) {
+            __m256 cx = _mm256_loadu_ps(&b.centerX[i]), cy = _mm256_loadu_ps(&b.centerY[i]), cz = _mm256_loadu_ps(&b.centerZ[i]);
+            __m256 ex = _mm256_loadu_ps(&b.extentX[i]), ey = _mm256_loadu_ps(&b.extentY[i]), ez = _mm256_loadu_ps(&b.extentZ[i]);
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                const glm::vec4& pl = frustum.planes[p];
+                __m256 nx = _mm256_set1_ps(pl.x), ny = _mm256_set1_ps(pl.y), nz = _mm256_set1_ps(pl.z);
+                __m256 d = _mm256_fmadd_ps(nx, cx, _mm256_fmadd_ps(ny, cy, _mm256_fmadd_ps(nz, cz, _mm256_set1_ps(pl.w))));
+                __m256 r = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, nx), ex,
+                    _mm256_fmadd_ps(_mm256_andnot_ps(signMask, ny), ey, _mm256_mul_ps(_mm256_andnot_ps(signMask, nz), ez)));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+            int mask = _mm256_movemask_ps(inside);
+            for (int k = 0; k < 8; ++k) b.visible[i + k] = (uint8_t)((mask >> k) & 1);
+        }
+    }
+#endif
+}
+
+Frustum extractFrustum(const glm::mat4& m) {
+    Frustum f;
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+    f.planes[0] = row3 + row0;
+    f.planes[1] = row3 - row0;
+    f.planes[2] = row3 + row1;
+    f.planes[3] = row3 - row1;
+    f.planes[4] = row3 + row2;
+    f.planes[5] = row3 - row2;
+    for (auto& p : f.planes) {
+        float len = glm::length(glm::vec3(p));
+        if (len > 0.0f) p = p / len;
+    }
+    return f;
+}
+
+AABB transformAABB(const AABB& local, const glm::mat4& model) {
+    glm::vec3 c = (local.min + local.max) * 0.5f;
+    glm::vec3 e = (local.max - local.min) * 0.5f;
+    glm::vec3 wc = glm::vec3(model * glm::vec4(c, 1.0f));
+    glm::vec3 we;
+    for (int r = 0; r < 3; ++r)
+        we[r] = std::fabs(model[0][r]) * e.x + std::fabs(model[1][r]) * e.y + std::fabs(model[2][r]) * e.z;
+    AABB out;
+    out.min = wc - we;
+    out.max = wc + we;
+    return out;
+}
+
+BoundingSphere boundingSphere(const AABB& box) {
+    BoundingSphere s;
+    s.center = (box.min + box.max) * 0.5f;
+    s.radius = glm::length(box.max - box.min) * 0.5f;
+    return s;
+}
+
+bool isVisible(const Frustum& frustum, const AABB& box) {
+    glm::vec3 c = (box.min + box.max) * 0.5f;
+    glm::vec3 e = (box.max - box.min) * 0.5f;
+    for (const auto& p : frustum.planes) {
+        float d = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+        float r = std::fabs(p.x) * e.x + std::fabs(p.y) * e.y + std::fabs(p.z) * e.z;
+        if (d + r < 0.0f) return false;
+    }
+    return true;
+}
+
+bool isVisible(const Frustum& frustum, const BoundingSphere& sphere) {
+    for (const auto& p : frustum.planes) {
+        if (glm::dot(glm::vec3(p), sphere.center) + p.w < -sphere.radius) return false;
+    }
+    return true;
+}
+
+void clearBounds(BoundsBatch& batch) {
+    batch.centerX.clear(); batch.centerY.clear(); batch.centerZ.clear();
+    batch.extentX.clear(); batch.extentY.clear(); batch.extentZ.clear();
+    batch.visible.clear();
+    batch.count = 0;
+}
+
+void addBounds(BoundsBatch& batch, const AABB& worldBox) {
+    if (batch.centerX.size() != batch.count) {
+        batch.centerX.resize(batch.count); batch.centerY.resize(batch.count); batch.centerZ.resize(batch.count);
+        batch.extentX.resize(batch.count); batch.extentY.resize(batch.count); batch.extentZ.resize(batch.count);
+        batch.visible.resize(batch.count);
+    }
+    glm::vec3 c = (worldBox.min + worldBox.max) * 0.5f;
+    glm::vec3 e = (worldBox.max - worldBox.min) * 0.5f;
+    batch.centerX.push_back(c.x); batch.centerY.push_back(c.y); batch.centerZ.push_back(c.z);
+    batch.extentX.push_back(e.x); batch.extentY.push_back(e.y); batch.extentZ.push_back(e.z);
+    batch.visible.push_back(1);
+    batch.count++;
+}
+
+int cullBounds(const Frustum& frustum, BoundsBatch& b) {
+    const size_t n = b.count;
+    if (n == 0) return 0;
+    const size_t padded = (n + kBatchWidth - 1) / kBatchWidth * kBatchWidth;
+    b.centerX.resize(padded, 0.0f); b.centerY.resize(padded, 0.0f); b.centerZ.resize(padded, 0.0f);
+    b.extentX.resize(padded, 0.0f); b.extentY.resize(padded, 0.0f); b.extentZ.resize(padded, 0.0f);
+    b.visible.resize(padded, 0);
+
+#if KANDZA_SIMD_X86
+    if (cpuHasAVX2()) cullAVX2(frustum, b, padded);
+    else cullSSE(frustum, b, padded);
+#else
+    cullScalar(frustum, b, n);
+#endif
+
+    int culled = 0;
+    for (size_t i = 0; i < n; ++i) culled += b.visible[i] ? 0 : 1;
+    return culled;
+}
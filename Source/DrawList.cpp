@@ -0,0 +1,177 @@
+#include "../Header/DrawList.h"
+#include "../Header/MathBatch.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+
+namespace {
+
+void appendCommands(DrawList& list, const Frustum& frustum, glm::vec3 eye, CullStats& stats, bool textured) {
+    for (size_t i = 0; i < list.items.size(); ++i) {
+        const DrawItem& item = list.items[i];
+        if (item.useTex != textured || !list.bounds.visible[i]) continue;
+        if (!item.meshlets) {
+            DrawElementsIndirectCommand cmd = { item.mesh.indexCount, 1, item.mesh.firstIndex, (int32_t)item.mesh.firstVertex, (uint32_t)i };
+            list.commands.push_back(cmd);
+            continue;
+        }
+        size_t first = list.commands.size();
+        int visible = cullMeshlets(*item.meshlets, list.models[i], frustum, eye, list.commands);
+        stats.clusters += (int)item.meshlets->meshlets.size();
+        stats.clustersCulled += (int)item.meshlets->meshlets.size() - visible;
+        for (size_t c = first; c < list.commands.size(); ++c) {
+            list.commands[c].firstIndex += item.mesh.firstIndex;
+            list.commands[c].baseVertex = (int32_t)item.mesh.firstVertex;
+            list.commands[c].baseInstance = (uint32_t)i;
+        }
+        if (visible == 0) list.bounds.visible[i] = 0;
+    }
+}
+
+bool hasIndirectDraws() {
+    return GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+}
+
+}
+
+void clearDrawList(DrawList& list) {
+    list.items.clear();
+    list.models.clear();
+    list.localBounds.clear();
+    list.commands.clear();
+    list.texturedStart = 0;
+    clearBounds(list.bounds);
+}
+
+void queueDraw(DrawList& list, const MeshRange& mesh, const glm::mat4& model, glm::vec3 color, float alpha, const TextureRegion* texture, const AABB& localBounds) {
+    DrawItem item;
+    item.mesh = mesh;
+    item.color = color;
+    item.alpha = alpha;
+    item.useTex = texture != nullptr && texture->texture != 0;
+    if (item.useTex) item.texture = *texture;
+    list.items.push_back(item);
+    list.models.push_back(model);
+    list.localBounds.push_back(localBounds);
+}
+
+void queueMeshletDraw(DrawList& list, const MeshRange& mesh, const MeshletMesh& meshlets, const glm::mat4& model, glm::vec3 color, const AABB& localBounds) {
+    queueDraw(list, mesh, model, color, 1.0f, nullptr, localBounds);
+    list.items.back().meshlets = &meshlets;
+}
+
+void cullDrawList(DrawList& list, const Frustum& frustum, CullStats& stats) {
+    clearBounds(list.bounds);
+    transformAABBs(list.models.data(), list.localBounds.data(), list.models.size(), list.bounds);
+    stats.tested += (int)list.items.size();
+    stats.culled += cullBounds(frustum, list.bounds);
+}
+
+void buildDrawCommands(DrawList& list, const Frustum& frustum, glm::vec3 eye, CullStats& stats) {
+    // Untextured commands first, then textured ones grouped by array texture, so each
+    // texture state and binding is one contiguous multi-draw.
+    list.commands.clear();
+    appendCommands(list, frustum, eye, stats, false);
+    list.texturedStart = list.commands.size();
+    appendCommands(list, frustum, eye, stats, true);
+    std::stable_sort(list.commands.begin() + list.texturedStart, list.commands.end(),
+        [&list](const DrawElementsIndirectCommand& a, const DrawElementsIndirectCommand& b) {
+            return list.items[a.baseInstance].texture.texture < list.items[b.baseInstance].texture.texture;
+        });
+}
+
+void submitDrawList(DrawList& list, MeshPool& pool, StreamRing& ring, ShaderLibrary& shaders, bool depthOnly) {
+    if (list.commands.empty()) return;
+    const size_t n = list.items.size();
+    list.normalMatrices.resize(n);
+    computeNormalMatrices(list.models.data(), list.normalMatrices.data(), n);
+
+    glBindVertexArray(pool.VAO);
+
+    if (hasIndirectDraws()) {
+        // One allocation holds the instance rows followed by the commands. It is aligned
+        // to whole rows, so the first row's index offsets every command's baseInstance.
+        const size_t instanceBytes = n * sizeof(DrawInstance);
+        const size_t commandBytes = list.commands.size() * sizeof(DrawElementsIndirectCommand);
+        size_t offset;
+        unsigned char* dst = streamAllocate(ring, instanceBytes + commandBytes, sizeof(DrawInstance), offset);
+        DrawInstance* instances = (DrawInstance*)dst;
+        for (size_t i = 0; i < n; ++i) {
+            instances[i].model = list.models[i];
+            instances[i].color = glm::vec4(list.items[i].color, list.items[i].alpha);
+            instances[i].normalMatrix = list.normalMatrices[i];
+            instances[i].texRect = list.items[i].texture.rect;
+            instances[i].texLayer = list.items[i].texture.layer;
+        }
+        const uint32_t firstInstance = (uint32_t)(offset / sizeof(DrawInstance));
+        DrawElementsIndirectCommand* commands = (DrawElementsIndirectCommand*)(dst + instanceBytes);
+        for (size_t c = 0; c < list.commands.size(); ++c) {
+            commands[c] = list.commands[c];
+            commands[c].baseInstance += firstInstance;
+        }
+        streamCommit(ring, offset, instanceBytes + commandBytes);
+
+        if (pool.instanceBuffer != ring.buffer) {
+            bindInstanceAttributes(ring.buffer);
+            pool.instanceBuffer = ring.buffer;
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ring.buffer);
+        const size_t commandOffset = offset + instanceBytes;
+
+        // Depth-only passes ignore textures, so everything is one draw there.
+        size_t begin = 0;
+        while (begin < list.commands.size()) {
+            const bool textured = !depthOnly && begin >= list.texturedStart;
+            size_t end = textured || depthOnly ? list.commands.size() : list.texturedStart;
+            if (textured) {
+                const unsigned texture = list.items[list.commands[begin].baseInstance].texture.texture;
+                end = begin + 1;
+                while (end < list.commands.size() && list.items[list.commands[end].baseInstance].texture.texture == texture) ++end;
+                glActiveTexture(GL_TEXTURE0 + kMaterialTextureUnit);
+                glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+            }
+            useShaderVariant(shaders, depthOnly ? shadowVariant(true) : surfaceVariant(textured, true));
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)(commandOffset + begin * sizeof(DrawElementsIndirectCommand)),
+                (GLsizei)(end - begin), sizeof(DrawElementsIndirectCommand));
+            begin = end;
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    } else {
+        // Without indirect draws or base instance the per-draw data goes through uniforms;
+        // the single VAO still means no vertex state changes between draws.
+        GLint modelLoc = -1, normalLoc = -1, colorLoc = -1, alphaLoc = -1, rectLoc = -1, layerLoc = -1;
+        uint32_t current = UINT32_MAX;
+        unsigned boundTexture = 0;
+        for (size_t c = 0; c < list.commands.size(); ++c) {
+            const DrawElementsIndirectCommand& cmd = list.commands[c];
+            if (c == 0 || c == list.texturedStart) {
+                unsigned int program = useShaderVariant(shaders, depthOnly ? shadowVariant(false) : surfaceVariant(c >= list.texturedStart, false));
+                modelLoc = glGetUniformLocation(program, "model");
+                normalLoc = glGetUniformLocation(program, "normalMatrix");
+                colorLoc = glGetUniformLocation(program, "objectColor");
+                alphaLoc = glGetUniformLocation(program, "alpha");
+                rectLoc = glGetUniformLocation(program, "texRect");
+                layerLoc = glGetUniformLocation(program, "texLayer");
+                current = UINT32_MAX;
+            }
+            if (cmd.baseInstance != current) {
+                current = cmd.baseInstance;
+                const DrawItem& item = list.items[current];
+                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(list.models[current]));
+                glUniformMatrix3fv(normalLoc, 1, GL_FALSE, glm::value_ptr(list.normalMatrices[current]));
+                glUniform3fv(colorLoc, 1, glm::value_ptr(item.color));
+                glUniform1f(alphaLoc, item.alpha);
+                if (item.useTex && !depthOnly) {
+                    if (item.texture.texture != boundTexture) {
+                        boundTexture = item.texture.texture;
+                        glActiveTexture(GL_TEXTURE0 + kMaterialTextureUnit);
+                        glBindTexture(GL_TEXTURE_2D_ARRAY, boundTexture);
+                    }
+                    glUniform4fv(rectLoc, 1, glm::value_ptr(item.texture.rect));
+                    glUniform1f(layerLoc, item.texture.layer);
+                }
+            }
+            glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)cmd.count, GL_UNSIGNED_INT, (const void*)(size_t)(cmd.firstIndex * sizeof(uint32_t)), cmd.baseVertex);
+        }
+    }
+    glBindVertexArray(0);
+}
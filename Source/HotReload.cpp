@@ -0,0 +1,91 @@
+#include "../Header/HotReload.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <sys/stat.h>
+
+namespace {
+
+// Modification time and size; 0 while the file is missing.
+long long fileStamp(const std::string& path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return 0;
+    return (long long)info.st_mtime * 1000003ll + (long long)info.st_size;
+}
+
+bool prepareAsset(const WatchedFile& file, bool compressTextures, ReloadedAsset& asset) {
+    asset.kind = file.kind;
+    asset.path = file.path;
+    if (file.kind == RELOAD_MODEL) return parseOBJ(file.path, asset.model);
+    if (file.kind == RELOAD_TEXTURE) {
+        std::vector<unsigned char> bytes;
+        if (!readTextureFile(file.path.c_str(), bytes, asset.hash) || !decodeImage(bytes.data(), bytes.size(), file.path.c_str(), asset.image)) return false;
+        if (compressTextures) compressImage(asset.image, asset.compressed);
+        return true;
+    }
+    std::ifstream in(file.path);
+    if (!in.is_open()) return false;
+    std::stringstream ss;
+    ss << in.rdbuf();
+    asset.text = ss.str();
+    return true;
+}
+
+void watchLoop(HotReload* reload) {
+    std::unique_lock<std::mutex> lock(reload->mutex);
+    while (!reload->wake.wait_for(lock, std::chrono::milliseconds(reload->intervalMs), [&] { return reload->quit; })) {
+        lock.unlock();
+        // Only this thread touches files once the watcher runs.
+        std::vector<ReloadedAsset> prepared;
+        for (WatchedFile& file : reload->files) {
+            long long stamp = fileStamp(file.path);
+            bool settled = stamp == file.seen;
+            file.seen = stamp;
+            if (stamp == 0 || stamp == file.stamp || !settled) continue;
+            file.stamp = stamp;
+            ReloadedAsset asset;
+            if (prepareAsset(file, reload->compressTextures, asset)) prepared.push_back(std::move(asset));
+            else std::cout << "Ponovno ucitavanje nije uspelo: " << file.path << std::endl;
+        }
+        lock.lock();
+        for (ReloadedAsset& asset : prepared) reload->ready.push_back(std::move(asset));
+    }
+}
+
+}
+
+void watchFile(HotReload& reload, const std::string& path, ReloadKind kind) {
+    for (const WatchedFile& file : reload.files)
+        if (file.path == path) return;
+    WatchedFile file;
+    file.path = path;
+    file.kind = kind;
+    file.stamp = file.seen = fileStamp(path);
+    reload.files.push_back(file);
+}
+
+void startHotReload(HotReload& reload) {
+    reload.quit = false;
+    reload.thread = std::thread(watchLoop, &reload);
+}
+
+void stopHotReload(HotReload& reload) {
+    if (!reload.thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(reload.mutex);
+        reload.quit = true;
+    }
+    reload.wake.notify_all();
+    reload.thread.join();
+    reload.ready.clear();
+}
+
+size_t takeReloadedAssets(HotReload& reload, std::vector<ReloadedAsset>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lock(reload.mutex);
+    if (reload.ready.empty()) return 0;
+    out.swap(reload.ready);
+    reload.reloads += (int)out.size();
+    return out.size();
+}
@@ -0,0 +1,344 @@
+#include "../Header/Hull.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+struct HullFace {
+    int v[3];
+    glm::vec3 n;
+    float d;
+    std::vector<int> outside;
+    bool alive;
+};
+
+HullFace makeFace(const std::vector<glm::vec3>& pts, int a, int b, int c, glm::vec3 interior) {
+    HullFace f;
+    glm::vec3 n = glm::cross(pts[b] - pts[a], pts[c] - pts[a]);
+    if (glm::dot(n, interior - pts[a]) > 0.0f) { std::swap(b, c); n = -n; }
+    float len = glm::length(n);
+    f.v[0] = a; f.v[1] = b; f.v[2] = c;
+    f.n = len > 0.0f ? n / len : glm::vec3(0.0f, 1.0f, 0.0f);
+    f.d = glm::dot(f.n, pts[a]);
+    f.alive = true;
+    return f;
+}
+
+void assignOutside(std::vector<HullFace>& faces, size_t firstFace, const std::vector<glm::vec3>& pts, const std::vector<int>& candidates, float eps) {
+    for (int p : candidates) {
+        for (size_t f = firstFace; f < faces.size(); ++f) {
+            if (faces[f].alive && glm::dot(faces[f].n, pts[p]) - faces[f].d > eps) {
+                faces[f].outside.push_back(p);
+                break;
+            }
+        }
+    }
+}
+
+AABB pointBounds(const std::vector<glm::vec3>& pts) {
+    AABB box;
+    box.min = box.max = pts.empty() ? glm::vec3(0.0f) : pts[0];
+    for (const glm::vec3& p : pts) {
+        box.min = glm::min(box.min, p);
+        box.max = glm::max(box.max, p);
+    }
+    return box;
+}
+
+void projectHull(const ConvexHull& hull, glm::vec3 center, glm::vec3 scale, glm::vec3 axis, float& lo, float& hi) {
+    // Scaling the axis instead of every vertex keeps the loop to one dot product.
+    glm::vec3 scaled = axis * scale;
+    float c = glm::dot(axis, center);
+    lo = hi = c + glm::dot(scaled, hull.vertices[0]);
+    for (size_t i = 1; i < hull.vertices.size(); ++i) {
+        float d = c + glm::dot(scaled, hull.vertices[i]);
+        lo = std::min(lo, d);
+        hi = std::max(hi, d);
+    }
+}
+
+glm::vec3 worldNormal(const glm::vec4& plane, glm::vec3 scale) {
+    return glm::normalize(glm::vec3(plane) / scale);
+}
+
+// Tests one separating axis; returns false when it separates the intervals.
+bool testAxis(glm::vec3 axis, float loA, float hiA, float loB, float hiB, float& bestDepth, glm::vec3& bestNormal) {
+    float forward = hiA - loB;
+    float backward = hiB - loA;
+    if (forward <= 0.0f || backward <= 0.0f) return false;
+    float overlap = std::min(forward, backward);
+    if (overlap < bestDepth) {
+        bestDepth = overlap;
+        bestNormal = forward < backward ? axis : -axis;
+    }
+    return true;
+}
+
+float triangleSoupCentroid(const std::vector<glm::vec3>& tris, int tri, int axis) {
+    return (tris[tri * 3][axis] + tris[tri * 3 + 1][axis] + tris[tri * 3 + 2][axis]) * (1.0f / 3.0f);
+}
+
+ConvexHull hullOfTriangles(const std::vector<glm::vec3>& tris, const std::vector<int>& subset, int maxVertices) {
+    std::vector<glm::vec3> pts;
+    pts.reserve(subset.size() * 3);
+    for (int t : subset) {
+        pts.push_back(tris[t * 3]);
+        pts.push_back(tris[t * 3 + 1]);
+        pts.push_back(tris[t * 3 + 2]);
+    }
+    return buildConvexHull(pts, maxVertices);
+}
+
+}
+
+ConvexHull makeBoxHull(const AABB& box) {
+    ConvexHull hull;
+    for (int i = 0; i < 8; ++i)
+        hull.vertices.push_back(glm::vec3((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z));
+    hull.planes = {
+        glm::vec4(1, 0, 0, box.max.x), glm::vec4(-1, 0, 0, -box.min.x),
+        glm::vec4(0, 1, 0, box.max.y), glm::vec4(0, -1, 0, -box.min.y),
+        glm::vec4(0, 0, 1, box.max.z), glm::vec4(0, 0, -1, -box.min.z)
+    };
+    hull.bounds = box;
+    glm::vec3 size = box.max - box.min;
+    hull.volume = size.x * size.y * size.z;
+    return hull;
+}
+
+ConvexHull buildConvexHull(const std::vector<glm::vec3>& pts, int maxVertices) {
+    AABB box = pointBounds(pts);
+    glm::vec3 size = box.max - box.min;
+    const float eps = 1e-5f * std::max(std::max(size.x, size.y), std::max(size.z, 1e-3f));
+    if (pts.size() < 4) return makeBoxHull(box);
+
+    // Initial tetrahedron from the extreme points.
+    int extremes[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int i = 0; i < (int)pts.size(); ++i) {
+        for (int a = 0; a < 3; ++a) {
+            if (pts[i][a] < pts[extremes[a * 2]][a]) extremes[a * 2] = i;
+            if (pts[i][a] > pts[extremes[a * 2 + 1]][a]) extremes[a * 2 + 1] = i;
+        }
+    }
+    int i0 = extremes[0], i1 = extremes[1];
+    float best = -1.0f;
+    for (int a = 0; a < 6; ++a)
+        for (int b = a + 1; b < 6; ++b) {
+            float d = glm::dot(pts[extremes[a]] - pts[extremes[b]], pts[extremes[a]] - pts[extremes[b]]);
+            if (d > best) { best = d; i0 = extremes[a]; i1 = extremes[b]; }
+        }
+    glm::vec3 lineDir = pts[i1] - pts[i0];
+    int i2 = -1;
+    best = eps * eps;
+    for (int i = 0; i < (int)pts.size(); ++i) {
+        glm::vec3 c = glm::cross(lineDir, pts[i] - pts[i0]);
+        float d = glm::dot(c, c) / std::max(glm::dot(lineDir, lineDir), 1e-12f);
+        if (d > best) { best = d; i2 = i; }
+    }
+    if (i2 < 0) return makeBoxHull(box);
+    glm::vec3 planeN = glm::normalize(glm::cross(pts[i1] - pts[i0], pts[i2] - pts[i0]));
+    int i3 = -1;
+    best = eps;
+    for (int i = 0; i < (int)pts.size(); ++i) {
+        float d = std::fabs(glm::dot(planeN, pts[i] - pts[i0]));
+        if (d > best) { best = d; i3 = i; }
+    }
+    if (i3 < 0) return makeBoxHull(box);
+
+    glm::vec3 interior = (pts[i0] + pts[i1] + pts[i2] + pts[i3]) * 0.25f;
+    std::vector<HullFace> faces;
+    faces.push_back(makeFace(pts, i0, i1, i2, interior));
+    faces.push_back(makeFace(pts, i0, i1, i3, interior));
+    faces.push_back(makeFace(pts, i0, i2, i3, interior));
+    faces.push_back(makeFace(pts, i1, i2, i3, interior));
+
+    std::vector<int> candidates;
+    candidates.reserve(pts.size());
+    for (int i = 0; i < (int)pts.size(); ++i)
+        if (i != i0 && i != i1 && i != i2 && i != i3) candidates.push_back(i);
+    assignOutside(faces, 0, pts, candidates, eps);
+
+    int hullVertices = 4;
+    std::vector<std::pair<int, int>> edges, horizon;
+    while (hullVertices < maxVertices) {
+        int apex = -1;
+        float apexDist = eps;
+        for (const HullFace& f : faces) {
+            if (!f.alive) continue;
+            for (int p : f.outside) {
+                float d = glm::dot(f.n, pts[p]) - f.d;
+                if (d > apexDist) { apexDist = d; apex = p; }
+            }
+        }
+        if (apex < 0) break;
+
+        edges.clear();
+        candidates.clear();
+        for (HullFace& f : faces) {
+            if (!f.alive || glm::dot(f.n, pts[apex]) - f.d <= eps) continue;
+            for (int e = 0; e < 3; ++e) edges.push_back(std::make_pair(f.v[e], f.v[(e + 1) % 3]));
+            for (int p : f.outside) if (p != apex) candidates.push_back(p);
+            f.outside.clear();
+            f.alive = false;
+        }
+        horizon.clear();
+        for (const std::pair<int, int>& e : edges) {
+            if (std::find(edges.begin(), edges.end(), std::make_pair(e.second, e.first)) == edges.end())
+                horizon.push_back(e);
+        }
+
+        size_t firstNew = faces.size();
+        for (const std::pair<int, int>& e : horizon)
+            faces.push_back(makeFace(pts, e.first, e.second, apex, interior));
+        assignOutside(faces, firstNew, pts, candidates, eps);
+        ++hullVertices;
+        faces.erase(std::remove_if(faces.begin(), faces.end(), [](const HullFace& f) { return !f.alive; }), faces.end());
+    }
+
+    ConvexHull hull;
+    std::vector<int> remap(pts.size(), -1);
+    for (const HullFace& f : faces) {
+        if (!f.alive) continue;
+        for (int k = 0; k < 3; ++k) {
+            if (remap[f.v[k]] < 0) {
+                remap[f.v[k]] = (int)hull.vertices.size();
+                hull.vertices.push_back(pts[f.v[k]]);
+            }
+        }
+        const glm::vec3& a = pts[f.v[0]];
+        const glm::vec3& b = pts[f.v[1]];
+        const glm::vec3& c = pts[f.v[2]];
+        hull.volume += glm::dot(a - interior, glm::cross(b - interior, c - interior)) / 6.0f;
+
+        bool duplicate = false;
+        for (const glm::vec4& pl : hull.planes) {
+            if (glm::dot(glm::vec3(pl), f.n) > 0.9999f) { duplicate = true; break; }
+        }
+        if (!duplicate) hull.planes.push_back(glm::vec4(f.n, f.d));
+    }
+    hull.bounds = pointBounds(hull.vertices);
+    return hull;
+}
+
+std::vector<ConvexHull> decomposeConvex(const std::vector<glm::vec3>& tris, int maxPieces, int maxVertices) {
+    struct Piece { std::vector<int> tris; ConvexHull hull; bool final; };
+    std::vector<Piece> pieces;
+    const int triCount = (int)(tris.size() / 3);
+    if (triCount == 0) return std::vector<ConvexHull>();
+
+    Piece root;
+    root.tris.resize(triCount);
+    for (int t = 0; t < triCount; ++t) root.tris[t] = t;
+    root.hull = hullOfTriangles(tris, root.tris, maxVertices);
+    root.final = false;
+    pieces.push_back(root);
+
+    const float minSaving = 0.1f;
+    std::vector<int> left, right, bestLeft, bestRight;
+    std::vector<float> keys;
+    while ((int)pieces.size() < maxPieces) {
+        int target = -1;
+        for (int i = 0; i < (int)pieces.size(); ++i) {
+            if (pieces[i].final || pieces[i].tris.size() < 2) continue;
+            if (target < 0 || pieces[i].hull.volume > pieces[target].hull.volume) target = i;
+        }
+        if (target < 0) break;
+        Piece& piece = pieces[target];
+
+        float bestVolume = piece.hull.volume * (1.0f - minSaving);
+        ConvexHull bestL, bestR;
+        bool found = false;
+        for (int axis = 0; axis < 3; ++axis) {
+            keys.clear();
+            for (int t : piece.tris) keys.push_back(triangleSoupCentroid(tris, t, axis));
+            std::vector<float> sorted = keys;
+            std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+            float split = sorted[sorted.size() / 2];
+
+            left.clear(); right.clear();
+            for (size_t k = 0; k < piece.tris.size(); ++k)
+                (keys[k] < split ? left : right).push_back(piece.tris[k]);
+            if (left.empty() || right.empty()) continue;
+
+            ConvexHull hl = hullOfTriangles(tris, left, maxVertices);
+            ConvexHull hr = hullOfTriangles(tris, right, maxVertices);
+            if (hl.volume + hr.volume < bestVolume) {
+                bestVolume = hl.volume + hr.volume;
+                bestL = hl; bestR = hr;
+                bestLeft = left; bestRight = right;
+                found = true;
+            }
+        }
+
+        if (!found) { piece.final = true; continue; }
+        piece.tris = bestLeft;
+        piece.hull = bestL;
+        Piece other;
+        other.tris = bestRight;
+        other.hull = bestR;
+        other.final = false;
+        pieces.push_back(other);
+    }
+
+    std::vector<ConvexHull> result;
+    for (const Piece& p : pieces) result.push_back(p.hull);
+    return result;
+}
+
+bool intersectHulls(const ConvexHull& a, glm::vec3 centerA, glm::vec3 scaleA,
+    const ConvexHull& b, glm::vec3 centerB, glm::vec3 scaleB, glm::vec3& normal, float& depth) {
+    float bestDepth = 1e30f;
+    glm::vec3 bestNormal(0.0f, 1.0f, 0.0f);
+    float loA, hiA, loB, hiB;
+    for (const glm::vec4& pl : a.planes) {
+        glm::vec3 axis = worldNormal(pl, scaleA);
+        projectHull(a, centerA, scaleA, axis, loA, hiA);
+        projectHull(b, centerB, scaleB, axis, loB, hiB);
+        if (!testAxis(axis, loA, hiA, loB, hiB, bestDepth, bestNormal)) return false;
+    }
+    for (const glm::vec4& pl : b.planes) {
+        glm::vec3 axis = worldNormal(pl, scaleB);
+        projectHull(a, centerA, scaleA, axis, loA, hiA);
+        projectHull(b, centerB, scaleB, axis, loB, hiB);
+        if (!testAxis(axis, loA, hiA, loB, hiB, bestDepth, bestNormal)) return false;
+    }
+    normal = bestNormal;
+    depth = bestDepth;
+    return true;
+}
+
+bool intersectSphereHull(glm::vec3 sphereCenter, float radius,
+    const ConvexHull& hull, glm::vec3 center, glm::vec3 scale, glm::vec3& normal, float& depth) {
+    float bestDepth = 1e30f;
+    glm::vec3 bestNormal(0.0f, 1.0f, 0.0f);
+    float lo, hi;
+
+    glm::vec3 nearest = center + hull.vertices[0] * scale;
+    for (const glm::vec3& v : hull.vertices) {
+        glm::vec3 p = center + v * scale;
+        if (glm::dot(p - sphereCenter, p - sphereCenter) < glm::dot(nearest - sphereCenter, nearest - sphereCenter)) nearest = p;
+    }
+    glm::vec3 toVertex = nearest - sphereCenter;
+    if (glm::dot(toVertex, toVertex) > 1e-12f) {
+        glm::vec3 axis = glm::normalize(toVertex);
+        float c = glm::dot(axis, sphereCenter);
+        projectHull(hull, center, scale, axis, lo, hi);
+        if (!testAxis(axis, c - radius, c + radius, lo, hi, bestDepth, bestNormal)) return false;
+    }
+    for (const glm::vec4& pl : hull.planes) {
+        glm::vec3 axis = worldNormal(pl, scale);
+        float c = glm::dot(axis, sphereCenter);
+        projectHull(hull, center, scale, axis, lo, hi);
+        if (!testAxis(axis, c - radius, c + radius, lo, hi, bestDepth, bestNormal)) return false;
+    }
+    normal = bestNormal;
+    depth = bestDepth;
+    return true;
+}
+
+bool hullOverlapsBox(const ConvexHull& hull, glm::vec3 center, glm::vec3 scale, const AABB& box) {
+    static const ConvexHull unitBox = makeBoxHull(AABB());
+    glm::vec3 normal;
+    float depth;
+    return intersectHulls(hull, center, scale, unitBox, (box.min + box.max) * 0.5f, box.max - box.min, normal, depth);
+}
@@ -0,0 +1,181 @@
+#include "../Header/Lights.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+// Clusters are ordered y, then x, then z so each depth slice, and each tile column
+// within it, is contiguous in the order assignment writes them.
+int clusterIndex(int x, int y, int z) {
+    return y + kClusterY * (x + kClusterX * z);
+}
+
+float sliceDepth(const ClusteredLights& cl, int z) {
+    return cl.nearPlane * std::pow(cl.farPlane / cl.nearPlane, (float)z / kClusterZ);
+}
+
+void rebuildClusterBounds(ClusteredLights& cl) {
+    cl.clusterMin.resize(kClusterCount);
+    cl.clusterMax.resize(kClusterCount);
+    cl.columnMin.assign(kClusterX * kClusterZ, glm::vec3(1e30f));
+    cl.columnMax.assign(kClusterX * kClusterZ, glm::vec3(-1e30f));
+    glm::mat4 invProjection = glm::inverse(cl.projection);
+    for (int z = 0; z < kClusterZ; ++z) {
+        float depths[2] = { sliceDepth(cl, z), sliceDepth(cl, z + 1) };
+        for (int x = 0; x < kClusterX; ++x) {
+            for (int y = 0; y < kClusterY; ++y) {
+                glm::vec3 lo(1e30f), hi(-1e30f);
+                for (int corner = 0; corner < 4; ++corner) {
+                    float ndcX = -1.0f + 2.0f * (x + (corner & 1)) / kClusterX;
+                    float ndcY = -1.0f + 2.0f * (y + (corner >> 1)) / kClusterY;
+                    glm::vec4 p = invProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+                    glm::vec3 ray = glm::vec3(p) / p.w;
+                    ray /= -ray.z;
+                    for (float d : depths) {
+                        lo = glm::min(lo, ray * d);
+                        hi = glm::max(hi, ray * d);
+                    }
+                }
+                int c = clusterIndex(x, y, z);
+                cl.clusterMin[c] = lo;
+                cl.clusterMax[c] = hi;
+                cl.columnMin[z * kClusterX + x] = glm::min(cl.columnMin[z * kClusterX + x], lo);
+                cl.columnMax[z * kClusterX + x] = glm::max(cl.columnMax[z * kClusterX + x], hi);
+            }
+        }
+    }
+}
+
+bool sphereTouchesBox(const glm::vec4& sphere, const glm::vec3& lo, const glm::vec3& hi) {
+    glm::vec3 c(sphere);
+    glm::vec3 d = glm::max(glm::vec3(0.0f), glm::max(lo - c, c - hi));
+    return glm::dot(d, d) <= sphere.w * sphere.w;
+}
+
+void assignSlice(ClusteredLights& cl, int z) {
+    std::vector<uint16_t>& out = cl.sliceIndices[z];
+    out.clear();
+    const float zNear = -sliceDepth(cl, z), zFar = -sliceDepth(cl, z + 1);
+    uint16_t inSlice[kMaxLights], inColumn[kMaxLights];
+    int sliceCount = 0;
+    for (size_t i = 0; i < cl.viewSpheres.size(); ++i) {
+        const glm::vec4& s = cl.viewSpheres[i];
+        if (s.z - s.w <= zNear && s.z + s.w >= zFar) inSlice[sliceCount++] = (uint16_t)i;
+    }
+    for (int x = 0; x < kClusterX; ++x) {
+        int columnCount = 0;
+        for (int i = 0; i < sliceCount; ++i)
+            if (sphereTouchesBox(cl.viewSpheres[inSlice[i]], cl.columnMin[z * kClusterX + x], cl.columnMax[z * kClusterX + x]))
+                inColumn[columnCount++] = inSlice[i];
+        for (int y = 0; y < kClusterY; ++y) {
+            int c = clusterIndex(x, y, z);
+            uint32_t count = 0;
+            for (int i = 0; i < columnCount && count < (uint32_t)kMaxLightsPerCluster; ++i) {
+                if (!sphereTouchesBox(cl.viewSpheres[inColumn[i]], cl.clusterMin[c], cl.clusterMax[c])) continue;
+                out.push_back(inColumn[i]);
+                ++count;
+            }
+            cl.sliceCounts[c] = count;
+        }
+    }
+}
+
+}
+
+void initClusteredLights(ClusteredLights& cl) {
+    glGenBuffers(1, &cl.clusterBuffer);
+    glGenTextures(1, &cl.clusterTexture);
+    glBindBuffer(GL_TEXTURE_BUFFER, cl.clusterBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, 2 * kClusterCount * sizeof(uint32_t), NULL, GL_STREAM_DRAW);
+    cl.clusterCapacity = 2 * kClusterCount * sizeof(uint32_t);
+    glBindTexture(GL_TEXTURE_BUFFER, cl.clusterTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, cl.clusterBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void deleteClusteredLights(ClusteredLights& cl) {
+    if (cl.clusterTexture) glDeleteTextures(1, &cl.clusterTexture);
+    if (cl.clusterBuffer) glDeleteBuffers(1, &cl.clusterBuffer);
+    cl.clusterTexture = 0;
+    cl.clusterBuffer = 0;
+    cl.clusterCapacity = 0;
+}
+
+void clearLights(ClusteredLights& cl) {
+    cl.lights.clear();
+}
+
+void addLight(ClusteredLights& cl, const Light& light) {
+    if (cl.lights.size() < (size_t)kMaxLights) cl.lights.push_back(light);
+}
+
+void assignLights(ClusteredLights& cl, ThreadPool& threads, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (projection != cl.projection || nearPlane != cl.nearPlane || farPlane != cl.farPlane || cl.clusterMin.empty()) {
+        cl.projection = projection;
+        cl.nearPlane = nearPlane;
+        cl.farPlane = farPlane;
+        rebuildClusterBounds(cl);
+    }
+
+    cl.viewSpheres.resize(cl.lights.size());
+    for (size_t i = 0; i < cl.lights.size(); ++i)
+        cl.viewSpheres[i] = glm::vec4(glm::vec3(view * glm::vec4(cl.lights[i].position, 1.0f)), cl.lights[i].radius);
+
+    cl.sliceIndices.resize(kClusterZ);
+    cl.sliceCounts.resize(kClusterCount);
+    parallelFor(threads, kClusterZ, 1, [&cl](size_t begin, size_t end) {
+        for (size_t z = begin; z < end; ++z) assignSlice(cl, (int)z);
+    });
+
+    // Slices are written independently; stitch them into one offset table and index list.
+    cl.clusterData.resize(2 * kClusterCount);
+    uint32_t offset = 0, maxCount = 0;
+    for (int c = 0; c < kClusterCount; ++c) {
+        cl.clusterData[2 * c] = offset;
+        cl.clusterData[2 * c + 1] = cl.sliceCounts[c];
+        offset += cl.sliceCounts[c];
+        maxCount = std::max(maxCount, cl.sliceCounts[c]);
+    }
+    for (int z = 0; z < kClusterZ; ++z)
+        cl.clusterData.insert(cl.clusterData.end(), cl.sliceIndices[z].begin(), cl.sliceIndices[z].end());
+
+    cl.stats.lights = (int)cl.lights.size();
+    cl.stats.references = (int)offset;
+    cl.stats.maxPerCluster = (int)maxCount;
+    cl.stats.assignMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void uploadLights(ClusteredLights& cl, StreamRing& ring, FrameUniforms& frame, int viewportWidth, int viewportHeight) {
+    // The bound range has to cover the whole block even if fewer lights are written.
+    const size_t blockBytes = kMaxLights * sizeof(GpuLight);
+    size_t offset;
+    GpuLight* dst = (GpuLight*)streamAllocate(ring, blockBytes, uniformBlockAlignment(), offset);
+    for (size_t i = 0; i < cl.lights.size(); ++i) {
+        const Light& l = cl.lights[i];
+        dst[i].positionRadius = glm::vec4(l.position, l.radius);
+        dst[i].color = glm::vec4(l.color, l.specular);
+        dst[i].directionCos = glm::vec4(glm::normalize(l.direction), l.spotCos);
+    }
+    streamCommit(ring, offset, cl.lights.size() * sizeof(GpuLight));
+    streamBindUniforms(ring, kLightsBlockBinding, offset, blockBytes, uniformBlockAlignment());
+
+    // Texture buffers cannot be bound at an offset before GL 4.3, so the cluster lists
+    // keep their own buffer, orphaned each frame.
+    const size_t bytes = cl.clusterData.size() * sizeof(uint32_t);
+    glBindBuffer(GL_TEXTURE_BUFFER, cl.clusterBuffer);
+    if (bytes > cl.clusterCapacity) cl.clusterCapacity = bytes * 2;
+    glBufferData(GL_TEXTURE_BUFFER, cl.clusterCapacity, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, cl.clusterData.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0 + kClusterTextureUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, cl.clusterTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    const float logRatio = std::log(cl.farPlane / cl.nearPlane);
+    frame.clusterParams = glm::vec4((float)viewportWidth / kClusterX, (float)viewportHeight / kClusterY,
+        kClusterZ / logRatio, -kClusterZ * std::log(cl.nearPlane) / logRatio);
+}
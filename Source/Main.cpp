@@ -7,30 +7,30 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <cmath>
 #include <cstddef>
+#include <string>
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
 #include "../Header/Util.h"
+#include "../Header/Transparency.h"
+#include "../Header/DrawList.h"
+#include "../Header/Occlusion.h"
+#include "../Header/SceneGraph.h"
+#include "../Header/Prizes.h"
+#include "../Header/Physics.h"
+#include "../Header/Benchmark.h"
+#include "../Header/Lights.h"
+#include "../Header/ThreadPool.h"
+#include "../Header/Shaders.h"
+#include "../Header/HotReload.h"
+#include "../Header/Shadows.h"
+#include "../Header/TextureManager.h"
+#include "../Header/Assets.h"
 
 enum GameState { WAITING_FOR_COIN, PLAYING, RETURNING };
 GameState currentState = WAITING_FOR_COIN;
 
-struct Toy {
-    glm::vec3 pos;
-    glm::vec3 color;
-    bool isCaught = false;
-    bool isDropped = false;
-    bool isTaken = false;
-    bool isFalling = false;
-    float verticalVelocity = 0.0f;
-};
-
-std::vector<Toy> toys = {
-    {glm::vec3(0.3f, 1.15f, -0.4f), glm::vec3(0.1f, 0.5f, 0.8f)},
-    {glm::vec3(-0.3f, 1.15f, 0.2f), glm::vec3(0.9f, 0.2f, 0.2f)}
-};
-
 float yaw = -90.0f, pitch = 0.0f, cameraAngle = 0.0f, cameraRadius = 10.0f;
 float lastX = 400, lastY = 300;
 bool firstMouse = true;
@@ -45,13 +45,9 @@ const double frameTime = 1.0 / targetFPS;
 
 bool depthTestEnabled = true;
 bool cullFaceEnabled = false;
-unsigned int potpisTex;
-
-unsigned int sphereVAO = 0; unsigned int sphereVertexCount = 0;
+TextureHandle potpisTex = kNoTexture;
 
-Model toyModel1, toyModel2;
-
-void createSphere(int latSegments, int lonSegments, unsigned int &outVAO, unsigned int &outVertexCount) {
+MeshRange createSphere(MeshPool& pool, int latSegments, int lonSegments) {
     struct V { float x,y,z; float nx,ny,nz; float u,v; };
     std::vector<V> verts;
     for (int y = 0; y < latSegments; ++y) {
@@ -83,16 +79,7 @@ void createSphere(int latSegments, int lonSegments, unsigned int &outVAO, unsign
         }
     }
 
-    if (verts.empty()) return;
-    GLuint VAO, VBO; glGenVertexArrays(1, &VAO); glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(V), verts.data(), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0); glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,sizeof(V),(void*)offsetof(V,x));
-    glEnableVertexAttribArray(1); glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,sizeof(V),(void*)offsetof(V,nx));
-    glEnableVertexAttribArray(2); glVertexAttribPointer(2,2,GL_FLOAT,GL_FALSE,sizeof(V),(void*)offsetof(V,u));
-
-    outVAO = VAO; outVertexCount = (unsigned int)verts.size();
+    return uploadTriangles(pool, &verts[0].x, (uint32_t)verts.size());
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -104,20 +91,8 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     if (pitch > 89.0f) pitch = 89.0f; if (pitch < -89.0f) pitch = -89.0f;
 }
 
-void drawObject(unsigned int vao, int vertexCount, unsigned int shader, glm::mat4 model, glm::vec3 color, float alpha = 1.0f, bool useTex = false) {
-    glUniformMatrix4fv(glGetUniformLocation(shader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniform3fv(glGetUniformLocation(shader, "objectColor"), 1, glm::value_ptr(color));
-    glUniform1f(glGetUniformLocation(shader, "alpha"), alpha);
-    glUniform1i(glGetUniformLocation(shader, "useTexture"), useTex);
-    glBindVertexArray(vao);
-    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
-}
-
-void drawObject(unsigned int vao, unsigned int shader, glm::mat4 model, glm::vec3 color, float alpha = 1.0f, bool useTex = false) {
-    drawObject(vao, 36, shader, model, color, alpha, useTex);
-}
-
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") return runBenchmarks(argc - 2, argv + 2);
     if (!glfwInit()) return -1;
     GLFWmonitor* monitor = glfwGetPrimaryMonitor();
     const GLFWvidmode* mode = glfwGetVideoMode(monitor);
@@ -133,43 +108,187 @@ int main() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     float vertices[] = {
-        -0.5f,-0.5f,-0.5f,  0.0f, 0.0f,-1.0f,  0.0f, 0.0f,  0.5f,-0.5f,-0.5f,  0.0f, 0.0f,-1.0f,  1.0f, 0.0f,
-         0.5f, 0.5f,-0.5f,  0.0f, 0.0f,-1.0f,  1.0f, 1.0f,  0.5f, 0.5f,-0.5f,  0.0f, 0.0f,-1.0f,  1.0f, 1.0f,
-        -0.5f, 0.5f,-0.5f,  0.0f, 0.0f,-1.0f,  0.0f, 1.0f, -0.5f,-0.5f,-0.5f,  0.0f, 0.0f,-1.0f,  0.0f, 0.0f,
+        -0.5f,-0.5f,-0.5f,  0.0f, 0.0f,-1.0f,  0.0f, 0.0f,  0.5f, 0.5f,-0.5f,  0.0f, 0.0f,-1.0f,  1.0f, 1.0f,
+         0.5f,-0.5f,-0.5f,  0.0f, 0.0f,-1.0f,  1.0f, 0.0f,  0.5f, 0.5f,-0.5f,  0.0f, 0.0f,-1.0f,  1.0f, 1.0f,
+        -0.5f,-0.5f,-0.5f,  0.0f, 0.0f,-1.0f,  0.0f, 0.0f, -0.5f, 0.5f,-0.5f,  0.0f, 0.0f,-1.0f,  0.0f, 1.0f,
         -0.5f,-0.5f, 0.5f,  0.0f, 0.0f, 1.0f,  0.0f, 0.0f,  0.5f,-0.5f, 0.5f,  0.0f, 0.0f, 1.0f,  1.0f, 0.0f,
          0.5f, 0.5f, 0.5f,  0.0f, 0.0f, 1.0f,  1.0f, 1.0f,  0.5f, 0.5f, 0.5f,  0.0f, 0.0f, 1.0f,  1.0f, 1.0f,
         -0.5f, 0.5f, 0.5f,  0.0f, 0.0f, 1.0f,  0.0f, 1.0f, -0.5f,-0.5f, 0.5f,  0.0f, 0.0f, 1.0f,  0.0f, 0.0f,
         -0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f,  1.0f, 0.0f, -0.5f, 0.5f,-0.5f, -1.0f, 0.0f, 0.0f,  1.0f, 1.0f,
         -0.5f,-0.5f,-0.5f, -1.0f, 0.0f, 0.0f,  0.0f, 1.0f, -0.5f,-0.5f,-0.5f, -1.0f, 0.0f, 0.0f,  0.0f, 1.0f,
         -0.5f,-0.5f, 0.5f, -1.0f, 0.0f, 0.0f,  0.0f, 0.0f, -0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f,  1.0f, 0.0f,
-         0.5f, 0.5f, 0.5f,  1.0f, 0.0f, 0.0f,  1.0f, 0.0f,  0.5f, 0.5f,-0.5f,  1.0f, 0.0f, 0.0f,  1.0f, 1.0f,
-         0.5f,-0.5f,-0.5f,  1.0f, 0.0f, 0.0f,  0.0f, 1.0f,  0.5f,-0.5f,-0.5f,  1.0f, 0.0f, 0.0f,  0.0f, 1.0f,
-         0.5f,-0.5f, 0.5f,  1.0f, 0.0f, 0.0f,  0.0f, 0.0f,  0.5f, 0.5f, 0.5f,  1.0f, 0.0f, 0.0f,  1.0f, 0.0f,
+         0.5f, 0.5f, 0.5f,  1.0f, 0.0f, 0.0f,  1.0f, 0.0f,  0.5f,-0.5f,-0.5f,  1.0f, 0.0f, 0.0f,  0.0f, 1.0f,
+         0.5f, 0.5f,-0.5f,  1.0f, 0.0f, 0.0f,  1.0f, 1.0f,  0.5f,-0.5f,-0.5f,  1.0f, 0.0f, 0.0f,  0.0f, 1.0f,
+         0.5f, 0.5f, 0.5f,  1.0f, 0.0f, 0.0f,  1.0f, 0.0f,  0.5f,-0.5f, 0.5f,  1.0f, 0.0f, 0.0f,  0.0f, 0.0f,
         -0.5f,-0.5f,-0.5f,  0.0f,-1.0f, 0.0f,  0.0f, 1.0f,  0.5f,-0.5f,-0.5f,  0.0f,-1.0f, 0.0f,  1.0f, 1.0f,
          0.5f,-0.5f, 0.5f,  0.0f,-1.0f, 0.0f,  1.0f, 0.0f,  0.5f,-0.5f, 0.5f,  0.0f,-1.0f, 0.0f,  1.0f, 0.0f,
         -0.5f,-0.5f, 0.5f,  0.0f,-1.0f, 0.0f,  0.0f, 0.0f, -0.5f,-0.5f,-0.5f,  0.0f,-1.0f, 0.0f,  0.0f, 1.0f,
-        -0.5f, 0.5f,-0.5f,  0.0f, 1.0f, 0.0f,  0.0f, 1.0f,  0.5f, 0.5f,-0.5f,  0.0f, 1.0f, 0.0f,  1.0f, 1.0f,
-         0.5f, 0.5f, 0.5f,  0.0f, 1.0f, 0.0f,  1.0f, 0.0f,  0.5f, 0.5f, 0.5f,  0.0f, 1.0f, 0.0f,  1.0f, 0.0f,
-        -0.5f, 0.5f, 0.5f,  0.0f, 1.0f, 0.0f,  0.0f, 0.0f, -0.5f, 0.5f,-0.5f,  0.0f, 1.0f, 0.0f,  0.0f, 1.0f
+        -0.5f, 0.5f,-0.5f,  0.0f, 1.0f, 0.0f,  0.0f, 1.0f,  0.5f, 0.5f, 0.5f,  0.0f, 1.0f, 0.0f,  1.0f, 0.0f,
+         0.5f, 0.5f,-0.5f,  0.0f, 1.0f, 0.0f,  1.0f, 1.0f,  0.5f, 0.5f, 0.5f,  0.0f, 1.0f, 0.0f,  1.0f, 0.0f,
+        -0.5f, 0.5f,-0.5f,  0.0f, 1.0f, 0.0f,  0.0f, 1.0f, -0.5f, 0.5f, 0.5f,  0.0f, 1.0f, 0.0f,  0.0f, 0.0f
     };
 
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO); glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO); glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0); glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float))); glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float))); glEnableVertexAttribArray(2);
-
-    createSphere(24, 24, sphereVAO, sphereVertexCount);
-
-    unsigned int shaderProgram = createShader("Resources/shader.vert", "Resources/shader.frag");
-    unsigned int coinTex = loadImageToTexture("Resources/img.png");
-
-    potpisTex = loadImageToTexture("Resources/img.png");
+    // Every opaque mesh lives in one pool so each pass is a single VAO bind and multi-draw.
+    MeshPool meshPool;
+    initMeshPool(meshPool, 65536, 262144);
+    MeshRange cubeMesh = uploadTriangles(meshPool, vertices, 36);
+    MeshRange sphereMesh = createSphere(meshPool, 24, 24);
+    StreamRing frameRing;
+    initStreamRing(frameRing, 256 * 1024);
+    ThreadPool threads;
+    startThreadPool(threads);
+    ClusteredLights lights;
+    initClusteredLights(lights);
+    SpotShadow spotShadow;
+    initSpotShadow(spotShadow);
+    DrawList shadowCasters;
+
+    TransparencyPass glassPass;
+    initTransparencyPass(glassPass, cubeMesh);
+    DrawList drawList;
+    AABB sphereBounds; sphereBounds.min = glm::vec3(-1.0f); sphereBounds.max = glm::vec3(1.0f);
+
+    TransformHierarchy scene;
+    int roomRoot = addNode(scene, -1, glm::mat4(1.0f));
+    int nodeFloor = addNode(scene, roomRoot, glm::translate(glm::mat4(1.0f), glm::vec3(0, -0.01f, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(60.0f, 0.01f, 60.0f)));
+    int nodeWallBack = addNode(scene, roomRoot, glm::translate(glm::mat4(1.0f), glm::vec3(0, 15.0f, -20.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(60.0f, 30.0f, 0.2f)));
+    int nodeWallLeft = addNode(scene, roomRoot, glm::translate(glm::mat4(1.0f), glm::vec3(-30.0f, 15.0f, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.2f, 30.0f, 60.0f)));
+    int nodeWallRight = addNode(scene, roomRoot, glm::translate(glm::mat4(1.0f), glm::vec3(30.0f, 15.0f, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.2f, 30.0f, 60.0f)));
+    int nodeWallFront = addNode(scene, roomRoot, glm::translate(glm::mat4(1.0f), glm::vec3(0, 15.0f, 25.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(60.0f, 30.0f, 0.2f)));
+
+    int cabinetRoot = addNode(scene, -1, glm::mat4(1.0f));
+    int nodeCabinetBase = addNode(scene, cabinetRoot, glm::translate(glm::mat4(1.0f), glm::vec3(0, 0.05, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(4, 0.1, 4)));
+    int nodeCabinetBody = addNode(scene, cabinetRoot, glm::translate(glm::mat4(1.0f), glm::vec3(0.6f, 0.6f, 0.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(2.8f, 1.1f, 4.0f)));
+    int nodeChuteBlock = addNode(scene, cabinetRoot, glm::translate(glm::mat4(1.0f), glm::vec3(-1.4f, 0.6f, -0.75f)) * glm::scale(glm::mat4(1.0f), glm::vec3(1.2f, 1.1f, 2.5f)));
+    int nodeCabinetTop = addNode(scene, cabinetRoot, glm::translate(glm::mat4(1.0f), glm::vec3(0, 5, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(4, 0.4, 4)));
+    int nodeLamp = addNode(scene, cabinetRoot, glm::translate(glm::mat4(1.0f), glm::vec3(1.6, 4.8, 1.6)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.25)));
+
+    glm::vec3 joyBasePos = glm::vec3(1.1f, 1.1f, 2.2f);
+    float machineTopY = 1.15f;
+    glm::vec3 connStart = glm::vec3(1.1f, machineTopY + 0.005f, 2.01f);
+    glm::vec3 connEnd = glm::vec3(joyBasePos.x, joyBasePos.y - 0.15f, 2.05f);
+    glm::vec3 connMid = (connStart + connEnd) * 0.5f;
+    float connHeight = glm::distance(connStart, connEnd);
+    int nodeConnector = addNode(scene, cabinetRoot, glm::translate(glm::mat4(1.0f), connMid) * glm::scale(glm::mat4(1.0f), glm::vec3(0.04f, connHeight * 0.5f, 0.04f)));
+    int nodeMount = addNode(scene, cabinetRoot, glm::translate(glm::mat4(1.0f), glm::vec3(1.1f, machineTopY + 0.02f, 2.01f)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.18f, 0.02f, 0.03f)));
+    int nodeSlotBase = addNode(scene, cabinetRoot, glm::translate(glm::mat4(1.0f), glm::vec3(0.3f, 0.74f, 2.01f))
+        * glm::scale(glm::mat4(1.0f), glm::vec3(0.35f, 0.02f, 0.02f)));
+    int nodeSlotRim = addNode(scene, cabinetRoot, glm::translate(glm::mat4(1.0f), glm::vec3(0.3f, 0.755f, 2.01f))
+        * glm::scale(glm::mat4(1.0f), glm::vec3(0.38f, 0.01f, 0.022f)));
+    int nodeSlotInner = addNode(scene, cabinetRoot, glm::translate(glm::mat4(1.0f), glm::vec3(0.3f, 0.745f, 2.01f))
+        * glm::scale(glm::mat4(1.0f), glm::vec3(0.28f, 0.015f, 0.018f)));
+
+    int joyBase = addNode(scene, cabinetRoot, glm::translate(glm::mat4(1.0f), joyBasePos));
+    int joyHandle = addNode(scene, joyBase, glm::mat4(1.0f));
+    int nodeJoyStick = addNode(scene, joyHandle, glm::translate(glm::mat4(1.0f), glm::vec3(0, 0.25, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.05, 0.5, 0.05)));
+    int nodeJoyKnob = addNode(scene, joyHandle, glm::translate(glm::mat4(1.0f), glm::vec3(0, 0.5, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.2)));
+
+    int nodeRope = addNode(scene, -1, glm::mat4(1.0f));
+    int clawRoot = addNode(scene, -1, glm::translate(glm::mat4(1.0f), glm::vec3(clawX, clawY, clawZ)));
+    int nodeClawHead = addNode(scene, clawRoot, glm::scale(glm::mat4(1.0f), glm::vec3(0.4f, 0.2f, 0.4f)));
+    int fingerPivots[4], nodeFingerSegments[4], nodeFingerTips[4];
+    for (int i = 0; i < 4; i++) {
+        fingerPivots[i] = addNode(scene, clawRoot, glm::mat4(1.0f));
+        nodeFingerSegments[i] = addNode(scene, fingerPivots[i], glm::translate(glm::mat4(1.0f), glm::vec3(0, -0.2f, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.08f, 0.4f, 0.08f)));
+        nodeFingerTips[i] = addNode(scene, fingerPivots[i], glm::translate(glm::mat4(1.0f), glm::vec3(-0.05f, -0.4f, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.15f, 0.05f, 0.08f)));
+    }
+    updateWorldTransforms(scene);
+
+    std::vector<AABB> occluders;
+    for (int node : { nodeWallBack, nodeWallLeft, nodeWallRight, nodeWallFront, nodeCabinetBody, nodeChuteBlock, nodeCabinetTop })
+        occluders.push_back(transformAABB(AABB(), scene.world[node]));
+
+    OcclusionCuller occlusion;
+    startOcclusionCuller(occlusion, 256, 128);
+
+    ShaderLibrary shaders;
+    if (!initShaderLibrary(shaders, "Resources/shader.vert", "Resources/shader.frag")) return endProgram("Sejderi nisu ucitani.");
+    const uint32_t startupVariants[] = { surfaceVariant(false, true), surfaceVariant(true, true), surfaceVariant(false, false), surfaceVariant(true, false), shadowVariant(true) };
+    // Compiles run in the driver while textures and models load below.
+    const double shaderStart = glfwGetTime();
+    requestShaderVariants(shaders, startupVariants, 5);
+    TextureManager textures;
+    textures.cache.threads = &threads;
+    AssetManager assets;
+    startAssetManager(assets, meshPool, textures);
+    // Files are read and parsed on the asset thread while the driver compiles.
+    const AssetHandle toyAssets[2] = {
+        acquireModel(assets, {"Resources/Toy1/model.obj", "Resources/Toy1/toy.obj", "Resources/Toy1.obj"}),
+        acquireModel(assets, {"Resources/Toy2/model.obj", "Resources/Toy2/toy.obj", "Resources/Toy2.obj"})
+    };
+    AssetHandle coinAsset = acquireTexture(assets, "Resources/img.png");
+    AssetHandle signAsset = acquireTexture(assets, "Resources/img.png");
+
+    Model cubeModel;
+    cubeModel.mesh = cubeMesh;
+    cubeModel.hull = makeBoxHull(cubeModel.bounds);
+    std::vector<glm::vec3> cubeTriangles;
+    for (int i = 0; i < 36; ++i) cubeTriangles.push_back(glm::vec3(vertices[i * 8], vertices[i * 8 + 1], vertices[i * 8 + 2]));
+    buildMeshBvh(cubeModel.bvh, cubeTriangles);
+    AssetHandle cubeAsset = addBuiltinModel(assets, "cube", std::move(cubeModel));
+    Model sphereModel;
+    sphereModel.mesh = sphereMesh;
+    addBuiltinModel(assets, "sphere", std::move(sphereModel));
+
+    waitForAssets(assets);
+    TextureHandle coinTex = assetTexture(assets, coinAsset);
+    potpisTex = assetTexture(assets, signAsset);
+    std::vector<const Model*> prizeMeshes = { assetModel(assets, cubeAsset) };
+    for (AssetHandle toy : toyAssets) prizeMeshes.push_back(assetModel(assets, toy) ? assetModel(assets, toy) : prizeMeshes[0]);
+    std::cout << "Teksture: " << textures.stats.requests << " zahteva, " << textures.images.size() << " slika (" << textures.stats.packed << " u atlasu od "
+        << textures.layers.size() << " slojeva, " << textures.stats.standalone << " zasebno), deljeno po putanji " << textures.stats.pathHits
+        << ", po sadrzaju " << textures.stats.contentHits << "; " << (textures.stats.atlasBytes + textures.stats.standaloneBytes) / 1024 << " KB u VRAM, "
+        << textures.stats.arrays << " nizova za vezivanje" << std::endl;
+    if (textures.cache.stats.textures > 0)
+        std::cout << "Kompresovane teksture: " << textures.cache.stats.compressedBytes / 1024 << " KB u VRAM umesto " << textures.cache.stats.uncompressedBytes / 1024
+            << " KB kao RGBA8 (iz kesa " << textures.cache.stats.hits << ", kompresovano " << textures.cache.stats.misses << " za " << textures.cache.stats.encodeMs << " ms)" << std::endl;
+
+    size_t shadersPending = pollShaderVariants(shaders);
+    std::cout << "Sejderi: " << 5 - shadersPending << "/5 spremno posle ucitavanja modela (iz kesa " << shaders.cacheHits
+        << ", kompajlirano " << shaders.cacheMisses << ")" << std::endl;
+    // The first frame needs every startup variant anyway; waiting here gives the whole
+    // build one number to compare between a cold and a warm binary cache.
+    for (uint32_t variant : startupVariants) getShaderVariant(shaders, variant);
+    std::cout << "Sejderi za pokretanje: " << (glfwGetTime() - shaderStart) * 1000.0 << " ms od zahteva do poslednje varijante, "
+        << shaders.buildMs << " ms na glavnoj niti (iz kesa " << shaders.cacheHits << ", kompajlirano " << shaders.cacheMisses << ")" << std::endl;
+    printAssetReport(assets);
+
+    PrizeStore prizes;
+    struct PrizeSpawn { glm::vec3 pos; glm::vec3 color; uint32_t mesh; };
+    const PrizeSpawn spawns[] = {
+        {glm::vec3(0.3f, 1.15f, -0.4f), glm::vec3(0.1f, 0.5f, 0.8f), 1},
+        {glm::vec3(-0.3f, 1.15f, 0.2f), glm::vec3(0.9f, 0.2f, 0.2f), 2}
+    };
+    for (const PrizeSpawn& sp : spawns) {
+        if (assetModel(assets, toyAssets[sp.mesh - 1])) addPrize(prizes, prizeMeshes, sp.pos, sp.color, sp.mesh, glm::vec3(1.0f), SHAPE_HULL);
+        else addPrize(prizes, prizeMeshes, sp.pos, sp.color, 0, glm::vec3(0.5f, 0.4f, 0.5f));
+    }
 
-    toyModel1 = loadOBJWithCandidates({"Resources/Toy1/model.obj", "Resources/Toy1/toy.obj", "Resources/Toy1.obj", "Resources/Toy1/model.obj"});
-    toyModel2 = loadOBJWithCandidates({"Resources/Toy2/model.obj", "Resources/Toy2/toy.obj", "Resources/Toy2.obj", "Resources/Toy2/model.obj"});
+    PhysicsWorld physics;
+    initPhysicsWorld(physics, {
+        transformAABB(AABB(), scene.world[nodeCabinetBody]),
+        transformAABB(AABB(), scene.world[nodeChuteBlock]),
+        transformAABB(AABB(), scene.world[nodeCabinetTop]),
+        { glm::vec3(-2.0f, 0.1f, 0.5f), glm::vec3(-0.8f, 0.35f, 2.0f) },
+        { glm::vec3(1.95f, 0.1f, -2.15f), glm::vec3(2.15f, 4.8f, 2.15f) },
+        { glm::vec3(-2.15f, 0.1f, -2.15f), glm::vec3(-1.95f, 4.8f, 2.15f) },
+        { glm::vec3(-2.15f, 0.1f, 1.95f), glm::vec3(2.15f, 4.8f, 2.15f) },
+        { glm::vec3(-2.15f, 0.1f, -2.15f), glm::vec3(2.15f, 4.8f, -1.95f) }
+    });
+    HotReload hotReload;
+    watchFile(hotReload, "Resources/shader.vert", RELOAD_SHADER);
+    watchFile(hotReload, "Resources/shader.frag", RELOAD_SHADER);
+    watchFile(hotReload, "Resources/img.png", RELOAD_TEXTURE);
+    for (const Model* m : prizeMeshes)
+        if (!m->source.empty()) watchFile(hotReload, m->source, RELOAD_MODEL);
+    // Atlas slots take plain RGBA; only textures kept on their own use compressed chains.
+    hotReload.compressTextures = compressedTexturesSupported() && textures.stats.standalone > 0;
+    startHotReload(hotReload);
+    std::vector<ReloadedAsset> reloaded;
+
+    SceneBvh prizeBvh;
+    std::vector<uint32_t> fingerContacts;
+    const AABB chuteRegion = { glm::vec3(-2.0f, 0.0f, 0.5f), glm::vec3(-0.8f, 1.1f, 2.0f) };
 
     while (!glfwWindowShouldClose(window)) {
         double currentTime = glfwGetTime();
@@ -177,6 +296,27 @@ int main() {
         lastTime = currentTime;
 
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) break;
+        beginStreamFrame(frameRing);
+        if (!shaders.pending.empty()) pollShaderVariants(shaders);
+        updateAssets(assets);
+
+        // Reloads were prepared in the background; only the GL side is swapped in here,
+        // before anything of this frame is drawn.
+        if (takeReloadedAssets(hotReload, reloaded)) {
+            for (ReloadedAsset& asset : reloaded) {
+                if (asset.kind == RELOAD_SHADER) {
+                    bool vertex = asset.path == "Resources/shader.vert";
+                    reloadShaderStage(shaders, vertex ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER, asset.text);
+                } else if (asset.kind == RELOAD_TEXTURE) {
+                    reloadTexture(textures, asset.path, asset.hash, asset.image, asset.compressed);
+                } else if (reloadModelAsset(assets, asset.path, asset.model)) {
+                    // Prizes keep their own copy of the extents, taken when they were added.
+                    for (uint32_t mesh = 0; mesh < prizeMeshes.size(); ++mesh)
+                        if (prizeMeshes[mesh]->source == asset.path) refreshPrizeExtents(prizes, prizeMeshes, mesh);
+                }
+                std::cout << "Ponovo ucitano: " << asset.path << std::endl;
+            }
+        }
 
         static bool dPressed = false;
         if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS && !dPressed) {
@@ -202,16 +342,18 @@ int main() {
         glm::vec3 frontVec = glm::vec3(cos(glm::radians(yaw)) * cos(glm::radians(pitch)), sin(glm::radians(pitch)), sin(glm::radians(yaw)) * cos(glm::radians(pitch)));
         glm::mat4 view = glm::lookAt(orbitPos, orbitPos + frontVec, glm::vec3(0, 1, 0));
         glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)mode->width / (float)mode->height, 0.1f, 100.0f);
+        Frustum frustum = extractFrustum(projection * view);
+        CullStats cullStats;
+        beginOcclusionFrame(occlusion, projection * view, occluders);
 
         bool isFront = (cos(cameraAngle) > 0.7f);
         joystickRotX = 0.0f; joystickRotZ = 0.0f;
 
-        bool prizeInChute = false;
-        for (auto& t : toys) if (t.isDropped && !t.isTaken) prizeInChute = true;
+        bool prizeInChute = anyPrize(prizes, PRIZE_DROPPED, PRIZE_TAKEN);
 
         if (isFront && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
             if (currentState == WAITING_FOR_COIN) currentState = PLAYING;
-            for (auto& t : toys) if (t.isDropped && !t.isTaken) t.isTaken = true;
+            takeDroppedPrizes(prizes);
         }
 
         if (currentState == PLAYING && !movingDown && !movingUp) {
@@ -224,11 +366,7 @@ int main() {
             if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && !spaceWasPressed) {
                 if (!clawIsHolding) movingDown = true;
                 else {
-                    for (auto& t : toys) if (t.isCaught) {
-                        t.isCaught = false; t.isFalling = true;
-                        t.verticalVelocity = 0.0f;
-                        clawIsHolding = false;
-                    }
+                    if (releaseCaughtPrizes(prizes) > 0) clawIsHolding = false;
                     currentState = WAITING_FOR_COIN;
                 }
                 spaceWasPressed = true;
@@ -241,10 +379,19 @@ int main() {
             clawY -= 0.06f;
             if (clawY <= 1.7f) {
                 movingDown = false; movingUp = true;
-                for (auto& t : toys) {
-                    if (!t.isDropped && !t.isTaken && glm::distance(glm::vec2(clawX, clawZ), glm::vec2(t.pos.x, t.pos.z)) < 0.45f) {
-                        t.isCaught = true; clawIsHolding = true; break;
-                    }
+                buildPrizeBvh(prizes, prizeMeshes, prizeBvh);
+                fingerContacts.clear();
+                for (int i = 0; i < 4; i++) {
+                    glm::vec3 fingerBase = glm::vec3(scene.world[fingerPivots[i]] * glm::vec4(0, 0, 0, 1));
+                    glm::vec3 fingerTip = glm::vec3(scene.world[fingerPivots[i]] * glm::vec4(-0.05f, -0.4f, 0, 1));
+                    overlapsCapsule(prizeBvh, fingerBase, fingerTip, 0.06f, fingerContacts);
+                }
+                int grabbed = findMostTouchedPrize(prizes, fingerContacts);
+                // Fingers buried inside a toy touch no triangles, so fall back to the hull test.
+                AABB grabVolume = { glm::vec3(clawX - 0.3f, clawY - 0.6f, clawZ - 0.3f), glm::vec3(clawX + 0.3f, clawY, clawZ + 0.3f) };
+                if (grabbed < 0) grabbed = findPrizeInVolume(prizes, prizeMeshes, grabVolume);
+                if (grabbed >= 0) {
+                    prizes.flags[grabbed] |= PRIZE_CAUGHT; clawIsHolding = true;
                 }
             }
         }
@@ -252,51 +399,21 @@ int main() {
             clawY += 0.06f; if (clawY >= 4.3f) movingUp = false;
         }
 
-        for (int i = 0; i < (int)toys.size(); ++i) {
-            auto &t = toys[i];
-            if (t.isCaught) {
-                float halfH = 0.25f;
-                if (i == 0 && toyModel1.VAO != 0) halfH = toyModel1.halfHeight;
-                if (i == 1 && toyModel2.VAO != 0) halfH = toyModel2.halfHeight;
-
-                float baseOffset = 0.35f;
-                float modelScaleForAttach = 1.0f;
-                float offset = baseOffset + halfH * modelScaleForAttach * 0.6f;
-
-                glm::vec3 desiredPos = glm::vec3(clawX, clawY - offset, clawZ);
-
-                float lateralRadius = halfH * modelScaleForAttach * 0.8f;
-                glm::vec3 halfE = glm::vec3(0.25f);
-                if (i==0 && toyModel1.VAO!=0) halfE = toyModel1.halfExtents * modelScaleForAttach;
-                if (i==1 && toyModel2.VAO!=0) halfE = toyModel2.halfExtents * modelScaleForAttach;
-
-                float glassInset = 0.06f;
-                float minX = -1.95f + halfE.x + glassInset;
-                float maxX =  1.95f - halfE.x - glassInset;
-                float minZ = -1.95f + halfE.z + glassInset;
-                float maxZ =  1.95f - halfE.z - glassInset;
-
-                desiredPos.x = glm::clamp(desiredPos.x, minX, maxX);
-                desiredPos.z = glm::clamp(desiredPos.z, minZ, maxZ);
-
-                float topLimit = 6.8f;
-                float bottomLimit = 0.36f;
-                desiredPos.y = glm::clamp(desiredPos.y, bottomLimit + halfE.y, topLimit - halfE.y);
+        updateCaughtPrizes(prizes, glm::vec3(clawX, clawY, clawZ));
+        stepPhysics(physics, prizes, prizeMeshes, (float)frameTime);
+        markPrizesInside(prizes, chuteRegion, PRIZE_DROPPED);
 
-                float followLerp = 0.35f;
-                t.pos = glm::mix(t.pos, desiredPos, followLerp);
-            }
-
-            if (t.isFalling) {
-                t.verticalVelocity -= 0.015f;
-                t.pos.y += t.verticalVelocity;
-                float floorLevel = (t.pos.x < -0.8f && t.pos.z > 0.5f) ? 0.35f : 1.15f;
-                if (t.pos.y <= floorLevel) {
-                    t.pos.y = floorLevel; t.isFalling = false; t.verticalVelocity = 0;
-                    if (floorLevel < 1.0f) t.isDropped = true;
-                }
-            }
+        float fingerAngle = (clawIsHolding || movingDown) ? 15.0f : 45.0f;
+        float rLen = 5.0f - clawY;
+        setLocal(scene, clawRoot, glm::translate(glm::mat4(1.0f), glm::vec3(clawX, clawY, clawZ)));
+        setLocal(scene, nodeRope, glm::translate(glm::mat4(1.0f), glm::vec3(clawX, clawY + rLen / 2.0f, clawZ)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.02f, rLen, 0.02f)));
+        for (int i = 0; i < 4; i++) {
+            glm::mat4 fM = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0, -0.1f, 0)), glm::radians(i * 90.0f), glm::vec3(0, 1, 0));
+            setLocal(scene, fingerPivots[i], glm::rotate(glm::translate(fM, glm::vec3(0.15f, 0, 0)), glm::radians(fingerAngle), glm::vec3(0, 0, 1)));
         }
+        glm::mat4 handleRot = glm::rotate(glm::mat4(1.0f), glm::radians(joystickRotX), glm::vec3(1, 0, 0));
+        setLocal(scene, joyHandle, glm::rotate(handleRot, glm::radians(joystickRotZ), glm::vec3(0, 0, 1)));
+        updateWorldTransforms(scene);
 
         if (depthTestEnabled) glEnable(GL_DEPTH_TEST);
         else glDisable(GL_DEPTH_TEST);
@@ -306,33 +423,14 @@ int main() {
 
         glClearColor(0.4f, 0.5f, 0.6f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glUseProgram(shaderProgram);
-        glUniform1i(glGetUniformLocation(shaderProgram, "uTex"), 0);
-        glUniform3f(glGetUniformLocation(shaderProgram, "spotlightPos"), 1.6f, 4.8f, 1.6f);
-
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniform3f(glGetUniformLocation(shaderProgram, "lightPos"), 0.0f, 8.0f, 4.0f);
-        glUniform3f(glGetUniformLocation(shaderProgram, "lightColor"), 1.0f, 1.0f, 1.0f);
-
-        glUniform3f(glGetUniformLocation(shaderProgram, "viewPos"), orbitPos.x, orbitPos.y, orbitPos.z);
-        glUniform1f(glGetUniformLocation(shaderProgram, "shininess"), 64.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram, "specularStrength"), 0.6f);
-
-        glUniform3f(glGetUniformLocation(shaderProgram, "pointLightPos"), 0.0f, 5.0f, 1.5f);
-        glUniform3f(glGetUniformLocation(shaderProgram, "pointLightColor"), 0.9f, 0.85f, 0.8f);
-
-        drawObject(VAO, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(0, -0.01f, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(60.0f, 0.01f, 60.0f)), glm::vec3(0.15f, 0.05f, 0.1f));
-        drawObject(VAO, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(0, 15.0f, -20.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(60.0f, 30.0f, 0.2f)), glm::vec3(0.4f, 0.15f, 0.1f));
-        drawObject(VAO, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(-30.0f, 15.0f, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.2f, 30.0f, 60.0f)), glm::vec3(0.35f, 0.12f, 0.08f));
-        drawObject(VAO, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(30.0f, 15.0f, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.2f, 30.0f, 60.0f)), glm::vec3(0.35f, 0.12f, 0.08f));
-        drawObject(VAO, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(0, 15.0f, 25.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(60.0f, 30.0f, 0.2f)), glm::vec3(0.4f, 0.15f, 0.1f));
-
-        drawObject(VAO, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(0, 0.05, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(4, 0.1, 4)), glm::vec3(0.02));
-        drawObject(VAO, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(0.6f, 0.6f, 0.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(2.8f, 1.1f, 4.0f)), glm::vec3(0.5f, 0.05f, 0.05f));
-        drawObject(VAO, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(-1.4f, 0.6f, -0.75f)) * glm::scale(glm::mat4(1.0f), glm::vec3(1.2f, 1.1f, 2.5f)), glm::vec3(0.5f, 0.05f, 0.05f));
-
-        drawObject(VAO, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(0, 5, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(4, 0.4, 4)), glm::vec3(0.35, 0, 0));
+        FrameUniforms frame;
+        frame.view = view;
+        frame.projection = projection;
+        frame.viewPos = glm::vec4(orbitPos, 1.0f);
+        frame.lightPos = glm::vec4(0.0f, 8.0f, 4.0f, 1.0f);
+        frame.lightColor = glm::vec4(1.0f);
+        frame.ambientFill = glm::vec4(0.9f, 0.85f, 0.8f, 0.0f);
+        frame.material = glm::vec4(64.0f, 0.6f, 0.0f, 0.0f);
 
         glm::vec3 lampColor;
         if (prizeInChute) {
@@ -345,116 +443,172 @@ int main() {
         else {
             lampColor = glm::vec3(0, 0, 0);
         }
-        glUniform3f(glGetUniformLocation(shaderProgram, "lightColor"), lampColor.r, lampColor.g, lampColor.b);
 
-        glm::mat4 lampModelMat = glm::translate(glm::mat4(1.0f), glm::vec3(1.6, 4.8, 1.6)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.25));
-        if (sphereVAO != 0 && sphereVertexCount > 0) {
-            drawObject(sphereVAO, sphereVertexCount, shaderProgram, lampModelMat, lampColor);
+        clearLights(lights);
+        Light roomLight;
+        roomLight.position = glm::vec3(0.0f, 5.0f, 1.5f);
+        roomLight.radius = 30.0f;
+        roomLight.color = glm::vec3(0.9f, 0.85f, 0.8f);
+        addLight(lights, roomLight);
+        Light spotlight;
+        spotlight.position = glm::vec3(1.6f, 4.8f, 1.6f);
+        spotlight.radius = 12.0f;
+        spotlight.color = glm::vec3(2.0f, 2.0f, 1.6f);
+        spotlight.specular = 0.25f;
+        spotlight.spotCos = 0.95f;
+        const int spotlightIndex = (int)lights.lights.size();
+        addLight(lights, spotlight);
+        if (lampColor != glm::vec3(0.0f)) {
+            Light lampLight;
+            lampLight.position = glm::vec3(scene.world[nodeLamp][3]);
+            lampLight.radius = 2.0f;
+            lampLight.color = lampColor;
+            addLight(lights, lampLight);
+        }
+        assignLights(lights, threads, view, projection, 0.1f, 100.0f);
+        uploadLights(lights, frameRing, frame, mode->width, mode->height);
+
+        // The lamp and the cabinet top sit at the light and would cover the whole map.
+        setSpotShadowLight(spotShadow, spotlight);
+        if (!spotShadow.staticValid) {
+            for (int node : { nodeCabinetBase, nodeCabinetBody, nodeChuteBlock, nodeConnector, nodeMount })
+                queueDraw(shadowCasters, cubeMesh, scene.world[node], glm::vec3(0.0f));
+            renderStaticShadows(spotShadow, shadowCasters, meshPool, frameRing, shaders);
+        }
+        for (int node : { nodeClawHead, nodeRope, nodeJoyStick, nodeJoyKnob })
+            queueDraw(shadowCasters, cubeMesh, scene.world[node], glm::vec3(0.0f));
+        for (int i = 0; i < 4; i++) {
+            queueDraw(shadowCasters, cubeMesh, scene.world[nodeFingerSegments[i]], glm::vec3(0.0f));
+            queueDraw(shadowCasters, cubeMesh, scene.world[nodeFingerTips[i]], glm::vec3(0.0f));
+        }
+        queuePrizeDraws(prizes, prizeMeshes, shadowCasters);
+        renderDynamicShadows(spotShadow, shadowCasters, meshPool, frameRing, shaders);
+        bindSpotShadow(spotShadow, frame, spotlightIndex);
+        bindFrameUniforms(frameRing, frame);
+
+        queueDraw(drawList, cubeMesh, scene.world[nodeFloor], glm::vec3(0.15f, 0.05f, 0.1f));
+        queueDraw(drawList, cubeMesh, scene.world[nodeWallBack], glm::vec3(0.4f, 0.15f, 0.1f));
+        queueDraw(drawList, cubeMesh, scene.world[nodeWallLeft], glm::vec3(0.35f, 0.12f, 0.08f));
+        queueDraw(drawList, cubeMesh, scene.world[nodeWallRight], glm::vec3(0.35f, 0.12f, 0.08f));
+        queueDraw(drawList, cubeMesh, scene.world[nodeWallFront], glm::vec3(0.4f, 0.15f, 0.1f));
+
+        queueDraw(drawList, cubeMesh, scene.world[nodeCabinetBase], glm::vec3(0.02));
+        queueDraw(drawList, cubeMesh, scene.world[nodeCabinetBody], glm::vec3(0.5f, 0.05f, 0.05f));
+        queueDraw(drawList, cubeMesh, scene.world[nodeChuteBlock], glm::vec3(0.5f, 0.05f, 0.05f));
+
+        queueDraw(drawList, cubeMesh, scene.world[nodeCabinetTop], glm::vec3(0.35, 0, 0));
+
+        cullDrawList(drawList, frustum, cullStats);
+        cullStats.occluded += cullOccluded(occlusion, drawList.bounds);
+        buildDrawCommands(drawList, frustum, orbitPos, cullStats);
+        submitDrawList(drawList, meshPool, frameRing, shaders);
+        clearDrawList(drawList);
+        frame.lightColor = glm::vec4(lampColor, 1.0f);
+        bindFrameUniforms(frameRing, frame);
+
+        if (sphereMesh.indexCount > 0) {
+            queueDraw(drawList, sphereMesh, scene.world[nodeLamp], lampColor, 1.0f, nullptr, sphereBounds);
         } else {
-            drawObject(VAO, shaderProgram, lampModelMat, lampColor);
+            queueDraw(drawList, cubeMesh, scene.world[nodeLamp], lampColor);
         }
 
-        glm::vec3 joyBasePos = glm::vec3(1.1f, 1.1f, 2.2f);
-
-        float machineTopY = 1.15f;
-        glm::vec3 connStart = glm::vec3(1.1f, machineTopY + 0.005f, 2.01f);
-        glm::vec3 connEnd = glm::vec3(joyBasePos.x, joyBasePos.y - 0.15f, 2.05f);
-        glm::vec3 connMid = (connStart + connEnd) * 0.5f;
-        float connHeight = glm::distance(connStart, connEnd);
-        glm::mat4 connModel = glm::translate(glm::mat4(1.0f), connMid) * glm::scale(glm::mat4(1.0f), glm::vec3(0.04f, connHeight * 0.5f, 0.04f));
-        drawObject(VAO, shaderProgram, connModel, glm::vec3(0.2f, 0.2f, 0.2f));
-
-        glm::mat4 mount = glm::translate(glm::mat4(1.0f), glm::vec3(1.1f, machineTopY + 0.02f, 2.01f)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.18f, 0.02f, 0.03f));
-        drawObject(VAO, shaderProgram, mount, glm::vec3(0.15f, 0.15f, 0.15f));
-
-        glm::mat4 joyBase = glm::translate(glm::mat4(1.0f), joyBasePos);
-        glm::mat4 joyHandle = glm::rotate(joyBase, glm::radians(joystickRotX), glm::vec3(1, 0, 0));
-        joyHandle = glm::rotate(joyHandle, glm::radians(joystickRotZ), glm::vec3(0, 0, 1));
-        drawObject(VAO, shaderProgram, joyHandle * glm::translate(glm::mat4(1.0f), glm::vec3(0, 0.25, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.05, 0.5, 0.05)), glm::vec3(0.1));
-        drawObject(VAO, shaderProgram, joyHandle * glm::translate(glm::mat4(1.0f), glm::vec3(0, 0.5, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.2)), glm::vec3(0.8, 0, 0));
-
-        if (coinTex != 0) {
-            glm::mat4 slotBase = glm::translate(glm::mat4(1.0f), glm::vec3(0.3f, 0.74f, 2.01f))
-                * glm::scale(glm::mat4(1.0f), glm::vec3(0.35f, 0.02f, 0.02f));
-            drawObject(VAO, shaderProgram, slotBase, glm::vec3(0.06f, 0.06f, 0.06f));
-
-            glm::mat4 slotRim = glm::translate(glm::mat4(1.0f), glm::vec3(0.3f, 0.755f, 2.01f))
-                * glm::scale(glm::mat4(1.0f), glm::vec3(0.38f, 0.01f, 0.022f));
-            drawObject(VAO, shaderProgram, slotRim, glm::vec3(0.6f, 0.6f, 0.6f));
-
-            glm::mat4 slotInner = glm::translate(glm::mat4(1.0f), glm::vec3(0.3f, 0.745f, 2.01f))
-                * glm::scale(glm::mat4(1.0f), glm::vec3(0.28f, 0.015f, 0.018f));
-            drawObject(VAO, shaderProgram, slotInner, glm::vec3(0.12f, 0.12f, 0.12f));
+        queueDraw(drawList, cubeMesh, scene.world[nodeConnector], glm::vec3(0.2f, 0.2f, 0.2f));
+        queueDraw(drawList, cubeMesh, scene.world[nodeMount], glm::vec3(0.15f, 0.15f, 0.15f));
+
+        queueDraw(drawList, cubeMesh, scene.world[nodeJoyStick], glm::vec3(0.1));
+        queueDraw(drawList, cubeMesh, scene.world[nodeJoyKnob], glm::vec3(0.8, 0, 0));
+
+        if (coinTex != kNoTexture) {
+            queueDraw(drawList, cubeMesh, scene.world[nodeSlotBase], glm::vec3(0.06f, 0.06f, 0.06f));
+            queueDraw(drawList, cubeMesh, scene.world[nodeSlotRim], glm::vec3(0.6f, 0.6f, 0.6f));
+            queueDraw(drawList, cubeMesh, scene.world[nodeSlotInner], glm::vec3(0.12f, 0.12f, 0.12f));
         }
 
-        drawObject(VAO, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(clawX, clawY, clawZ)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.4f, 0.2f, 0.4f)), glm::vec3(0.7f, 0.7f, 0.75f));
-        float rLen = 5.0f - clawY;
-        drawObject(VAO, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(clawX, clawY + rLen / 2.0f, clawZ)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.02f, rLen, 0.02f)), glm::vec3(0.2f));
+        queueDraw(drawList, cubeMesh, scene.world[nodeClawHead], glm::vec3(0.7f, 0.7f, 0.75f));
+        queueDraw(drawList, cubeMesh, scene.world[nodeRope], glm::vec3(0.2f));
 
-        float fingerAngle = (clawIsHolding || movingDown) ? 15.0f : 45.0f;
         for (int i = 0; i < 4; i++) {
-            glm::mat4 fM = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(clawX, clawY - 0.1f, clawZ)), glm::radians(i * 90.0f), glm::vec3(0, 1, 0));
-            fM = glm::rotate(glm::translate(fM, glm::vec3(0.15f, 0, 0)), glm::radians(fingerAngle), glm::vec3(0, 0, 1));
-            drawObject(VAO, shaderProgram, fM * glm::translate(glm::mat4(1.0f), glm::vec3(0, -0.2f, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.08f, 0.4f, 0.08f)), glm::vec3(0.5f, 0.5f, 0.55f));
-            drawObject(VAO, shaderProgram, fM * glm::translate(glm::mat4(1.0f), glm::vec3(-0.05f, -0.4f, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.15f, 0.05f, 0.08f)), glm::vec3(0.4f, 0.4f, 0.4f));
+            queueDraw(drawList, cubeMesh, scene.world[nodeFingerSegments[i]], glm::vec3(0.5f, 0.5f, 0.55f));
+            queueDraw(drawList, cubeMesh, scene.world[nodeFingerTips[i]], glm::vec3(0.4f, 0.4f, 0.4f));
         }
 
-        for (int i=0;i<toys.size();++i) {
-            auto &t = toys[i];
-            if (t.isTaken) continue;
-            float modelScale = 1.0f;
-            float extraYOffset = 0.01f;
-            if (i==0 && toyModel1.VAO!=0) {
-                glm::mat4 modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(t.pos.x, t.pos.y + toyModel1.halfHeight * modelScale + extraYOffset, t.pos.z))
-                    * glm::scale(glm::mat4(1.0f), glm::vec3(modelScale));
-                drawObject(toyModel1.VAO, toyModel1.vertexCount, shaderProgram, modelMat, t.color);
-            } else if (i==1 && toyModel2.VAO!=0) {
-                glm::mat4 modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(t.pos.x, t.pos.y + toyModel2.halfHeight * modelScale + extraYOffset, t.pos.z))
-                    * glm::scale(glm::mat4(1.0f), glm::vec3(modelScale));
-                drawObject(toyModel2.VAO, toyModel2.vertexCount, shaderProgram, modelMat, t.color);
-            } else {
-                glm::mat4 modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(t.pos.x, t.pos.y + 0.25f + extraYOffset, t.pos.z)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.5, 0.4, 0.5));
-                drawObject(VAO, 36, shaderProgram, modelMat, t.color);
-            }
+        queuePrizeDraws(prizes, prizeMeshes, drawList);
+
+        cullDrawList(drawList, frustum, cullStats);
+        cullStats.occluded += cullOccluded(occlusion, drawList.bounds);
+        buildDrawCommands(drawList, frustum, orbitPos, cullStats);
+        submitDrawList(drawList, meshPool, frameRing, shaders);
+        clearDrawList(drawList);
+
+        addTransparentInstance(glassPass, glm::translate(glm::mat4(1.0f), glm::vec3(0, 3, -1.95)) * glm::scale(glm::mat4(1.0f), glm::vec3(3.9, 3.8, 0.01)), glm::vec3(0.7, 0.8, 1.0), 0.15f);
+        addTransparentInstance(glassPass, glm::translate(glm::mat4(1.0f), glm::vec3(1.95, 3, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.01, 3.8, 3.9)), glm::vec3(0.7, 0.8, 1.0), 0.15f);
+        addTransparentInstance(glassPass, glm::translate(glm::mat4(1.0f), glm::vec3(-1.95, 3, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.01, 3.8, 3.9)), glm::vec3(0.7, 0.8, 1.0), 0.15f);
+        addTransparentInstance(glassPass, glm::translate(glm::mat4(1.0f), glm::vec3(0, 3, 1.95)) * glm::scale(glm::mat4(1.0f), glm::vec3(3.9, 3.8, 0.01)), glm::vec3(0.7, 0.8f, 1.0), 0.15f);
+        cullTransparencyPass(glassPass, frustum, cullStats);
+        drawTransparencyPass(glassPass, meshPool, frameRing, shaders, view);
+
+        static bool statsPressed = false;
+        if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS && !statsPressed) {
+            std::cout << "Culling: " << cullStats.culled << "/" << cullStats.tested << " objekata van kadra, " << cullStats.occluded << " zaklonjeno" << std::endl;
+            std::cout << "Mesleti: " << cullStats.clustersCulled << "/" << cullStats.clusters << " odbaceno" << std::endl;
+            std::cout << "Svetla: " << lights.stats.lights << ", " << lights.stats.references << " referenci u klasterima, najvise " << lights.stats.maxPerCluster
+                << " po klasteru, dodela " << lights.stats.assignMs << " ms" << std::endl;
+            std::cout << "Stream bafer: " << frameRing.stalls << " cekanja na GPU" << std::endl;
+            std::cout << "Sejderi: " << shaders.programs.size() << " varijanti, " << shaders.pending.size() << " u izradi, " << shaders.buildMs
+                << " ms na glavnoj niti (iz kesa " << shaders.cacheHits << ", kompajlirano " << shaders.cacheMisses << ")" << std::endl;
+            std::cout << "Senke: staticki sloj " << spotShadow.stats.staticRenders << "x, dinamicki " << spotShadow.stats.dynamicRenders << "x, ponovo iskorisceno "
+                << spotShadow.stats.reused << "x, " << spotShadow.stats.casters << " bacaca, " << spotShadow.stats.renderMs << " ms" << std::endl;
+            printAssetReport(assets);
+            std::cout << "Fizika: " << physics.stats.awake << "/" << physics.stats.bodies << " budnih tela, " << physics.stats.contacts << " kontakata, " << physics.stats.islands << " ostrva" << std::endl;
+            statsPressed = true;
+        }
+        if (glfwGetKey(window, GLFW_KEY_3) == GLFW_RELEASE) {
+            statsPressed = false;
         }
-
-        glDepthMask(GL_FALSE);
-        drawObject(VAO, 36, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(0, 3, -1.95)) * glm::scale(glm::mat4(1.0f), glm::vec3(3.9, 3.8, 0.01)), glm::vec3(0.7, 0.8, 1.0), 0.15f);
-        drawObject(VAO, 36, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(1.95, 3, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.01, 3.8, 3.9)), glm::vec3(0.7, 0.8, 1.0), 0.15f);
-        drawObject(VAO, 36, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(-1.95, 3, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.01, 3.8, 3.9)), glm::vec3(0.7, 0.8, 1.0), 0.15f);
-        drawObject(VAO, 36, shaderProgram, glm::translate(glm::mat4(1.0f), glm::vec3(0, 3, 1.95)) * glm::scale(glm::mat4(1.0f), glm::vec3(3.9, 3.8, 0.01)), glm::vec3(0.7, 0.8f, 1.0), 0.15f);
-        glDepthMask(GL_TRUE);
 
         glDisable(GL_DEPTH_TEST);
-        glUseProgram(shaderProgram);
+        unsigned int overlayShader = useShaderVariant(shaders, surfaceVariant(true, false));
 
         glm::mat4 identity = glm::mat4(1.0f);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(identity));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(identity));
+        frame.view = identity;
+        frame.projection = identity;
+        bindFrameUniforms(frameRing, frame);
 
         glm::mat4 modelSign = glm::translate(identity, glm::vec3(0.65f, 0.8f, 0.0f))
             * glm::scale(identity, glm::vec3(0.4f, 0.2f, 1.0f));
 
-        glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), 1.0f, 1.0f, 1.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram, "alpha"), 0.8f);
-        glUniform1i(glGetUniformLocation(shaderProgram, "useTexture"), true);
+        glUniform3f(glGetUniformLocation(overlayShader, "objectColor"), 1.0f, 1.0f, 1.0f);
+        glUniform1f(glGetUniformLocation(overlayShader, "alpha"), 0.8f);
 
+        const TextureRegion& sign = textureRegion(textures, potpisTex);
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, potpisTex);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, sign.texture);
+        glUniform4fv(glGetUniformLocation(overlayShader, "texRect"), 1, glm::value_ptr(sign.rect));
+        glUniform1f(glGetUniformLocation(overlayShader, "texLayer"), sign.layer);
 
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(modelSign));
+        glUniformMatrix4fv(glGetUniformLocation(overlayShader, "model"), 1, GL_FALSE, glm::value_ptr(modelSign));
 
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        glBindVertexArray(meshPool.VAO);
+        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)cubeMesh.indexCount, GL_UNSIGNED_INT, (const void*)(size_t)(cubeMesh.firstIndex * sizeof(uint32_t)), (GLint)cubeMesh.firstVertex);
+        glBindVertexArray(0);
 
         glEnable(GL_DEPTH_TEST);
 
+        endStreamFrame(frameRing);
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
-    glDeleteProgram(shaderProgram); glDeleteTextures(1, &coinTex);
-    glDeleteVertexArrays(1, &VAO); glDeleteBuffers(1, &VBO);
+    stopHotReload(hotReload);
+    stopAssetManager(assets);
+    stopOcclusionCuller(occlusion);
+    deleteTransparencyPass(glassPass);
+    deleteStreamRing(frameRing);
+    deleteClusteredLights(lights);
+    deleteSpotShadow(spotShadow);
+    stopThreadPool(threads);
+    deleteMeshPool(meshPool);
+    deleteShaderLibrary(shaders); deleteTextureManager(textures);
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,448 @@
+#include "../Header/MathBatch.h"
+#include "../Header/Simd.h"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+inline const float* matrixData(const glm::mat4* models) {
+    return reinterpret_cast<const float*>(models);
+}
+
+inline const float* boundsData(const AABB* local) {
+    return reinterpret_cast<const float*>(local);
+}
+
+void appendBounds(BoundsBatch& out, size_t n, float* center[3], float* extent[3]) {
+    const size_t base = out.count;
+    std::vector<float>* c[3] = { &out.centerX, &out.centerY, &out.centerZ };
+    std::vector<float>* e[3] = { &out.extentX, &out.extentY, &out.extentZ };
+    for (int a = 0; a < 3; ++a) {
+        c[a]->resize(base + n);
+        e[a]->resize(base + n);
+        center[a] = c[a]->data() + base;
+        extent[a] = e[a]->data() + base;
+    }
+    out.visible.resize(base);
+    out.visible.resize(base + n, 1);
+    out.count = base + n;
+}
+
+#if KANDZA_SIMD_X86
+void composeSSE(const TRSBatch& b, size_t end, glm::mat4* out) {
+    const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), zero = _mm_setzero_ps();
+    for (size_t i = 0; i + 4 <= end; i += 4) {
+        __m128 x = _mm_loadu_ps(&b.qx[i]), y = _mm_loadu_ps(&b.qy[i]), z = _mm_loadu_ps(&b.qz[i]), w = _mm_loadu_ps(&b.qw[i]);
+        __m128 sx = _mm_loadu_ps(&b.sx[i]), sy = _mm_loadu_ps(&b.sy[i]), sz = _mm_loadu_ps(&b.sz[i]);
+        __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+        __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+        __m128 c0[4] = {
+            _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+            _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+            _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+            zero };
+        __m128 c1[4] = {
+            _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+            _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+            zero };
+        __m128 c2[4] = {
+            _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+            _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+            zero };
+        __m128 c3[4] = { _mm_loadu_ps(&b.px[i]), _mm_loadu_ps(&b.py[i]), _mm_loadu_ps(&b.pz[i]), one };
+
+        __m128* cols[4] = { c0, c1, c2, c3 };
+        for (int c = 0; c < 4; ++c) {
+            __m128* r = cols[c];
+            _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+            for (int k = 0; k < 4; ++k) _mm_storeu_ps(&out[i + k][c][0], r[k]);
+        }
+    }
+}
+
+void transformSSE(const glm::mat4* models, const AABB* local, size_t end, float* center[3], float* extent[3]) {
+    const __m128 signMask = _mm_set1_ps(-0.0f), half = _mm_set1_ps(0.5f);
+    const float* m = matrixData(models);
+    const float* l = boundsData(local);
+    for (size_t i = 0; i + 4 <= end; i += 4) {
+        __m128 me[12];
+        for (int e = 0; e < 12; ++e) {
+            int col = e / 3, row = e % 3;
+            int idx = col * 4 + row;
+            me[e] = _mm_setr_ps(m[(i) * 16 + idx], m[(i + 1) * 16 + idx], m[(i + 2) * 16 + idx], m[(i + 3) * 16 + idx]);
+        }
+        __m128 lc[3], le[3];
+        for (int a = 0; a < 3; ++a) {
+            __m128 lo = _mm_setr_ps(l[i * 6 + a], l[(i + 1) * 6 + a], l[(i + 2) * 6 + a], l[(i + 3) * 6 + a]);
+            __m128 hi = _mm_setr_ps(l[i * 6 + 3 + a], l[(i + 1) * 6 + 3 + a], l[(i + 2) * 6 + 3 + a], l[(i + 3) * 6 + 3 + a]);
+            lc[a] = _mm_mul_ps(_mm_add_ps(lo, hi), half);
+            le[a] = _mm_mul_ps(_mm_sub_ps(hi, lo), half);
+        }
+        for (int r = 0; r < 3; ++r) {
+            __m128 c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(me[r], lc[0]), _mm_mul_ps(me[3 + r], lc[1])), _mm_add_ps(_mm_mul_ps(me[6 + r], lc[2]), me[9 + r]));
+            __m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, me[r]), le[0]), _mm_mul_ps(_mm_andnot_ps(signMask, me[3 + r]), le[1])),
+                _mm_mul_ps(_mm_andnot_ps(signMask, me[6 + r]), le[2]));
+            _mm_storeu_ps(center[r] + i, c);
+            _mm_storeu_ps(extent[r] + i, e);
+        }
+    }
+}
+
+void normalSSE(const glm::mat4* models, glm::mat3* out, size_t end) {
+    const float* m = matrixData(models);
+    alignas(16) float tmp[9][4];
+    for (size_t i = 0; i + 4 <= end; i += 4) {
+        __m128 a[3], b[3], c[3];
+        for (int r = 0; r < 3; ++r) {
+            a[r] = _mm_setr_ps(m[i * 16 + r], m[(i + 1) * 16 + r], m[(i + 2) * 16 + r], m[(i + 3) * 16 + r]);
+            b[r] = _mm_setr_ps(m[i * 16 + 4 + r], m[(i + 1) * 16 + 4 + r], m[(i + 2) * 16 + 4 + r], m[(i + 3) * 16 + 4 + r]);
+            c[r] = _mm_setr_ps(m[i * 16 + 8 + r], m[(i + 1) * 16 + 8 + r], m[(i + 2) * 16 + 8 + r], m[(i + 3) * 16 + 8 + r]);
+        }
+        // Columns of the normal matrix are the cofactor rows: b x c, c x a, a x b over det.
+        __m128 n[9];
+        const __m128* pairs[3][2] = { { b, c }, { c, a }, { a, b } };
+        for (int col = 0; col < 3; ++col) {
+            const __m128* u = pairs[col][0];
+            const __m128* v = pairs[col][1];
+            n[col * 3] = _mm_sub_ps(_mm_mul_ps(u[1], v[2]), _mm_mul_ps(u[2], v[1]));
+            n[col * 3 + 1] = _mm_sub_ps(_mm_mul_ps(u[2], v[0]), _mm_mul_ps(u[0], v[2]));
+            n[col * 3 + 2] = _mm_sub_ps(_mm_mul_ps(u[0], v[1]), _mm_mul_ps(u[1], v[0]));
+        }
+        __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], n[0]), _mm_mul_ps(a[1], n[1])), _mm_mul_ps(a[2], n[2]));
+        __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+        for (int e = 0; e < 9; ++e) _mm_store_ps(tmp[e], _mm_mul_ps(n[e], invDet));
+        for (int k = 0; k < 4; ++k) {
+            float* dst = &out[i + k][0][0];
+            for (int e = 0; e < 9; ++e) dst[e] = tmp[e][k];
+        }
+    }
+}
+
+float horizontalMin(__m128 v) {
+    v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_min_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+float horizontalMax(__m128 v) {
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+size_t minMaxSSE(const float* v, size_t count, float& lo, float& hi) {
+    if (count < 4) return 0;
+    __m128 mn = _mm_loadu_ps(v), mx = mn;
+    size_t i = 4;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(v + i);
+        mn = _mm_min_ps(mn, x);
+        mx = _mm_max_ps(mx, x);
+    }
+    lo = horizontalMin(mn);
+    hi = horizontalMax(mx);
+    return i;
+}
+
+size_t offsetScaleSSE(float* v, size_t count, float offset, float scale) {
+    const __m128 o = _mm_set1_ps(offset), s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) _mm_storeu_ps(v + i, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(v + i), o), s));
+    return i;
+}
+
+size_t flatNormalsSSE(const float* x, const float* y, const float* z, float* nx, float* ny, float* nz, size_t triangles) {
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    alignas(16) float out[3][4];
+    size_t t = 0;
+    for (; t + 4 <= triangles; t += 4) {
+        const size_t b = t * 3;
+        __m128 p[3][3];
+        const float* src[3] = { x, y, z };
+        for (int a = 0; a < 3; ++a)
+            for (int k = 0; k < 3; ++k)
+                p[k][a] = _mm_setr_ps(src[a][b + k], src[a][b + 3 + k], src[a][b + 6 + k], src[a][b + 9 + k]);
+        __m128 e1[3], e2[3];
+        for (int a = 0; a < 3; ++a) { e1[a] = _mm_sub_ps(p[1][a], p[0][a]); e2[a] = _mm_sub_ps(p[2][a], p[0][a]); }
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(e1[1], e2[2]), _mm_mul_ps(e1[2], e2[1]));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(e1[2], e2[0]), _mm_mul_ps(e1[0], e2[2]));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(e1[0], e2[1]), _mm_mul_ps(e1[1], e2[0]));
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz));
+        __m128 valid = _mm_cmpgt_ps(len2, zero);
+        __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(len2));
+        _mm_store_ps(out[0], _mm_and_ps(valid, _mm_mul_ps(cx, inv)));
+        _mm_store_ps(out[1], _mm_or_ps(_mm_and_ps(valid, _mm_mul_ps(cy, inv)), _mm_andnot_ps(valid, one)));
+        _mm_store_ps(out[2], _mm_and_ps(valid, _mm_mul_ps(cz, inv)));
+        for (int k = 0; k < 4; ++k)
+            for (int v = 0; v < 3; ++v) {
+                nx[b + k * 3 + v] = out[0][k];
+                ny[b + k * 3 + v] = out[1][k];
+                nz[b + k * 3 + v] = out[2][k];
+            }
+    }
+    return t;
+}
+
+KANDZA_TARGET_AVX2 void storeColumns8(__m256 r0, __m256 r1, __m256 r2, __m256 r3, glm::mat4* out, int col) {
+    // 4x4 transpose inside each 128-bit half: the low half holds lanes 0-3, the high half 4-7.
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3), t3 = _mm256_unpackhi_ps(r2, r3);
+    __m256 v0 = _mm256_shuffle_ps(t0, t2, 0x44), v1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+    __m256 v2 = _mm256_shuffle_ps(t1, t3, 0x44), v3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+    __m256 v[4] = { v0, v1, v2, v3 };
+    for (int k = 0; k < 4; ++k) {
+        _mm_storeu_ps(&out[k][col][0], _mm256_castps256_ps128(v[k]));
+        _mm_storeu_ps(&out[k + 4][col][0], _mm256_extractf128_ps(v[k], 1));
+    }
+}
+
+KANDZA_TARGET_AVX2 void composeAVX2(const TRSBatch& b, size_t end, glm::mat4* out) {
+    const __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f), zero = _mm256_setzero_ps();
+    for (size_t i = 0; i + 8 <= end; i += 8) {
+        __m256 x = _mm256_loadu_ps(&b.qx[i]), y = _mm256_loadu_ps(&b.qy[i]), z = _mm256_loadu_ps(&b.qz[i]), w = _mm256_loadu_ps(&b.qw[i]);
+        __m256 sx = _mm256_loadu_ps(&b.sx[i]), sy = _mm256_loadu_ps(&b.sy[i]), sz = _mm256_loadu_ps(&b.sz[i]);
+        __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+        __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+        __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+        storeColumns8(_mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx), zero, out + i, 0);
+        storeColumns8(_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+            _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy), zero, out + i, 1);
+        storeColumns8(_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+            _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz), zero, out + i, 2);
+        storeColumns8(_mm256_loadu_ps(&b.px[i]), _mm256_loadu_ps(&b.py[i]), _mm256_loadu_ps(&b.pz[i]), one, out + i, 3);
+    }
+}
+
+KANDZA_TARGET_AVX2 void transformAVX2(const glm::mat4* models, const AABB* local, size_t end, float* center[3], float* extent[3]) {
+    const __m256 signMask = _mm256_set1_ps(-0.0f), half = _mm256_set1_ps(0.5f);
+    const __m256i matIdx = _mm256_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112);
+    const __m256i boxIdx = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+    for (size_t i = 0; i + 8 <= end; i += 8) {
+        const float* m = matrixData(models + i);
+        const float* l = boundsData(local + i);
+        __m256 me[12];
+        for (int e = 0; e < 12; ++e) me[e] = _mm256_i32gather_ps(m + (e / 3) * 4 + e % 3, matIdx, 4);
+        __m256 lc[3], le[3];
+        for (int a = 0; a < 3; ++a) {
+            __m256 lo = _mm256_i32gather_ps(l + a, boxIdx, 4);
+            __m256 hi = _mm256_i32gather_ps(l + 3 + a, boxIdx, 4);
+            lc[a] = _mm256_mul_ps(_mm256_add_ps(lo, hi), half);
+            le[a] = _mm256_mul_ps(_mm256_sub_ps(hi, lo), half);
+        }
+        for (int r = 0; r < 3; ++r) {
+            __m256 c = _mm256_fmadd_ps(me[r], lc[0], _mm256_fmadd_ps(me[3 + r], lc[1], _mm256_fmadd_ps(me[6 + r], lc[2], me[9 + r])));
+            __m256 e = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, me[r]), le[0],
+                _mm256_fmadd_ps(_mm256_andnot_ps(signMask, me[3 + r]), le[1], _mm256_mul_ps(_mm256_andnot_ps(signMask, me[6 + r]), le[2])));
+            _mm256_storeu_ps(center[r] + i, c);
+            _mm256_storeu_ps(extent[r] + i, e);
+        }
+    }
+}
+
+KANDZA_TARGET_AVX2 void normalAVX2(const glm::mat4* models, glm::mat3* out, size_t end) {
+    const __m256i matIdx = _mm256_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112);
+    alignas(32) float tmp[9][8];
+    for (size_t i = 0; i + 8 <= end; i += 8) {
+        const float* m = matrixData(models + i);
+        __m256 a[3], b[3], c[3];
+        for (int r = 0; r < 3; ++r) {
+            a[r] = _mm256_i32gather_ps(m + r, matIdx, 4);
+            b[r] = _mm256_i32gather_ps(m + 4 + r, matIdx, 4);
+            c[r] = _mm256_i32gather_ps(m + 8 + r, matIdx, 4);
+        }
+        __m256 n[9];
+        const __m256* pairs[3][2] = { { b, c }, { c, a }, { a, b } };
+        for (int col = 0; col < 3; ++col) {
+            const __m256* u = pairs[col][0];
+            const __m256* v = pairs[col][1];
+            n[col * 3] = _mm256_fmsub_ps(u[1], v[2], _mm256_mul_ps(u[2], v[1]));
+            n[col * 3 + 1] = _mm256_fmsub_ps(u[2], v[0], _mm256_mul_ps(u[0], v[2]));
+            n[col * 3 + 2] = _mm256_fmsub_ps(u[0], v[1], _mm256_mul_ps(u[1], v[0]));
+        }
+        __m256 det = _mm256_fmadd_ps(a[0], n[0], _mm256_fmadd_ps(a[1], n[1], _mm256_mul_ps(a[2], n[2])));
+        __m256 invDet = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+        for (int e = 0; e < 9; ++e) _mm256_store_ps(tmp[e], _mm256_mul_ps(n[e], invDet));
+        for (int k = 0; k < 8; ++k) {
+            float* dst = &out[i + k][0][0];
+            for (int e = 0; e < 9; ++e) dst[e] = tmp[e][k];
+        }
+    }
+}
+
+KANDZA_TARGET_AVX2 size_t minMaxAVX2(const float* v, size_t count, float& lo, float& hi) {
+    if (count < 8) return 0;
+    __m256 mn = _mm256_loadu_ps(v), mx = mn;
+    size_t i = 8;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(v + i);
+        mn = _mm256_min_ps(mn, x);
+        mx = _mm256_max_ps(mx, x);
+    }
+    lo = horizontalMin(_mm_min_ps(_mm256_castps256_ps128(mn), _mm256_extractf128_ps(mn, 1)));
+    hi = horizontalMax(_mm_max_ps(_mm256_castps256_ps128(mx), _mm256_extractf128_ps(mx, 1)));
+    return i;
+}
+
+KANDZA_TARGET_AVX2 size_t offsetScaleAVX2(float* v, size_t count, float offset, float scale) {
+    const __m256 o = _mm256_set1_ps(offset), s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) _mm256_storeu_ps(v + i, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(v + i), o), s));
+    return i;
+}
+
+KANDZA_TARGET_AVX2 size_t flatNormalsAVX2(const float* x, const float* y, const float* z, float* nx, float* ny, float* nz, size_t triangles) {
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    alignas(32) float out[3][8];
+    size_t t = 0;
+    for (; t + 8 <= triangles; t += 8) {
+        const size_t b = t * 3;
+        __m256 p[3][3];
+        const float* src[3] = { x, y, z };
+        for (int a = 0; a < 3; ++a)
+            for (int k = 0; k < 3; ++k) p[k][a] = _mm256_i32gather_ps(src[a] + b + k, stride, 4);
+        __m256 e1[3], e2[3];
+        for (int a = 0; a < 3; ++a) { e1[a] = _mm256_sub_ps(p[1][a], p[0][a]); e2[a] = _mm256_sub_ps(p[2][a], p[0][a]); }
+        __m256 cx = _mm256_fmsub_ps(e1[1], e2[2], _mm256_mul_ps(e1[2], e2[1]));
+        __m256 cy = _mm256_fmsub_ps(e1[2], e2[0], _mm256_mul_ps(e1[0], e2[2]));
+        __m256 cz = _mm256_fmsub_ps(e1[0], e2[1], _mm256_mul_ps(e1[1], e2[0]));
+        __m256 len2 = _mm256_fmadd_ps(cx, cx, _mm256_fmadd_ps(cy, cy, _mm256_mul_ps(cz, cz)));
+        __m256 valid = _mm256_cmp_ps(len2, zero, _CMP_GT_OQ);
+        __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(len2));
+        _mm256_store_ps(out[0], _mm256_and_ps(valid, _mm256_mul_ps(cx, inv)));
+        _mm256_store_ps(out[1], _mm256_blendv_ps(one, _mm256_mul_ps(cy, inv), valid));
+        _mm256_store_ps(out[2], _mm256_and_ps(valid, _mm256_mul_ps(cz, inv)));
+        for (int k = 0; k < 8; ++k)
+            for (int v = 0; v < 3; ++v) {
+                nx[b + k * 3 + v] = out[0][k];
+                ny[b + k * 3 + v] = out[1][k];
+                nz[b + k * 3 + v] = out[2][k];
+            }
+    }
+    return t;
+}
+#endif
+
+}
+
+void clearTRS(TRSBatch& b) {
+    b.px.clear(); b.py.clear(); b.pz.clear();
+    b.qx.clear(); b.qy.clear(); b.qz.clear(); b.qw.clear();
+    b.sx.clear(); b.sy.clear(); b.sz.clear();
+    b.count = 0;
+}
+
+void addTRS(TRSBatch& b, glm::vec3 position, glm::vec4 rotation, glm::vec3 scale) {
+    b.px.push_back(position.x); b.py.push_back(position.y); b.pz.push_back(position.z);
+    b.qx.push_back(rotation.x); b.qy.push_back(rotation.y); b.qz.push_back(rotation.z); b.qw.push_back(rotation.w);
+    b.sx.push_back(scale.x); b.sy.push_back(scale.y); b.sz.push_back(scale.z);
+    b.count++;
+}
+
+void composeTRSScalar(const TRSBatch& b, size_t begin, size_t end, glm::mat4* out) {
+    for (size_t i = begin; i < end; ++i) {
+        float x = b.qx[i], y = b.qy[i], z = b.qz[i], w = b.qw[i];
+        glm::mat4& m = out[i];
+        m[0] = glm::vec4((1.0f - 2.0f * (y * y + z * z)) * b.sx[i], 2.0f * (x * y + w * z) * b.sx[i], 2.0f * (x * z - w * y) * b.sx[i], 0.0f);
+        m[1] = glm::vec4(2.0f * (x * y - w * z) * b.sy[i], (1.0f - 2.0f * (x * x + z * z)) * b.sy[i], 2.0f * (y * z + w * x) * b.sy[i], 0.0f);
+        m[2] = glm::vec4(2.0f * (x * z + w * y) * b.sz[i], 2.0f * (y * z - w * x) * b.sz[i], (1.0f - 2.0f * (x * x + y * y)) * b.sz[i], 0.0f);
+        m[3] = glm::vec4(b.px[i], b.py[i], b.pz[i], 1.0f);
+    }
+}
+
+void transformAABBsScalar(const glm::mat4* models, const AABB* local, size_t begin, size_t end, float* center[3], float* extent[3]) {
+    for (size_t i = begin; i < end; ++i) {
+        const glm::mat4& m = models[i];
+        glm::vec3 c = (local[i].min + local[i].max) * 0.5f;
+        glm::vec3 e = (local[i].max - local[i].min) * 0.5f;
+        for (int r = 0; r < 3; ++r) {
+            center[r][i] = m[0][r] * c.x + m[1][r] * c.y + m[2][r] * c.z + m[3][r];
+            extent[r][i] = std::fabs(m[0][r]) * e.x + std::fabs(m[1][r]) * e.y + std::fabs(m[2][r]) * e.z;
+        }
+    }
+}
+
+void computeNormalMatricesScalar(const glm::mat4* models, glm::mat3* out, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        glm::vec3 a = glm::vec3(models[i][0]), b = glm::vec3(models[i][1]), c = glm::vec3(models[i][2]);
+        glm::vec3 r0 = glm::cross(b, c), r1 = glm::cross(c, a), r2 = glm::cross(a, b);
+        float invDet = 1.0f / glm::dot(a, r0);
+        out[i] = glm::mat3(r0 * invDet, r1 * invDet, r2 * invDet);
+    }
+}
+
+void composeTRS(const TRSBatch& b, glm::mat4* out) {
+    size_t done = 0;
+#if KANDZA_SIMD_X86
+    if (cpuHasAVX2()) { composeAVX2(b, b.count, out); done = b.count / 8 * 8; }
+    else { composeSSE(b, b.count, out); done = b.count / 4 * 4; }
+#endif
+    composeTRSScalar(b, done, b.count, out);
+}
+
+void transformAABBs(const glm::mat4* models, const AABB* local, size_t count, BoundsBatch& out) {
+    float* center[3];
+    float* extent[3];
+    appendBounds(out, count, center, extent);
+    size_t done = 0;
+#if KANDZA_SIMD_X86
+    if (cpuHasAVX2()) { transformAVX2(models, local, count, center, extent); done = count / 8 * 8; }
+    else { transformSSE(models, local, count, center, extent); done = count / 4 * 4; }
+#endif
+    transformAABBsScalar(models, local, done, count, center, extent);
+}
+
+void computeNormalMatrices(const glm::mat4* models, glm::mat3* out, size_t count) {
+    size_t done = 0;
+#if KANDZA_SIMD_X86
+    if (cpuHasAVX2()) { normalAVX2(models, out, count); done = count / 8 * 8; }
+    else { normalSSE(models, out, count); done = count / 4 * 4; }
+#endif
+    computeNormalMatricesScalar(models, out, done, count);
+}
+
+void minMaxFloats(const float* values, size_t count, float& lo, float& hi) {
+    lo = 1e30f;
+    hi = -1e30f;
+    size_t done = 0;
+#if KANDZA_SIMD_X86
+    done = cpuHasAVX2() ? minMaxAVX2(values, count, lo, hi) : minMaxSSE(values, count, lo, hi);
+#endif
+    for (size_t i = done; i < count; ++i) {
+        lo = std::min(lo, values[i]);
+        hi = std::max(hi, values[i]);
+    }
+}
+
+void offsetScaleFloats(float* values, size_t count, float offset, float scale) {
+    size_t done = 0;
+#if KANDZA_SIMD_X86
+    done = cpuHasAVX2() ? offsetScaleAVX2(values, count, offset, scale) : offsetScaleSSE(values, count, offset, scale);
+#endif
+    for (size_t i = done; i < count; ++i) values[i] = (values[i] - offset) * scale;
+}
+
+void flatTriangleNormals(const float* x, const float* y, const float* z, float* nx, float* ny, float* nz, size_t vertexCount) {
+    const size_t triangles = vertexCount / 3;
+    size_t done = 0;
+#if KANDZA_SIMD_X86
+    done = cpuHasAVX2() ? flatNormalsAVX2(x, y, z, nx, ny, nz, triangles) : flatNormalsSSE(x, y, z, nx, ny, nz, triangles);
+#endif
+    for (size_t t = done; t < triangles; ++t) {
+        const size_t b = t * 3;
+        glm::vec3 p0(x[b], y[b], z[b]), p1(x[b + 1], y[b + 1], z[b + 1]), p2(x[b + 2], y[b + 2], z[b + 2]);
+        glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        float len2 = glm::dot(n, n);
+        n = len2 > 0.0f ? n / std::sqrt(len2) : glm::vec3(0.0f, 1.0f, 0.0f);
+        for (int v = 0; v < 3; ++v) { nx[b + v] = n.x; ny[b + v] = n.y; nz[b + v] = n.z; }
+    }
+}
@@ -0,0 +1,147 @@
+#include "../Header/MeshNormals.h"
+#include "../Header/MathBatch.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Corners grouped by source position (CSR): corners[start[id] .. start[id + 1]).
+struct CornerAdjacency {
+    std::vector<int> start;
+    std::vector<int> corners;
+};
+
+void buildAdjacency(const std::vector<int>& ids, size_t corners, CornerAdjacency& adj) {
+    int maxId = -1;
+    for (size_t c = 0; c < corners; ++c) maxId = std::max(maxId, ids[c]);
+    adj.start.assign(maxId + 2, 0);
+    for (size_t c = 0; c < corners; ++c) if (ids[c] >= 0) adj.start[ids[c] + 1]++;
+    for (size_t i = 1; i < adj.start.size(); ++i) adj.start[i] += adj.start[i - 1];
+    adj.corners.resize(adj.start.back());
+    std::vector<int> fill(adj.start.begin(), adj.start.end() - 1);
+    for (size_t c = 0; c < corners; ++c) if (ids[c] >= 0) adj.corners[fill[ids[c]]++] = (int)c;
+}
+
+glm::vec3 cornerPosition(const CornerStreams& s, size_t c) {
+    return glm::vec3(s.x[c], s.y[c], s.z[c]);
+}
+
+glm::vec3 cornerNormal(const CornerStreams& s, size_t c) {
+    return glm::vec3(s.nx[c], s.ny[c], s.nz[c]);
+}
+
+// Interior angle at every corner; zero for all three corners of a degenerate triangle.
+void cornerAngles(const CornerStreams& s, size_t corners, float* angles) {
+    for (size_t b = 0; b < corners; b += 3) {
+        glm::vec3 p[3] = { cornerPosition(s, b), cornerPosition(s, b + 1), cornerPosition(s, b + 2) };
+        glm::vec3 n = glm::cross(p[1] - p[0], p[2] - p[0]);
+        bool degenerate = !(glm::dot(n, n) > 0.0f);
+        for (int k = 0; k < 3; ++k) {
+            glm::vec3 e1 = p[(k + 1) % 3] - p[k], e2 = p[(k + 2) % 3] - p[k];
+            float len = std::sqrt(glm::dot(e1, e1) * glm::dot(e2, e2));
+            angles[b + k] = (degenerate || len <= 0.0f) ? 0.0f : std::acos(std::max(-1.0f, std::min(1.0f, glm::dot(e1, e2) / len)));
+        }
+    }
+}
+
+glm::vec3 anyPerpendicular(glm::vec3 n) {
+    glm::vec3 axis = std::fabs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    return glm::normalize(glm::cross(axis, n));
+}
+
+}
+
+void resizeCorners(CornerStreams& s, size_t corners) {
+    s.x.resize(corners); s.y.resize(corners); s.z.resize(corners);
+    s.nx.resize(corners); s.ny.resize(corners); s.nz.resize(corners);
+    s.u.resize(corners); s.v.resize(corners);
+    s.positionId.resize(corners);
+    s.texcoordId.resize(corners);
+    s.tx.resize(corners); s.ty.resize(corners); s.tz.resize(corners); s.tw.resize(corners);
+}
+
+void generateSmoothNormals(CornerStreams& s, float creaseAngle) {
+    const size_t corners = s.x.size() / 3 * 3;
+    // Face normal per corner (SoA) and its angle weight, allocated once.
+    std::vector<float> scratch(corners * 4);
+    float* fx = scratch.data();
+    float* fy = fx + corners;
+    float* fz = fy + corners;
+    float* weight = fz + corners;
+    flatTriangleNormals(s.x.data(), s.y.data(), s.z.data(), fx, fy, fz, corners);
+    cornerAngles(s, corners, weight);
+
+    CornerAdjacency adj;
+    buildAdjacency(s.positionId, corners, adj);
+    const float cosCrease = std::cos(creaseAngle);
+    for (size_t c = 0; c < corners; ++c) {
+        glm::vec3 face(fx[c], fy[c], fz[c]);
+        glm::vec3 n(0.0f);
+        int id = s.positionId[c];
+        if (id >= 0) {
+            for (int i = adj.start[id]; i < adj.start[id + 1]; ++i) {
+                int d = adj.corners[i];
+                glm::vec3 other(fx[d], fy[d], fz[d]);
+                if (glm::dot(face, other) >= cosCrease) n += other * weight[d];
+            }
+        }
+        float len2 = glm::dot(n, n);
+        n = len2 > 0.0f ? n / std::sqrt(len2) : face;
+        s.nx[c] = n.x; s.ny[c] = n.y; s.nz[c] = n.z;
+    }
+}
+
+void generateTangents(CornerStreams& s) {
+    const size_t corners = s.x.size() / 3 * 3;
+    // Projected face tangent, handedness and angle weight per corner.
+    std::vector<float> scratch(corners * 5);
+    float* ftx = scratch.data();
+    float* fty = ftx + corners;
+    float* ftz = fty + corners;
+    float* sign = ftz + corners;
+    float* weight = sign + corners;
+    cornerAngles(s, corners, weight);
+
+    for (size_t b = 0; b < corners; b += 3) {
+        glm::vec3 e1 = cornerPosition(s, b + 1) - cornerPosition(s, b);
+        glm::vec3 e2 = cornerPosition(s, b + 2) - cornerPosition(s, b);
+        float du1 = s.u[b + 1] - s.u[b], dv1 = s.v[b + 1] - s.v[b];
+        float du2 = s.u[b + 2] - s.u[b], dv2 = s.v[b + 2] - s.v[b];
+        float r = du1 * dv2 - du2 * dv1;
+        glm::vec3 t(0.0f), bt(0.0f);
+        if (std::fabs(r) > 1e-20f) {
+            t = (e1 * dv2 - e2 * dv1) / r;
+            bt = (e2 * du1 - e1 * du2) / r;
+        }
+        for (int k = 0; k < 3; ++k) {
+            size_t c = b + k;
+            glm::vec3 n = cornerNormal(s, c);
+            glm::vec3 tp = t - n * glm::dot(n, t);
+            float len2 = glm::dot(tp, tp);
+            tp = len2 > 0.0f ? tp / std::sqrt(len2) : glm::vec3(0.0f);
+            ftx[c] = tp.x; fty[c] = tp.y; ftz[c] = tp.z;
+            sign[c] = glm::dot(glm::cross(n, t), bt) < 0.0f ? -1.0f : 1.0f;
+        }
+    }
+
+    CornerAdjacency adj;
+    buildAdjacency(s.positionId, corners, adj);
+    for (size_t c = 0; c < corners; ++c) {
+        glm::vec3 n = cornerNormal(s, c);
+        glm::vec3 t(ftx[c], fty[c], ftz[c]);
+        int id = s.positionId[c];
+        if (id >= 0) {
+            t = glm::vec3(0.0f);
+            for (int i = adj.start[id]; i < adj.start[id + 1]; ++i) {
+                int d = adj.corners[i];
+                if (s.texcoordId[d] != s.texcoordId[c] || sign[d] != sign[c]) continue;
+                if (glm::dot(n, cornerNormal(s, d)) < 0.9999f) continue;
+                t += glm::vec3(ftx[d], fty[d], ftz[d]) * weight[d];
+            }
+        }
+        t -= n * glm::dot(n, t);
+        float len2 = glm::dot(t, t);
+        t = len2 > 1e-12f ? t / std::sqrt(len2) : anyPerpendicular(n);
+        s.tx[c] = t.x; s.ty[c] = t.y; s.tz[c] = t.z; s.tw[c] = sign[c];
+    }
+}
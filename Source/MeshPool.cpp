@@ -0,0 +1,158 @@
+#include "../Header/MeshPool.h"
+#include <algorithm>
+#include <cstddef>
+
+namespace {
+
+void bindVertexAttributes(MeshPool& pool) {
+    const GLsizei stride = sizeof(PoolVertex);
+    glBindVertexArray(pool.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, pool.vertexBuffer);
+    glEnableVertexAttribArray(0); glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PoolVertex, x));
+    glEnableVertexAttribArray(1); glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PoolVertex, nx));
+    glEnableVertexAttribArray(2); glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PoolVertex, u));
+    glEnableVertexAttribArray(8); glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PoolVertex, tx));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.indexBuffer);
+    glBindVertexArray(0);
+}
+
+// Swaps buffer for one of newBytes that starts with the old contents.
+void growBuffer(unsigned int& buffer, size_t oldBytes, size_t newBytes) {
+    GLuint bigger;
+    glGenBuffers(1, &bigger);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, bigger);
+    glBufferData(GL_COPY_WRITE_BUFFER, newBytes, NULL, GL_STATIC_DRAW);
+    if (buffer != 0 && oldBytes > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+    }
+    if (buffer != 0) glDeleteBuffers(1, &buffer);
+    buffer = bigger;
+}
+
+// Allocates count elements, doubling the allocator and its buffer until they fit.
+uint32_t allocateOrGrow(PoolAllocator& allocator, unsigned int& buffer, size_t elementSize, uint32_t count, bool& grew) {
+    uint32_t offset = 0;
+    while (!poolAllocate(allocator, count, offset)) {
+        uint32_t newCapacity = std::max(allocator.capacity * 2, allocator.capacity + count);
+        growBuffer(buffer, allocator.capacity * elementSize, newCapacity * elementSize);
+        poolGrow(allocator, newCapacity);
+        grew = true;
+    }
+    return offset;
+}
+
+}
+
+bool poolAllocate(PoolAllocator& allocator, uint32_t count, uint32_t& offset) {
+    for (size_t i = 0; i < allocator.freeSpans.size(); ++i) {
+        PoolSpan& span = allocator.freeSpans[i];
+        if (span.count < count) continue;
+        offset = span.offset;
+        span.offset += count;
+        span.count -= count;
+        if (span.count == 0) allocator.freeSpans.erase(allocator.freeSpans.begin() + i);
+        return true;
+    }
+    return false;
+}
+
+void poolFree(PoolAllocator& allocator, uint32_t offset, uint32_t count) {
+    if (count == 0) return;
+    std::vector<PoolSpan>& spans = allocator.freeSpans;
+    auto it = std::lower_bound(spans.begin(), spans.end(), offset, [](const PoolSpan& s, uint32_t o) { return s.offset < o; });
+    it = spans.insert(it, PoolSpan{ offset, count });
+    if (it + 1 != spans.end() && it->offset + it->count == (it + 1)->offset) {
+        it->count += (it + 1)->count;
+        spans.erase(it + 1);
+    }
+    if (it != spans.begin() && (it - 1)->offset + (it - 1)->count == it->offset) {
+        (it - 1)->count += it->count;
+        spans.erase(it);
+    }
+}
+
+void poolGrow(PoolAllocator& allocator, uint32_t newCapacity) {
+    if (newCapacity <= allocator.capacity) return;
+    uint32_t old = allocator.capacity;
+    allocator.capacity = newCapacity;
+    poolFree(allocator, old, newCapacity - old);
+}
+
+void initMeshPool(MeshPool& pool, uint32_t vertexCapacity, uint32_t indexCapacity) {
+    glGenVertexArrays(1, &pool.VAO);
+    growBuffer(pool.vertexBuffer, 0, vertexCapacity * sizeof(PoolVertex));
+    growBuffer(pool.indexBuffer, 0, indexCapacity * sizeof(uint32_t));
+    poolGrow(pool.vertices, vertexCapacity);
+    poolGrow(pool.indices, indexCapacity);
+    bindVertexAttributes(pool);
+}
+
+MeshRange uploadMesh(MeshPool& pool, const PoolVertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount) {
+    MeshRange mesh;
+    if (vertexCount == 0 || indexCount == 0) return mesh;
+    bool grew = false;
+    mesh.firstVertex = allocateOrGrow(pool.vertices, pool.vertexBuffer, sizeof(PoolVertex), vertexCount, grew);
+    mesh.firstIndex = allocateOrGrow(pool.indices, pool.indexBuffer, sizeof(uint32_t), indexCount, grew);
+    mesh.vertexCount = vertexCount;
+    mesh.indexCount = indexCount;
+    if (grew) bindVertexAttributes(pool);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pool.vertexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, mesh.firstVertex * sizeof(PoolVertex), vertexCount * sizeof(PoolVertex), vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pool.indexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, mesh.firstIndex * sizeof(uint32_t), indexCount * sizeof(uint32_t), indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return mesh;
+}
+
+MeshRange uploadTriangles(MeshPool& pool, const float* interleaved, uint32_t vertexCount) {
+    std::vector<PoolVertex> vertices(vertexCount);
+    std::vector<uint32_t> indices(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        const float* src = interleaved + i * 8;
+        PoolVertex& v = vertices[i];
+        v.x = src[0]; v.y = src[1]; v.z = src[2];
+        v.nx = src[3]; v.ny = src[4]; v.nz = src[5];
+        v.u = src[6]; v.v = src[7];
+        v.tx = 1.0f; v.ty = 0.0f; v.tz = 0.0f; v.tw = 1.0f;
+        indices[i] = i;
+    }
+    return uploadMesh(pool, vertices.data(), vertexCount, indices.data(), vertexCount);
+}
+
+void releaseMesh(MeshPool& pool, const MeshRange& mesh) {
+    poolFree(pool.vertices, mesh.firstVertex, mesh.vertexCount);
+    poolFree(pool.indices, mesh.firstIndex, mesh.indexCount);
+}
+
+void deleteMeshPool(MeshPool& pool) {
+    if (pool.VAO) glDeleteVertexArrays(1, &pool.VAO);
+    if (pool.vertexBuffer) glDeleteBuffers(1, &pool.vertexBuffer);
+    if (pool.indexBuffer) glDeleteBuffers(1, &pool.indexBuffer);
+    pool = MeshPool();
+}
+
+void bindInstanceAttributes(unsigned int instanceBuffer, size_t offset) {
+    const GLsizei stride = sizeof(DrawInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (int col = 0; col < 4; ++col) {
+        glEnableVertexAttribArray(3 + col);
+        glVertexAttribPointer(3 + col, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(DrawInstance, model) + col * 4 * sizeof(float)));
+        glVertexAttribDivisor(3 + col, 1);
+    }
+    glEnableVertexAttribArray(7);
+    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(DrawInstance, color)));
+    glVertexAttribDivisor(7, 1);
+    for (int col = 0; col < 3; ++col) {
+        glEnableVertexAttribArray(9 + col);
+        glVertexAttribPointer(9 + col, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(DrawInstance, normalMatrix) + col * 3 * sizeof(float)));
+        glVertexAttribDivisor(9 + col, 1);
+    }
+    glEnableVertexAttribArray(12);
+    glVertexAttribPointer(12, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(DrawInstance, texRect)));
+    glVertexAttribDivisor(12, 1);
+    glEnableVertexAttribArray(13);
+    glVertexAttribPointer(13, 1, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(DrawInstance, texLayer)));
+    glVertexAttribDivisor(13, 1);
+}
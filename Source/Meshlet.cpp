@@ -0,0 +1,128 @@
+#include "../Header/Meshlet.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Clusters whose normals spread past this (dot with the average axis) never cone cull.
+const float kMinConeSpread = 0.1f;
+
+void computeMeshletBounds(Meshlet& m, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+    const uint32_t end = m.firstIndex + m.indexCount;
+    glm::vec3 lo = positions[indices[m.firstIndex]], hi = lo;
+    for (uint32_t i = m.firstIndex; i < end; ++i) {
+        lo = glm::min(lo, positions[indices[i]]);
+        hi = glm::max(hi, positions[indices[i]]);
+    }
+    m.center = (lo + hi) * 0.5f;
+    float radius2 = 0.0f;
+    for (uint32_t i = m.firstIndex; i < end; ++i) {
+        glm::vec3 d = positions[indices[i]] - m.center;
+        radius2 = std::max(radius2, glm::dot(d, d));
+    }
+    m.radius = std::sqrt(radius2);
+
+    glm::vec3 axis(0.0f);
+    for (uint32_t i = m.firstIndex; i < end; i += 3) {
+        glm::vec3 p0 = positions[indices[i]];
+        glm::vec3 n = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+        float len2 = glm::dot(n, n);
+        if (len2 > 0.0f) axis += n / std::sqrt(len2);
+    }
+    float axisLen2 = glm::dot(axis, axis);
+    m.coneCutoff = 2.0f;
+    if (!(axisLen2 > 0.0f)) return;
+    axis /= std::sqrt(axisLen2);
+
+    float minDot = 1.0f;
+    for (uint32_t i = m.firstIndex; i < end; i += 3) {
+        glm::vec3 p0 = positions[indices[i]];
+        glm::vec3 n = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+        float len2 = glm::dot(n, n);
+        if (len2 > 0.0f) minDot = std::min(minDot, glm::dot(n, axis) / std::sqrt(len2));
+    }
+    if (minDot <= kMinConeSpread) return;
+
+    // Move the apex back along the axis until every triangle plane is in front of it.
+    float maxT = 0.0f;
+    for (uint32_t i = m.firstIndex; i < end; i += 3) {
+        glm::vec3 p0 = positions[indices[i]];
+        glm::vec3 n = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+        float len2 = glm::dot(n, n);
+        if (!(len2 > 0.0f)) continue;
+        n /= std::sqrt(len2);
+        maxT = std::max(maxT, glm::dot(m.center - p0, n) / glm::dot(axis, n));
+    }
+    m.coneAxis = axis;
+    m.coneApex = m.center - axis * maxT;
+    m.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+}
+
+void buildMeshlets(MeshletMesh& out, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, size_t maxVertices, size_t maxTriangles) {
+    // Greedy scan in index order: OBJ exporters write faces in a spatially coherent
+    // order, so consecutive triangles make compact clusters.
+    out.indices = indices;
+    out.meshlets.clear();
+    const size_t triangles = indices.size() / 3;
+    if (triangles == 0) return;
+    std::vector<uint32_t> stamp(positions.size(), UINT32_MAX);
+    uint32_t cluster = 0;
+    size_t first = 0, vertexCount = 0;
+
+    auto flush = [&](size_t end) {
+        Meshlet m;
+        m.firstIndex = (uint32_t)(first * 3);
+        m.indexCount = (uint32_t)((end - first) * 3);
+        computeMeshletBounds(m, positions, out.indices);
+        out.meshlets.push_back(m);
+        first = end;
+        vertexCount = 0;
+        ++cluster;
+    };
+    auto newVertices = [&](uint32_t a, uint32_t b, uint32_t c) {
+        return (size_t)(stamp[a] != cluster) + (size_t)(stamp[b] != cluster && b != a) + (size_t)(stamp[c] != cluster && c != a && c != b);
+    };
+
+    for (size_t t = 0; t < triangles; ++t) {
+        uint32_t a = indices[t * 3], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+        size_t added = newVertices(a, b, c);
+        if (vertexCount + added > maxVertices || t - first + 1 > maxTriangles) {
+            flush(t);
+            added = newVertices(a, b, c);
+        }
+        stamp[a] = stamp[b] = stamp[c] = cluster;
+        vertexCount += added;
+    }
+    flush(triangles);
+}
+
+int cullMeshlets(const MeshletMesh& mesh, const glm::mat4& model, const Frustum& frustum, glm::vec3 eye, std::vector<DrawElementsIndirectCommand>& commands) {
+    float sx = glm::length(glm::vec3(model[0])), sy = glm::length(glm::vec3(model[1])), sz = glm::length(glm::vec3(model[2]));
+    float maxScale = std::max(sx, std::max(sy, sz)), minScale = std::min(sx, std::min(sy, sz));
+    // Cone angles only survive a uniform scale; with a stretched instance skip the cone test.
+    bool coneTest = maxScale - minScale <= 0.01f * maxScale;
+    glm::vec3 eyeLocal = glm::vec3(glm::inverse(model) * glm::vec4(eye, 1.0f));
+
+    int visible = 0;
+    bool merging = false;
+    for (const Meshlet& m : mesh.meshlets) {
+        BoundingSphere sphere;
+        sphere.center = glm::vec3(model * glm::vec4(m.center, 1.0f));
+        sphere.radius = m.radius * maxScale;
+        bool culled = !isVisible(frustum, sphere);
+        if (!culled && coneTest && m.coneCutoff <= 1.0f)
+            culled = glm::dot(glm::normalize(m.coneApex - eyeLocal), m.coneAxis) >= m.coneCutoff;
+        if (culled) { merging = false; continue; }
+        ++visible;
+        if (merging) {
+            commands.back().count += m.indexCount;
+            continue;
+        }
+        DrawElementsIndirectCommand cmd = { m.indexCount, 1, m.firstIndex, 0, 0 };
+        commands.push_back(cmd);
+        merging = true;
+    }
+    return visible;
+}
@@ -0,0 +1,210 @@
+#include "../Header/Mipmaps.h"
+#include "../Header/Simd.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+// Linear values are quantised to 14 bits before the table lookup; coarser tables merge
+// the darkest sRGB codes.
+const int kLinearSteps = 16384;
+
+float srgbToLinear(float c) {
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSrgb(float c) {
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+struct GammaTables {
+    float toLinear[256];
+    unsigned char toSrgb[kLinearSteps];
+    GammaTables() {
+        for (int i = 0; i < 256; ++i) toLinear[i] = srgbToLinear(i / 255.0f);
+        for (int i = 0; i < kLinearSteps; ++i) toSrgb[i] = (unsigned char)(linearToSrgb(i / (float)(kLinearSteps - 1)) * 255.0f + 0.5f);
+    }
+};
+
+const GammaTables& gammaTables() {
+    static const GammaTables tables;
+    return tables;
+}
+
+// Chunks of roughly 64K pixels per job.
+void forRows(ThreadPool* threads, int rows, int width, const std::function<void(size_t, size_t)>& fn) {
+    size_t grain = std::max<size_t>(1, 65536 / (size_t)std::max(1, width));
+    if (threads && !threads->workers.empty() && (size_t)rows > grain) parallelFor(*threads, rows, grain, fn);
+    else fn(0, rows);
+}
+
+void expandRows(const DecodedImage& image, MipLevel& level, size_t rowBegin, size_t rowEnd) {
+    const int c = image.channels;
+    if (c == 4) {
+        std::memcpy(&level.pixels[rowBegin * image.width * 4], &image.pixels[rowBegin * image.width * 4], (rowEnd - rowBegin) * image.width * 4);
+        return;
+    }
+    for (size_t y = rowBegin; y < rowEnd; ++y) {
+        const unsigned char* src = &image.pixels[y * image.width * c];
+        unsigned char* dst = &level.pixels[y * image.width * 4];
+        for (int x = 0; x < image.width; ++x, src += c, dst += 4) {
+            switch (c) {
+            case 1: dst[0] = dst[1] = dst[2] = src[0]; dst[3] = 255; break;
+            case 2: dst[0] = dst[1] = dst[2] = src[0]; dst[3] = src[1]; break;
+            default: dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = 255; break;
+            }
+        }
+    }
+}
+
+void linearizeRow(const unsigned char* src, int width, float* dst) {
+    const GammaTables& t = gammaTables();
+    for (int x = 0; x < width; ++x, src += 4, dst += 4) {
+        dst[0] = t.toLinear[src[0]];
+        dst[1] = t.toLinear[src[1]];
+        dst[2] = t.toLinear[src[2]];
+        dst[3] = src[3] * (1.0f / 255.0f);
+    }
+}
+
+void encodeRows(const LinearImage& linear, MipLevel& level, size_t rowBegin, size_t rowEnd) {
+    const GammaTables& t = gammaTables();
+    const size_t begin = rowBegin * linear.width, end = rowEnd * linear.width;
+    const float* src = linear.pixels.data();
+    unsigned char* dst = level.pixels.data();
+    size_t i = begin;
+#if KANDZA_SIMD_X86
+    const __m128 scale = _mm_setr_ps((float)(kLinearSteps - 1), (float)(kLinearSteps - 1), (float)(kLinearSteps - 1), 255.0f);
+    alignas(16) int index[4];
+    for (; i < end; ++i) {
+        __m128 v = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i * 4), _mm_set1_ps(1.0f)), _mm_setzero_ps());
+        _mm_store_si128((__m128i*)index, _mm_cvtps_epi32(_mm_mul_ps(v, scale)));
+        dst[i * 4] = t.toSrgb[index[0]];
+        dst[i * 4 + 1] = t.toSrgb[index[1]];
+        dst[i * 4 + 2] = t.toSrgb[index[2]];
+        dst[i * 4 + 3] = (unsigned char)index[3];
+    }
+#endif
+    for (; i < end; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            int q = (int)(src[i * 4 + k] * (kLinearSteps - 1) + 0.5f);
+            dst[i * 4 + k] = t.toSrgb[std::min(kLinearSteps - 1, std::max(0, q))];
+        }
+        dst[i * 4 + 3] = (unsigned char)std::min(255, std::max(0, (int)(src[i * 4 + 3] * 255.0f + 0.5f)));
+    }
+}
+
+void downsampleTail(const float* r0, const float* r1, int srcWidth, float* out, int begin, int end) {
+    for (int x = begin; x < end; ++x) {
+        int x0 = std::min(2 * x, srcWidth - 1), x1 = std::min(2 * x + 1, srcWidth - 1);
+        for (int k = 0; k < 4; ++k)
+            out[x * 4 + k] = (r0[x0 * 4 + k] + r0[x1 * 4 + k] + r1[x0 * 4 + k] + r1[x1 * 4 + k]) * 0.25f;
+    }
+}
+
+#if KANDZA_SIMD_X86
+// One texel (four channels) per SSE register.
+void downsampleSSE(const float* r0, const float* r1, float* out, int count) {
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    for (int x = 0; x < count; ++x) {
+        __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(r0 + 8 * x), _mm_loadu_ps(r0 + 8 * x + 4)),
+            _mm_add_ps(_mm_loadu_ps(r1 + 8 * x), _mm_loadu_ps(r1 + 8 * x + 4)));
+        _mm_storeu_ps(out + 4 * x, _mm_mul_ps(sum, quarter));
+    }
+}
+
+// Two output texels per iteration: the row sums of source texels (0,1) and (2,3) are
+// regrouped into (0,2) and (1,3) and added.
+KANDZA_TARGET_AVX2 int downsampleAVX2(const float* r0, const float* r1, float* out, int count) {
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    int x = 0;
+    for (; x + 2 <= count; x += 2) {
+        __m256 a = _mm256_add_ps(_mm256_loadu_ps(r0 + 8 * x), _mm256_loadu_ps(r1 + 8 * x));
+        __m256 b = _mm256_add_ps(_mm256_loadu_ps(r0 + 8 * x + 8), _mm256_loadu_ps(r1 + 8 * x + 8));
+        __m256 even = _mm256_permute2f128_ps(a, b, 0x20);
+        __m256 odd = _mm256_permute2f128_ps(a, b, 0x31);
+        _mm256_storeu_ps(out + 4 * x, _mm256_mul_ps(_mm256_add_ps(even, odd), quarter));
+    }
+    return x;
+}
+#endif
+
+void downsampleRow(const float* r0, const float* r1, int srcWidth, float* out, int dstWidth) {
+    int done = 0;
+#if KANDZA_SIMD_X86
+    // Output texels whose 2x2 footprint lies fully inside the row need no clamping.
+    const int inner = srcWidth % 2 == 0 ? dstWidth : dstWidth - 1;
+    if (cpuHasAVX2()) done = downsampleAVX2(r0, r1, out, inner);
+    downsampleSSE(r0 + 8 * done, r1 + 8 * done, out + 4 * done, inner - done);
+    done = inner;
+#endif
+    downsampleTail(r0, r1, srcWidth, out, done, dstWidth);
+}
+
+}
+
+void halveLinearImage(const LinearImage& src, LinearImage& dst) {
+    dst.width = std::max(1, src.width / 2);
+    dst.height = std::max(1, src.height / 2);
+    dst.pixels.resize((size_t)dst.width * dst.height * 4);
+}
+
+void downsampleRowsScalar(const LinearImage& src, LinearImage& dst, size_t rowBegin, size_t rowEnd) {
+    for (size_t y = rowBegin; y < rowEnd; ++y) {
+        const float* r0 = &src.pixels[(size_t)std::min(2 * (int)y, src.height - 1) * src.width * 4];
+        const float* r1 = &src.pixels[(size_t)std::min(2 * (int)y + 1, src.height - 1) * src.width * 4];
+        downsampleTail(r0, r1, src.width, &dst.pixels[y * dst.width * 4], 0, dst.width);
+    }
+}
+
+void downsampleRows(const LinearImage& src, LinearImage& dst, size_t rowBegin, size_t rowEnd) {
+    for (size_t y = rowBegin; y < rowEnd; ++y) {
+        const float* r0 = &src.pixels[(size_t)std::min(2 * (int)y, src.height - 1) * src.width * 4];
+        const float* r1 = &src.pixels[(size_t)std::min(2 * (int)y + 1, src.height - 1) * src.width * 4];
+        downsampleRow(r0, r1, src.width, &dst.pixels[y * dst.width * 4], dst.width);
+    }
+}
+
+void buildMipChain(const DecodedImage& image, std::vector<MipLevel>& levels, ThreadPool* threads) {
+    levels.clear();
+    if (image.width <= 0 || image.height <= 0) return;
+    levels.resize(1);
+    MipLevel& base = levels[0];
+    base.width = image.width;
+    base.height = image.height;
+    base.pixels.resize((size_t)image.width * image.height * 4);
+    forRows(threads, image.height, image.width, [&](size_t begin, size_t end) { expandRows(image, base, begin, end); });
+    if (image.width == 1 && image.height == 1) return;
+
+    // Level 1 reads the 8-bit base two rows at a time, so no linear copy of the largest
+    // level is ever made.
+    LinearImage current, next;
+    current.width = std::max(1, image.width / 2);
+    current.height = std::max(1, image.height / 2);
+    current.pixels.resize((size_t)current.width * current.height * 4);
+    forRows(threads, current.height, current.width, [&](size_t begin, size_t end) {
+        std::vector<float> rows((size_t)base.width * 8);
+        float* r0 = rows.data();
+        float* r1 = r0 + (size_t)base.width * 4;
+        for (size_t y = begin; y < end; ++y) {
+            int y0 = std::min(2 * (int)y, base.height - 1), y1 = std::min(2 * (int)y + 1, base.height - 1);
+            linearizeRow(&base.pixels[(size_t)y0 * base.width * 4], base.width, r0);
+            linearizeRow(&base.pixels[(size_t)y1 * base.width * 4], base.width, r1);
+            downsampleRow(r0, r1, base.width, &current.pixels[y * current.width * 4], current.width);
+        }
+    });
+
+    for (;;) {
+        levels.push_back(MipLevel());
+        MipLevel& level = levels.back();
+        level.width = current.width;
+        level.height = current.height;
+        level.pixels.resize((size_t)current.width * current.height * 4);
+        forRows(threads, current.height, current.width, [&](size_t begin, size_t end) { encodeRows(current, level, begin, end); });
+        if (current.width == 1 && current.height == 1) break;
+        halveLinearImage(current, next);
+        forRows(threads, next.height, next.width, [&](size_t begin, size_t end) { downsampleRows(current, next, begin, end); });
+        std::swap(current, next);
+    }
+}
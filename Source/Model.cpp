@@ -1,4 +1,10 @@
 #include "../Header/Model.h"
+#include "../Header/MathBatch.h"
+#include "../Header/MeshNormals.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -6,16 +12,34 @@
 #include <glm/glm.hpp>
 #include <algorithm>
 
-Model loadOBJ(const std::string& path) {
-    Model result;
+namespace {
+
+size_t hashVertex(const PoolVertex& v) {
+    uint32_t words[sizeof(PoolVertex) / 4];
+    std::memcpy(words, &v, sizeof(PoolVertex));
+    uint32_t h = 2166136261u;
+    for (uint32_t w : words) h = (h ^ w) * 16777619u;
+    return h;
+}
+
+// Faces meeting at a sharper angle than this keep a hard edge when normals are generated.
+const float kCreaseAngle = glm::radians(60.0f);
+
+}
+
+bool parseOBJ(const std::string& path, ParsedModel& parsed) {
+    Model& result = parsed.model;
+    result = Model();
+    parsed.vertices.clear();
     std::ifstream file(path);
     if (!file.is_open()) {
         std::cout << "Failed to open OBJ: " << path << std::endl;
-        return result;
+        return false;
     }
 
-    std::vector<glm::vec3> positions;
-    std::vector<glm::vec3> normals;
+    // Positions and normals are kept as SoA streams so the post-parse passes run vectorised.
+    std::vector<float> px, py, pz;
+    std::vector<float> nx, ny, nz;
     std::vector<glm::vec2> texcoords;
 
     struct VertexIndex { int p, t, n; };
@@ -27,9 +51,9 @@ Model loadOBJ(const std::string& path) {
         std::istringstream iss(line);
         std::string prefix; iss >> prefix;
         if (prefix == "v") {
-            glm::vec3 p; iss >> p.x >> p.y >> p.z; positions.push_back(p);
+            glm::vec3 p; iss >> p.x >> p.y >> p.z; px.push_back(p.x); py.push_back(p.y); pz.push_back(p.z);
         } else if (prefix == "vn") {
-            glm::vec3 n; iss >> n.x >> n.y >> n.z; normals.push_back(n);
+            glm::vec3 n; iss >> n.x >> n.y >> n.z; nx.push_back(n.x); ny.push_back(n.y); nz.push_back(n.z);
         } else if (prefix == "vt") {
             glm::vec2 t; iss >> t.x >> t.y; texcoords.push_back(t);
         } else if (prefix == "f") {
@@ -56,95 +80,130 @@ Model loadOBJ(const std::string& path) {
         }
     }
 
-    if (positions.empty()) {
+    if (px.empty()) {
         std::cout << "OBJ has no positions: " << path << std::endl;
-        return result;
+        return false;
     }
 
-    glm::vec3 minP = positions[0], maxP = positions[0];
-    for (auto &p : positions) {
-        minP = glm::min(minP, p);
-        maxP = glm::max(maxP, p);
-    }
+    std::chrono::steady_clock::time_point postStart = std::chrono::steady_clock::now();
+    const size_t positionCount = px.size(), normalCount = nx.size();
+    glm::vec3 minP, maxP;
+    minMaxFloats(px.data(), positionCount, minP.x, maxP.x);
+    minMaxFloats(py.data(), positionCount, minP.y, maxP.y);
+    minMaxFloats(pz.data(), positionCount, minP.z, maxP.z);
     glm::vec3 center = (minP + maxP) * 0.5f;
     glm::vec3 extents = maxP - minP;
     float maxExtent = std::max(std::max(extents.x, extents.y), extents.z);
     float scale = 1.0f;
     if (maxExtent > 0.0f) scale = 1.0f / maxExtent;
+    // Recentre and rescale the source streams once instead of every expanded vertex.
+    offsetScaleFloats(px.data(), positionCount, center.x, scale);
+    offsetScaleFloats(py.data(), positionCount, center.y, scale);
+    offsetScaleFloats(pz.data(), positionCount, center.z, scale);
+    glm::vec3 minV = (minP - center) * scale, maxV = (maxP - center) * scale;
 
-    struct VT { float x,y,z; float nx,ny,nz; float u,v; };
-    std::vector<VT> verts;
-    verts.reserve(indices.size());
-
-    float minY = 1e9f, maxY = -1e9f;
-    float minX = 1e9f, maxX = -1e9f;
-    float minZ = 1e9f, maxZ = -1e9f;
-    for (auto &vi : indices) {
-        VT v={0};
-        if (vi.p>=0) {
-            glm::vec3 p = positions[vi.p];
-            p = (p - center) * scale;
-            v.x = p.x; v.y = p.y; v.z = p.z;
-            minY = std::min(minY, p.y);
-            maxY = std::max(maxY, p.y);
-            minX = std::min(minX, p.x);
-            maxX = std::max(maxX, p.x);
-            minZ = std::min(minZ, p.z);
-            maxZ = std::max(maxZ, p.z);
-        }
-        if (vi.n>=0 && vi.n < (int)normals.size()) { v.nx = normals[vi.n].x * scale; v.ny = normals[vi.n].y * scale; v.nz = normals[vi.n].z * scale; }
-        else { v.nx = v.ny = v.nz = 0.0f; }
-        if (vi.t>=0 && vi.t < (int)texcoords.size()) { v.u = texcoords[vi.t].x; v.v = texcoords[vi.t].y; }
-        verts.push_back(v);
+    // Expand the faces into corner streams; normals and tangents are generated on these.
+    const size_t vertexCount = indices.size();
+    CornerStreams corners;
+    resizeCorners(corners, vertexCount);
+    bool needsNormals = true;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const VertexIndex& vi = indices[i];
+        bool hasPosition = vi.p >= 0 && vi.p < (int)positionCount;
+        bool hasNormal = vi.n >= 0 && vi.n < (int)normalCount;
+        bool hasTexcoord = vi.t >= 0 && vi.t < (int)texcoords.size();
+        corners.x[i] = hasPosition ? px[vi.p] : 0.0f;
+        corners.y[i] = hasPosition ? py[vi.p] : 0.0f;
+        corners.z[i] = hasPosition ? pz[vi.p] : 0.0f;
+        // Tangent generation projects against the normal, so file normals go in unit length.
+        glm::vec3 n(0.0f);
+        if (hasNormal) n = glm::vec3(nx[vi.n], ny[vi.n], nz[vi.n]);
+        float nLen2 = glm::dot(n, n);
+        if (nLen2 > 0.0f) n /= std::sqrt(nLen2);
+        corners.nx[i] = n.x;
+        corners.ny[i] = n.y;
+        corners.nz[i] = n.z;
+        corners.u[i] = hasTexcoord ? texcoords[vi.t].x : 0.0f;
+        corners.v[i] = hasTexcoord ? texcoords[vi.t].y : 0.0f;
+        corners.positionId[i] = hasPosition ? vi.p : -1;
+        corners.texcoordId[i] = hasTexcoord ? vi.t : -1;
+        needsNormals = needsNormals && !hasNormal;
     }
+    if (needsNormals) generateSmoothNormals(corners, kCreaseAngle);
+    generateTangents(corners);
 
-    bool needsNormals = true;
-    for (auto &v : verts) { if (v.nx != 0.0f || v.ny != 0.0f || v.nz != 0.0f) { needsNormals = false; break; } }
-    if (needsNormals) {
-        std::vector<glm::vec3> accum(verts.size(), glm::vec3(0.0f));
-        for (size_t i = 0; i + 2 < verts.size(); i += 3) {
-            glm::vec3 p0 = glm::vec3(verts[i].x, verts[i].y, verts[i].z);
-            glm::vec3 p1 = glm::vec3(verts[i+1].x, verts[i+1].y, verts[i+1].z);
-            glm::vec3 p2 = glm::vec3(verts[i+2].x, verts[i+2].y, verts[i+2].z);
-            glm::vec3 faceNormal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
-            if (!glm::isnan(faceNormal.x)) {
-                accum[i] += faceNormal;
-                accum[i+1] += faceNormal;
-                accum[i+2] += faceNormal;
-            }
-        }
-        for (size_t i = 0; i < verts.size(); ++i) {
-            glm::vec3 n = glm::normalize(accum[i]);
-            if (glm::length(n) < 1e-6f) n = glm::vec3(0.0f, 1.0f, 0.0f);
-            verts[i].nx = n.x; verts[i].ny = n.y; verts[i].nz = n.z;
+    // Weld corners with identical attributes into unique vertices and an index buffer.
+    std::vector<PoolVertex>& verts = parsed.vertices;
+    std::vector<uint32_t> vertexIndices(vertexCount);
+    std::vector<uint32_t> weldTable;
+    verts.reserve(vertexCount / 4);
+    size_t tableSize = 1;
+    while (tableSize < vertexCount * 2) tableSize <<= 1;
+    weldTable.assign(tableSize, UINT32_MAX);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        PoolVertex v;
+        v.x = corners.x[i]; v.y = corners.y[i]; v.z = corners.z[i];
+        v.nx = corners.nx[i]; v.ny = corners.ny[i]; v.nz = corners.nz[i];
+        v.u = corners.u[i]; v.v = corners.v[i];
+        v.tx = corners.tx[i]; v.ty = corners.ty[i]; v.tz = corners.tz[i]; v.tw = corners.tw[i];
+        size_t slot = hashVertex(v) & (tableSize - 1);
+        while (weldTable[slot] != UINT32_MAX && std::memcmp(&verts[weldTable[slot]], &v, sizeof(PoolVertex)) != 0) slot = (slot + 1) & (tableSize - 1);
+        if (weldTable[slot] == UINT32_MAX) {
+            weldTable[slot] = (uint32_t)verts.size();
+            verts.push_back(v);
         }
+        vertexIndices[i] = weldTable[slot];
     }
+    double postMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - postStart).count();
 
     if (verts.empty()) {
         std::cout << "OBJ produced zero vertices: " << path << std::endl;
-        return result;
+        return false;
     }
 
-    GLuint VAO, VBO; glGenVertexArrays(1, &VAO); glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(VT), verts.data(), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0); glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,sizeof(VT),(void*)offsetof(VT,x));
-    glEnableVertexAttribArray(1); glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,sizeof(VT),(void*)offsetof(VT,nx));
-    glEnableVertexAttribArray(2); glVertexAttribPointer(2,2,GL_FLOAT,GL_FALSE,sizeof(VT),(void*)offsetof(VT,u));
+    std::vector<glm::vec3> weldedPositions(verts.size());
+    for (size_t i = 0; i < verts.size(); ++i) weldedPositions[i] = glm::vec3(verts[i].x, verts[i].y, verts[i].z);
+    buildMeshlets(result.meshlets, weldedPositions, vertexIndices);
 
-    result.VAO = VAO; result.vertexCount = (int)verts.size();
+    result.source = path;
     result.center = center; result.scale = scale;
-    result.halfHeight = (maxY - minY) * 0.5f;
-    result.halfExtents = glm::vec3((maxX - minX) * 0.5f, (maxY - minY) * 0.5f, (maxZ - minZ) * 0.5f);
-    std::cout << "Loaded OBJ: " << path << " vertices=" << result.vertexCount << " scale=" << scale << " center=(" << center.x << "," << center.y << "," << center.z << ") halfH=" << result.halfHeight << std::endl;
+    result.halfHeight = (maxV.y - minV.y) * 0.5f;
+    result.halfExtents = (maxV - minV) * 0.5f;
+    result.bounds.min = minV;
+    result.bounds.max = maxV;
+    result.sphere = boundingSphere(result.bounds);
+
+    std::vector<glm::vec3> hullPoints(positionCount);
+    for (size_t i = 0; i < positionCount; ++i) hullPoints[i] = glm::vec3(px[i], py[i], pz[i]);
+    result.hull = buildConvexHull(hullPoints, 48);
+    std::vector<glm::vec3> triPositions(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) triPositions[i] = glm::vec3(corners.x[i], corners.y[i], corners.z[i]);
+    result.hullPieces = decomposeConvex(triPositions, 4, 32);
+    buildMeshBvh(result.bvh, triPositions);
+    std::cout << "Loaded OBJ: " << path << " vertices=" << verts.size() << " indices=" << result.meshlets.indices.size() << " meshlets=" << result.meshlets.meshlets.size() << " scale=" << scale << " center=(" << center.x << "," << center.y << "," << center.z << ") halfH=" << result.halfHeight
+        << " hull=" << result.hull.vertices.size() << " pieces=" << result.hullPieces.size() << " bvhNodes=" << result.bvh.tree.nodes.size() << " post=" << postMs << "ms" << std::endl;
+    return true;
+}
+
+Model uploadParsedModel(ParsedModel& parsed, MeshPool& pool) {
+    Model result = std::move(parsed.model);
+    const std::vector<uint32_t>& indices = result.meshlets.indices;
+    result.mesh = uploadMesh(pool, parsed.vertices.data(), (uint32_t)parsed.vertices.size(), indices.data(), (uint32_t)indices.size());
+    parsed.vertices.clear();
     return result;
 }
 
-Model loadOBJWithCandidates(const std::initializer_list<std::string>& candidates) {
-    for (auto &s : candidates) {
-        Model m = loadOBJ(s);
-        if (m.VAO != 0) return m;
+Model loadOBJ(const std::string& path, MeshPool& pool) {
+    ParsedModel parsed;
+    if (!parseOBJ(path, parsed)) return Model();
+    return uploadParsedModel(parsed, pool);
+}
+
+Model loadOBJWithCandidates(MeshPool& pool, const std::initializer_list<std::string>& candidates) {
+    for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+        if (std::find(candidates.begin(), it, *it) != it) continue;
+        Model m = loadOBJ(*it, pool);
+        if (m.mesh.indexCount != 0) return m;
     }
     return Model();
 }
@@ -0,0 +1,195 @@
+#include "../Header/Occlusion.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const float kNearW = 1e-3f;
+
+    // Two triangles per box face; corner index bits are (x, y, z).
+    const int kBoxTriangles[12][3] = {
+        {0, 2, 6}, {0, 6, 4}, {1, 5, 7}, {1, 7, 3},
+        {0, 4, 5}, {0, 5, 1}, {2, 3, 7}, {2, 7, 6},
+        {0, 1, 3}, {0, 3, 2}, {4, 6, 7}, {4, 7, 5}
+    };
+
+    bool projectBox(const glm::mat4& viewProj, const AABB& box, glm::vec4 clip[8]) {
+        for (int i = 0; i < 8; ++i) {
+            glm::vec3 p((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z);
+            clip[i] = viewProj * glm::vec4(p, 1.0f);
+            if (clip[i].w < kNearW) return false;
+        }
+        return true;
+    }
+
+    glm::vec3 toScreen(const OcclusionCuller& c, const glm::vec4& clip) {
+        float invW = 1.0f / clip.w;
+        return glm::vec3((clip.x * invW * 0.5f + 0.5f) * c.width, (clip.y * invW * 0.5f + 0.5f) * c.height, clip.z * invW * 0.5f + 0.5f);
+    }
+
+    float edge(const glm::vec3& a, const glm::vec3& b, float px, float py) {
+        return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+    }
+
+    void rasterizeTriangle(OcclusionCuller& c, glm::vec3 a, glm::vec3 b, glm::vec3 d) {
+        float area = edge(a, b, d.x, d.y);
+        if (area == 0.0f) return;
+        if (area < 0.0f) { std::swap(b, d); area = -area; }
+
+        int x0 = std::max(0, (int)std::floor(std::min(a.x, std::min(b.x, d.x))));
+        int x1 = std::min(c.width - 1, (int)std::ceil(std::max(a.x, std::max(b.x, d.x))));
+        int y0 = std::max(0, (int)std::floor(std::min(a.y, std::min(b.y, d.y))));
+        int y1 = std::min(c.height - 1, (int)std::ceil(std::max(a.y, std::max(b.y, d.y))));
+        if (x0 > x1 || y0 > y1) return;
+
+        float invArea = 1.0f / area;
+        std::vector<float>& depth = c.levels[0];
+        for (int y = y0; y <= y1; ++y) {
+            float py = y + 0.5f;
+            float* row = &depth[(size_t)y * c.width];
+            for (int x = x0; x <= x1; ++x) {
+                float px = x + 0.5f;
+                float w0 = edge(b, d, px, py);
+                float w1 = edge(d, a, px, py);
+                float w2 = edge(a, b, px, py);
+                if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+                float z = (w0 * a.z + w1 * b.z + w2 * d.z) * invArea;
+                if (z < row[x]) row[x] = z;
+            }
+        }
+    }
+
+    void rasterizeOccluders(OcclusionCuller& c) {
+        std::fill(c.levels[0].begin(), c.levels[0].end(), 1.0f);
+        glm::vec4 clip[8];
+        glm::vec3 screen[8];
+        for (const AABB& box : c.occluders) {
+            // Occluders crossing the near plane are skipped; leaving one out is always conservative.
+            if (!projectBox(c.viewProj, box, clip)) continue;
+            for (int i = 0; i < 8; ++i) screen[i] = toScreen(c, clip[i]);
+            for (const auto& tri : kBoxTriangles)
+                rasterizeTriangle(c, screen[tri[0]], screen[tri[1]], screen[tri[2]]);
+        }
+    }
+
+    void buildHierarchy(OcclusionCuller& c) {
+        for (size_t l = 1; l < c.levels.size(); ++l) {
+            const std::vector<float>& src = c.levels[l - 1];
+            std::vector<float>& dst = c.levels[l];
+            int sw = c.levelWidth[l - 1], sh = c.levelHeight[l - 1];
+            int dw = c.levelWidth[l], dh = c.levelHeight[l];
+            for (int y = 0; y < dh; ++y) {
+                int sy0 = std::min(y * 2, sh - 1), sy1 = std::min(y * 2 + 1, sh - 1);
+                for (int x = 0; x < dw; ++x) {
+                    int sx0 = std::min(x * 2, sw - 1), sx1 = std::min(x * 2 + 1, sw - 1);
+                    float m = std::max(std::max(src[sy0 * sw + sx0], src[sy0 * sw + sx1]), std::max(src[sy1 * sw + sx0], src[sy1 * sw + sx1]));
+                    dst[y * dw + x] = m;
+                }
+            }
+        }
+    }
+
+    bool isOccluded(const OcclusionCuller& c, float cx, float cy, float cz, float ex, float ey, float ez) {
+        AABB box;
+        box.min = glm::vec3(cx - ex, cy - ey, cz - ez);
+        box.max = glm::vec3(cx + ex, cy + ey, cz + ez);
+        glm::vec4 clip[8];
+        if (!projectBox(c.viewProj, box, clip)) return false;
+
+        float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, minZ = 1e30f;
+        for (int i = 0; i < 8; ++i) {
+            glm::vec3 s = toScreen(c, clip[i]);
+            minX = std::min(minX, s.x); maxX = std::max(maxX, s.x);
+            minY = std::min(minY, s.y); maxY = std::max(maxY, s.y);
+            minZ = std::min(minZ, s.z);
+        }
+        if (maxX < 0.0f || maxY < 0.0f || minX >= c.width || minY >= c.height) return false;
+
+        int x0 = std::max(0, (int)std::floor(minX)), x1 = std::min(c.width - 1, (int)std::floor(maxX));
+        int y0 = std::max(0, (int)std::floor(minY)), y1 = std::min(c.height - 1, (int)std::floor(maxY));
+
+        size_t level = 0;
+        while (level + 1 < c.levels.size() && std::max(x1 - x0, y1 - y0) > 1) {
+            x0 >>= 1; x1 >>= 1; y0 >>= 1; y1 >>= 1;
+            ++level;
+        }
+
+        const std::vector<float>& depth = c.levels[level];
+        int w = c.levelWidth[level];
+        float maxDepth = 0.0f;
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+                maxDepth = std::max(maxDepth, depth[y * w + x]);
+        return minZ > maxDepth;
+    }
+
+    void workerLoop(OcclusionCuller* c) {
+        std::unique_lock<std::mutex> lock(c->mutex);
+        while (true) {
+            c->cv.wait(lock, [c] { return c->jobPending || c->quit; });
+            if (c->quit) return;
+            c->jobPending = false;
+            lock.unlock();
+
+            rasterizeOccluders(*c);
+            buildHierarchy(*c);
+
+            lock.lock();
+            c->jobDone = true;
+            c->cv.notify_all();
+        }
+    }
+}
+
+void startOcclusionCuller(OcclusionCuller& culler, int width, int height) {
+    culler.width = width;
+    culler.height = height;
+    culler.levels.clear(); culler.levelWidth.clear(); culler.levelHeight.clear();
+    int w = width, h = height;
+    while (true) {
+        culler.levels.push_back(std::vector<float>((size_t)w * h, 1.0f));
+        culler.levelWidth.push_back(w);
+        culler.levelHeight.push_back(h);
+        if (w == 1 && h == 1) break;
+        w = std::max(1, (w + 1) / 2);
+        h = std::max(1, (h + 1) / 2);
+    }
+    culler.quit = false;
+    culler.jobPending = false;
+    culler.jobDone = true;
+    culler.worker = std::thread(workerLoop, &culler);
+}
+
+void stopOcclusionCuller(OcclusionCuller& culler) {
+    {
+        std::lock_guard<std::mutex> lock(culler.mutex);
+        culler.quit = true;
+    }
+    culler.cv.notify_all();
+    if (culler.worker.joinable()) culler.worker.join();
+}
+
+void beginOcclusionFrame(OcclusionCuller& culler, const glm::mat4& viewProj, const std::vector<AABB>& occluders) {
+    std::unique_lock<std::mutex> lock(culler.mutex);
+    culler.cv.wait(lock, [&culler] { return culler.jobDone; });
+    culler.viewProj = viewProj;
+    culler.occluders = occluders;
+    culler.jobDone = false;
+    culler.jobPending = true;
+    culler.cv.notify_all();
+}
+
+int cullOccluded(OcclusionCuller& culler, BoundsBatch& batch) {
+    std::unique_lock<std::mutex> lock(culler.mutex);
+    culler.cv.wait(lock, [&culler] { return culler.jobDone; });
+    lock.unlock();
+
+    int occluded = 0;
+    for (size_t i = 0; i < batch.count; ++i) {
+        if (!batch.visible[i]) continue;
+        if (isOccluded(culler, batch.centerX[i], batch.centerY[i], batch.centerZ[i], batch.extentX[i], batch.extentY[i], batch.extentZ[i])) {
+            batch.visible[i] = 0;
+            ++occluded;
+        }
+    }
+    return occluded;
+}
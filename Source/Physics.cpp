@@ -0,0 +1,443 @@
+#include "../Header/Physics.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Matches the old per-frame fall rate (0.015 per frame at 75 fps).
+const float kGravity = -0.015f * 75.0f * 75.0f;
+const float kRestitution = 0.2f;
+const float kBounceThreshold = 1.0f;
+const float kFriction = 0.5f;
+const float kSlop = 0.005f;
+const float kCorrection = 0.8f;
+const float kSleepSpeed = 0.15f;
+const float kSleepDelay = 0.4f;
+const float kSkin = 0.001f;
+const int kMaxSweeps = 3;
+
+glm::vec3 bodyCenter(const PrizeStore& store, size_t i) {
+    return store.position[i] + glm::vec3(0.0f, store.halfExtents[i].y, 0.0f);
+}
+
+bool isKinematic(uint8_t flags) {
+    return (flags & PRIZE_CAUGHT) != 0;
+}
+
+float inverseMass(uint8_t flags) {
+    return (flags & (PRIZE_CAUGHT | PRIZE_ASLEEP | PRIZE_TAKEN)) ? 0.0f : 1.0f;
+}
+
+// Normals point from the first shape towards the second.
+bool collideBoxBox(glm::vec3 ca, glm::vec3 ha, glm::vec3 cb, glm::vec3 hb, glm::vec3& n, float& depth) {
+    glm::vec3 d = cb - ca;
+    glm::vec3 o = ha + hb - glm::abs(d);
+    if (o.x <= 0.0f || o.y <= 0.0f || o.z <= 0.0f) return false;
+    int axis = 0;
+    if (o.y < o[axis]) axis = 1;
+    if (o.z < o[axis]) axis = 2;
+    n = glm::vec3(0.0f);
+    n[axis] = d[axis] < 0.0f ? -1.0f : 1.0f;
+    depth = o[axis];
+    return true;
+}
+
+bool collideSphereSphere(glm::vec3 ca, float ra, glm::vec3 cb, float rb, glm::vec3& n, float& depth) {
+    glm::vec3 d = cb - ca;
+    float r = ra + rb;
+    float dist2 = glm::dot(d, d);
+    if (dist2 >= r * r) return false;
+    float dist = std::sqrt(dist2);
+    n = dist > 1e-6f ? d / dist : glm::vec3(0.0f, 1.0f, 0.0f);
+    depth = r - dist;
+    return true;
+}
+
+bool collideSphereBox(glm::vec3 cs, float r, glm::vec3 cb, glm::vec3 hb, glm::vec3& n, float& depth) {
+    glm::vec3 local = cs - cb;
+    glm::vec3 closest = glm::clamp(local, -hb, hb);
+    glm::vec3 diff = local - closest;
+    float dist2 = glm::dot(diff, diff);
+    if (dist2 >= r * r) return false;
+    if (dist2 > 1e-12f) {
+        float dist = std::sqrt(dist2);
+        n = -diff / dist;
+        depth = r - dist;
+        return true;
+    }
+    // Center inside the box: leave through the nearest face.
+    glm::vec3 gap = hb - glm::abs(local);
+    int axis = 0;
+    if (gap.y < gap[axis]) axis = 1;
+    if (gap.z < gap[axis]) axis = 2;
+    n = glm::vec3(0.0f);
+    n[axis] = local[axis] < 0.0f ? 1.0f : -1.0f;
+    depth = r + gap[axis];
+    return true;
+}
+
+struct Collider {
+    uint8_t shape;
+    glm::vec3 center;
+    glm::vec3 half;
+    glm::vec3 scale;
+    const ConvexHull* hull;
+};
+
+Collider bodyCollider(const PrizeStore& store, const std::vector<const Model*>& meshes, size_t i) {
+    Collider c = { store.shape[i], bodyCenter(store, i), store.halfExtents[i], store.scale[i], nullptr };
+    if (c.shape == SHAPE_HULL) c.hull = &meshes[store.mesh[i]]->hull;
+    return c;
+}
+
+Collider boxCollider(const AABB& box) {
+    Collider c = { SHAPE_BOX, (box.min + box.max) * 0.5f, (box.max - box.min) * 0.5f, glm::vec3(1.0f), nullptr };
+    return c;
+}
+
+// Boxes take part in convex tests as a scaled unit box hull.
+const ConvexHull& convexOf(const Collider& c, glm::vec3& scale) {
+    static const ConvexHull unitBox = makeBoxHull(AABB());
+    if (c.hull) { scale = c.scale; return *c.hull; }
+    scale = c.half * 2.0f;
+    return unitBox;
+}
+
+bool collideConvex(const Collider& a, const Collider& b, glm::vec3& n, float& depth) {
+    glm::vec3 sa, sb;
+    if (a.shape == SHAPE_SPHERE) {
+        const ConvexHull& hb = convexOf(b, sb);
+        return intersectSphereHull(a.center, a.half.x, hb, b.center, sb, n, depth);
+    }
+    if (b.shape == SHAPE_SPHERE) {
+        const ConvexHull& ha = convexOf(a, sa);
+        if (!intersectSphereHull(b.center, b.half.x, ha, a.center, sa, n, depth)) return false;
+        n = -n;
+        return true;
+    }
+    const ConvexHull& ha = convexOf(a, sa);
+    const ConvexHull& hb = convexOf(b, sb);
+    return intersectHulls(ha, a.center, sa, hb, b.center, sb, n, depth);
+}
+
+bool collideShapes(const Collider& a, const Collider& b, glm::vec3& n, float& depth) {
+    // The box half-extents of every body bound its hull, so this rejects most pairs cheaply.
+    glm::vec3 gap = glm::abs(b.center - a.center) - a.half - b.half;
+    if (gap.x > 0.0f || gap.y > 0.0f || gap.z > 0.0f) return false;
+    if (a.shape == SHAPE_HULL || b.shape == SHAPE_HULL) return collideConvex(a, b, n, depth);
+    if (a.shape == SHAPE_SPHERE && b.shape == SHAPE_SPHERE) return collideSphereSphere(a.center, a.half.x, b.center, b.half.x, n, depth);
+    if (a.shape == SHAPE_SPHERE) return collideSphereBox(a.center, a.half.x, b.center, b.half, n, depth);
+    if (b.shape == SHAPE_SPHERE) {
+        if (!collideSphereBox(b.center, b.half.x, a.center, a.half, n, depth)) return false;
+        n = -n;
+        return true;
+    }
+    return collideBoxBox(a.center, a.half, b.center, b.half, n, depth);
+}
+
+int findRoot(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void unite(std::vector<int>& parent, int a, int b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a != b) parent[std::max(a, b)] = std::min(a, b);
+}
+
+void buildGrid(PhysicsWorld& world, const PrizeStore& store) {
+    const size_t n = store.flags.size();
+    float maxHalf = 0.05f;
+    for (size_t i = 0; i < n; ++i) {
+        const glm::vec3& h = store.halfExtents[i];
+        maxHalf = std::max(maxHalf, std::max(h.x, std::max(h.y, h.z)));
+    }
+    // Any two overlapping bodies land in the same or adjacent cells.
+    world.cellSize = 2.0f * maxHalf;
+    glm::vec3 span = world.gridMax - world.gridMin;
+    for (int a = 0; a < 3; ++a)
+        world.dims[a] = glm::clamp((int)std::ceil(span[a] / world.cellSize), 1, 64);
+
+    const uint32_t cellCount = (uint32_t)(world.dims[0] * world.dims[1] * world.dims[2]);
+    world.cellStart.assign(cellCount + 1, 0);
+    world.cellOfBody.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (store.flags[i] & PRIZE_TAKEN) { world.cellOfBody[i] = cellCount; continue; }
+        glm::vec3 rel = (bodyCenter(store, i) - world.gridMin) / world.cellSize;
+        int cx = glm::clamp((int)std::floor(rel.x), 0, world.dims[0] - 1);
+        int cy = glm::clamp((int)std::floor(rel.y), 0, world.dims[1] - 1);
+        int cz = glm::clamp((int)std::floor(rel.z), 0, world.dims[2] - 1);
+        uint32_t cell = (uint32_t)((cz * world.dims[1] + cy) * world.dims[0] + cx);
+        world.cellOfBody[i] = cell;
+        world.cellStart[cell + 1]++;
+    }
+    for (uint32_t c = 0; c < cellCount; ++c) world.cellStart[c + 1] += world.cellStart[c];
+
+    world.cellBodies.resize(world.cellStart[cellCount]);
+    std::vector<uint32_t> fill(world.cellStart.begin(), world.cellStart.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t cell = world.cellOfBody[i];
+        if (cell == cellCount) continue;
+        world.cellBodies[fill[cell]++] = (uint32_t)i;
+    }
+}
+
+void findContacts(PhysicsWorld& world, const PrizeStore& store, const std::vector<const Model*>& meshes) {
+    const size_t n = store.flags.size();
+    const uint32_t cellCount = (uint32_t)(world.dims[0] * world.dims[1] * world.dims[2]);
+    world.contacts.clear();
+
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t fi = store.flags[i];
+        if (fi & (PRIZE_TAKEN | PRIZE_ASLEEP)) continue;
+        Collider ci = bodyCollider(store, meshes, i);
+
+        uint32_t cell = world.cellOfBody[i];
+        int cx = (int)(cell % (uint32_t)world.dims[0]);
+        int cy = (int)((cell / (uint32_t)world.dims[0]) % (uint32_t)world.dims[1]);
+        int cz = (int)(cell / (uint32_t)(world.dims[0] * world.dims[1]));
+        for (int z = std::max(cz - 1, 0); z <= std::min(cz + 1, world.dims[2] - 1); ++z)
+        for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, world.dims[1] - 1); ++y)
+        for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, world.dims[0] - 1); ++x) {
+            uint32_t c = (uint32_t)((z * world.dims[1] + y) * world.dims[0] + x);
+            if (c >= cellCount) continue;
+            for (uint32_t k = world.cellStart[c]; k < world.cellStart[c + 1]; ++k) {
+                uint32_t j = world.cellBodies[k];
+                // Awake pairs are visited once from the lower index; sleeping partners
+                // are only reached from the awake side.
+                if (j == i || (!(store.flags[j] & PRIZE_ASLEEP) && j < i)) continue;
+                if (isKinematic(fi) && isKinematic(store.flags[j])) continue;
+                world.stats.pairsTested++;
+                Contact ct;
+                if (collideShapes(ci, bodyCollider(store, meshes, j), ct.normal, ct.depth)) {
+                    ct.a = (uint32_t)i;
+                    ct.b = (int32_t)j;
+                    world.contacts.push_back(ct);
+                }
+            }
+        }
+
+        if (isKinematic(fi)) continue;
+        for (size_t s = 0; s < world.statics.size(); ++s) {
+            Contact ct;
+            if (collideShapes(ci, boxCollider(world.statics[s]), ct.normal, ct.depth)) {
+                ct.a = (uint32_t)i;
+                ct.b = -1 - (int32_t)s;
+                world.contacts.push_back(ct);
+            }
+        }
+    }
+}
+
+// Contacts are solved bottom-up, and the last pass uses shock propagation: the lower body
+// of a resting contact is treated as immovable so a stack settles in one sweep.
+void solveVelocities(PhysicsWorld& world, PrizeStore& store, float h) {
+    // Never bounce off the velocity gravity added during this very step.
+    const float bounceThreshold = std::max(kBounceThreshold, -2.0f * kGravity * h);
+    std::sort(world.contacts.begin(), world.contacts.end(), [&store](const Contact& x, const Contact& y) {
+        float hx = x.b >= 0 ? std::min(store.position[x.a].y, store.position[x.b].y) : -1e30f;
+        float hy = y.b >= 0 ? std::min(store.position[y.a].y, store.position[y.b].y) : -1e30f;
+        return hx < hy;
+    });
+
+    for (int it = 0; it < world.solverIterations; ++it) {
+        const bool shock = it == world.solverIterations - 1;
+        for (const Contact& ct : world.contacts) {
+            float invA = inverseMass(store.flags[ct.a]);
+            float invB = ct.b >= 0 ? inverseMass(store.flags[ct.b]) : 0.0f;
+            if (shock && ct.normal.y > 0.7f) invA = 0.0f;
+            if (shock && ct.normal.y < -0.7f) invB = 0.0f;
+            float invSum = invA + invB;
+            if (invSum <= 0.0f) continue;
+
+            glm::vec3 va = store.velocity[ct.a];
+            glm::vec3 vb = ct.b >= 0 ? store.velocity[ct.b] : glm::vec3(0.0f);
+            glm::vec3 rel = vb - va;
+            float vn = glm::dot(rel, ct.normal);
+            if (vn >= 0.0f) continue;
+
+            float e = vn < -bounceThreshold ? kRestitution : 0.0f;
+            float jn = -(1.0f + e) * vn / invSum;
+            glm::vec3 impulse = jn * ct.normal;
+
+            glm::vec3 tangent = rel - vn * ct.normal;
+            float tl = glm::length(tangent);
+            if (tl > 1e-6f) {
+                tangent /= tl;
+                float jt = glm::clamp(-tl / invSum, -kFriction * jn, kFriction * jn);
+                impulse += jt * tangent;
+            }
+
+            store.velocity[ct.a] -= impulse * invA;
+            if (ct.b >= 0) store.velocity[ct.b] += impulse * invB;
+        }
+    }
+}
+
+// Same bottom-up shock propagation as the last velocity pass, so a stack is pushed apart
+// upwards instead of being squeezed into the floor.
+void correctPositions(const PhysicsWorld& world, PrizeStore& store) {
+    for (const Contact& ct : world.contacts) {
+        float invA = inverseMass(store.flags[ct.a]);
+        float invB = ct.b >= 0 ? inverseMass(store.flags[ct.b]) : 0.0f;
+        if (ct.normal.y > 0.7f && invB > 0.0f) invA = 0.0f;
+        if (ct.normal.y < -0.7f && invA > 0.0f) invB = 0.0f;
+        float invSum = invA + invB;
+        float excess = ct.depth - kSlop;
+        if (invSum <= 0.0f || excess <= 0.0f) continue;
+        glm::vec3 push = ct.normal * (excess * kCorrection / invSum);
+        store.position[ct.a] -= push * invA;
+        if (ct.b >= 0) store.position[ct.b] += push * invB;
+    }
+}
+
+// Time of impact of a box moving by d against a static box, found as a ray cast from the
+// box centre into the static box grown by the half-extents.
+bool sweepBox(glm::vec3 c, glm::vec3 half, glm::vec3 d, const AABB& box, float& toi, glm::vec3& normal) {
+    glm::vec3 lo = box.min - half, hi = box.max + half;
+    if (c.x > lo.x && c.x < hi.x && c.y > lo.y && c.y < hi.y && c.z > lo.z && c.z < hi.z) return false;
+    float t0 = 0.0f, t1 = 1.0f;
+    int hitAxis = -1;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (std::fabs(d[axis]) < 1e-12f) {
+            if (c[axis] <= lo[axis] || c[axis] >= hi[axis]) return false;
+            continue;
+        }
+        float inv = 1.0f / d[axis];
+        float ta = (lo[axis] - c[axis]) * inv, tb = (hi[axis] - c[axis]) * inv;
+        if (ta > tb) std::swap(ta, tb);
+        if (ta > t0) { t0 = ta; hitAxis = axis; }
+        t1 = std::min(t1, tb);
+        if (t0 > t1) return false;
+    }
+    if (hitAxis < 0) return false;
+    toi = t0;
+    normal = glm::vec3(0.0f);
+    normal[hitAxis] = d[hitAxis] > 0.0f ? -1.0f : 1.0f;
+    return true;
+}
+
+// Moves awake bodies by v * h. A body that travels more than half its smallest extent
+// in one step is swept against the static boxes: it stops at the first time of impact,
+// loses the velocity into that surface and slides along it for the rest of the step.
+void integrateSwept(PhysicsWorld& world, PrizeStore& store, float h) {
+    world.stats.sweptBodies = 0;
+    world.stats.sweptHits = 0;
+    for (size_t i = 0; i < store.flags.size(); ++i) {
+        if (inverseMass(store.flags[i]) <= 0.0f) continue;
+        glm::vec3 d = store.velocity[i] * h;
+        const glm::vec3& half = store.halfExtents[i];
+        float minHalf = std::min(half.x, std::min(half.y, half.z));
+        if (glm::dot(d, d) <= 0.25f * minHalf * minHalf) {
+            store.position[i] += d;
+            continue;
+        }
+
+        world.stats.sweptBodies++;
+        glm::vec3 c = bodyCenter(store, i);
+        for (int sweep = 0; sweep < kMaxSweeps; ++sweep) {
+            float toi = 1.0f;
+            glm::vec3 normal(0.0f);
+            for (const AABB& box : world.statics) {
+                float t;
+                glm::vec3 n;
+                if (sweepBox(c, half, d, box, t, n) && t < toi) { toi = t; normal = n; }
+            }
+            if (toi >= 1.0f) { c += d; break; }
+
+            // Stop just inside the surface so the contact solver sees the touch and
+            // applies friction next step.
+            world.stats.sweptHits++;
+            c += d * toi - normal * kSkin;
+            glm::vec3 rest = d * (1.0f - toi);
+            d = rest - normal * glm::dot(rest, normal);
+            float vn = glm::dot(store.velocity[i], normal);
+            if (vn < 0.0f) store.velocity[i] -= normal * vn;
+        }
+        store.position[i] = c - glm::vec3(0.0f, half.y, 0.0f);
+    }
+}
+
+// Bodies touching each other form an island; an island sleeps only when every member
+// has been slow for kSleepDelay, and any fast member wakes the whole island.
+void updateIslands(PhysicsWorld& world, PrizeStore& store, float h) {
+    const int n = (int)store.flags.size();
+    world.islandParent.resize(n);
+    for (int i = 0; i < n; ++i) world.islandParent[i] = i;
+    for (const Contact& ct : world.contacts)
+        if (ct.b >= 0) unite(world.islandParent, (int)ct.a, ct.b);
+
+    for (int i = 0; i < n; ++i) {
+        uint8_t f = store.flags[i];
+        if (f & (PRIZE_TAKEN | PRIZE_ASLEEP)) continue;
+        float speed2 = glm::dot(store.velocity[i], store.velocity[i]);
+        if (isKinematic(f) || speed2 > kSleepSpeed * kSleepSpeed) store.sleepTimer[i] = 0.0f;
+        else store.sleepTimer[i] += h;
+    }
+
+    world.islandRest.assign(n, 1);
+    world.islandFast.assign(n, 0);
+    for (int i = 0; i < n; ++i) {
+        if (store.flags[i] & PRIZE_TAKEN) continue;
+        int root = findRoot(world.islandParent, i);
+        if (store.sleepTimer[i] < kSleepDelay) world.islandRest[root] = 0;
+        if (!(store.flags[i] & PRIZE_ASLEEP) && store.sleepTimer[i] == 0.0f) world.islandFast[root] = 1;
+    }
+
+    world.stats.islands = 0;
+    world.stats.awake = 0;
+    for (int i = 0; i < n; ++i) {
+        uint8_t& f = store.flags[i];
+        if (f & PRIZE_TAKEN) continue;
+        int root = findRoot(world.islandParent, i);
+        if (root == i) world.stats.islands++;
+        if (world.islandRest[root] && !isKinematic(f)) {
+            f = (uint8_t)((f | PRIZE_ASLEEP) & ~PRIZE_FALLING);
+            store.velocity[i] = glm::vec3(0.0f);
+        }
+        else if (world.islandFast[root] && (f & PRIZE_ASLEEP)) {
+            f &= (uint8_t)~PRIZE_ASLEEP;
+            store.sleepTimer[i] = 0.0f;
+        }
+        if (!(f & PRIZE_ASLEEP)) world.stats.awake++;
+    }
+}
+
+}
+
+void initPhysicsWorld(PhysicsWorld& world, const std::vector<AABB>& statics) {
+    world.statics = statics;
+    world.accumulator = 0.0f;
+    world.stats = PhysicsStats();
+}
+
+void stepPhysicsFixed(PhysicsWorld& world, PrizeStore& store, const std::vector<const Model*>& meshes, float h) {
+    const size_t n = store.flags.size();
+    world.stats.pairsTested = 0;
+    world.stats.bodies = (int)n;
+
+    for (size_t i = 0; i < n; ++i)
+        if (inverseMass(store.flags[i]) > 0.0f) store.velocity[i].y += kGravity * h;
+
+    buildGrid(world, store);
+    findContacts(world, store, meshes);
+    world.stats.contacts = (int)world.contacts.size();
+
+    solveVelocities(world, store, h);
+    integrateSwept(world, store, h);
+    correctPositions(world, store);
+
+    updateIslands(world, store, h);
+}
+
+void stepPhysics(PhysicsWorld& world, PrizeStore& store, const std::vector<const Model*>& meshes, float dt) {
+    world.accumulator = std::min(world.accumulator + dt, world.fixedStep * world.maxSubSteps);
+    while (world.accumulator >= world.fixedStep) {
+        stepPhysicsFixed(world, store, meshes, world.fixedStep);
+        world.accumulator -= world.fixedStep;
+    }
+}
@@ -0,0 +1,175 @@
+#include "../Header/Prizes.h"
+#include <algorithm>
+
+namespace {
+
+// Falls back to a box when the model has no hull; spheres take the largest half extent.
+glm::vec3 shapeHalfExtents(const Model& model, glm::vec3 scale, PrizeShape& shape) {
+    glm::vec3 halfE = model.halfExtents * scale;
+    if (shape == SHAPE_HULL && model.hull.vertices.empty()) shape = SHAPE_BOX;
+    if (shape == SHAPE_SPHERE) halfE = glm::vec3(std::max(halfE.x, std::max(halfE.y, halfE.z)));
+    return halfE;
+}
+
+}
+
+size_t prizeCount(const PrizeStore& store) {
+    return store.flags.size();
+}
+
+uint32_t addPrize(PrizeStore& store, const std::vector<const Model*>& meshes, glm::vec3 position, glm::vec3 color, uint32_t mesh, glm::vec3 scale, PrizeShape shape) {
+    uint32_t id = (uint32_t)prizeCount(store);
+    glm::vec3 halfE = shapeHalfExtents(*meshes[mesh], scale, shape);
+    store.position.push_back(position);
+    store.scale.push_back(scale);
+    store.velocity.push_back(glm::vec3(0.0f));
+    store.halfExtents.push_back(halfE);
+    store.shape.push_back((uint8_t)shape);
+    store.sleepTimer.push_back(0.0f);
+    store.flags.push_back(0);
+    store.mesh.push_back(mesh);
+    store.color.push_back(color);
+    return id;
+}
+
+void refreshPrizeExtents(PrizeStore& store, const std::vector<const Model*>& meshes, uint32_t mesh) {
+    for (size_t i = 0; i < prizeCount(store); ++i) {
+        if (store.mesh[i] != mesh) continue;
+        PrizeShape shape = (PrizeShape)store.shape[i];
+        store.halfExtents[i] = shapeHalfExtents(*meshes[mesh], store.scale[i], shape);
+        store.shape[i] = (uint8_t)shape;
+    }
+}
+
+bool anyPrize(const PrizeStore& store, uint8_t required, uint8_t excluded) {
+    for (uint8_t f : store.flags)
+        if ((f & required) == required && (f & excluded) == 0) return true;
+    return false;
+}
+
+// Returns the highest prize whose convex pieces touch the volume, so the claw takes the
+// top of a pile rather than whatever happens to be closest to its axis.
+int findPrizeInVolume(const PrizeStore& store, const std::vector<const Model*>& meshes, const AABB& volume) {
+    int best = -1;
+    for (size_t i = 0; i < store.flags.size(); ++i) {
+        if (store.flags[i] & (PRIZE_DROPPED | PRIZE_TAKEN)) continue;
+        const glm::vec3& halfE = store.halfExtents[i];
+        glm::vec3 center = store.position[i] + glm::vec3(0.0f, halfE.y, 0.0f);
+        glm::vec3 gap = glm::abs(center - (volume.min + volume.max) * 0.5f) - halfE - (volume.max - volume.min) * 0.5f;
+        if (gap.x > 0.0f || gap.y > 0.0f || gap.z > 0.0f) continue;
+
+        const Model& m = *meshes[store.mesh[i]];
+        bool touching = m.hullPieces.empty() && m.hull.vertices.empty();
+        for (const ConvexHull& piece : m.hullPieces) {
+            if (hullOverlapsBox(piece, center, store.scale[i], volume)) { touching = true; break; }
+        }
+        if (!touching && m.hullPieces.empty() && !m.hull.vertices.empty())
+            touching = hullOverlapsBox(m.hull, center, store.scale[i], volume);
+        if (touching && (best < 0 || store.position[i].y > store.position[best].y)) best = (int)i;
+    }
+    return best;
+}
+
+void buildPrizeBvh(const PrizeStore& store, const std::vector<const Model*>& meshes, SceneBvh& bvh) {
+    std::vector<BvhInstance> instances;
+    for (size_t i = 0; i < store.flags.size(); ++i) {
+        if (store.flags[i] & (PRIZE_DROPPED | PRIZE_TAKEN)) continue;
+        const Model& m = *meshes[store.mesh[i]];
+        if (m.bvh.tree.nodes.empty()) continue;
+        BvhInstance inst;
+        inst.mesh = &m.bvh;
+        inst.position = store.position[i] + glm::vec3(0.0f, store.halfExtents[i].y, 0.0f);
+        inst.scale = store.scale[i];
+        inst.id = (uint32_t)i;
+        instances.push_back(inst);
+    }
+    buildSceneBvh(bvh, instances);
+}
+
+// Most hits wins; ties go to the higher prize.
+int findMostTouchedPrize(const PrizeStore& store, const std::vector<uint32_t>& touched) {
+    int best = -1, bestHits = 0;
+    for (uint32_t id : touched) {
+        int hits = (int)std::count(touched.begin(), touched.end(), id);
+        if (hits > bestHits || (hits == bestHits && store.position[id].y > store.position[best].y)) {
+            best = (int)id;
+            bestHits = hits;
+        }
+    }
+    return best;
+}
+
+int takeDroppedPrizes(PrizeStore& store) {
+    int taken = 0;
+    for (uint8_t& f : store.flags) {
+        if ((f & PRIZE_DROPPED) && !(f & PRIZE_TAKEN)) { f |= PRIZE_TAKEN; ++taken; }
+    }
+    return taken;
+}
+
+int releaseCaughtPrizes(PrizeStore& store) {
+    int released = 0;
+    for (size_t i = 0; i < store.flags.size(); ++i) {
+        if (!(store.flags[i] & PRIZE_CAUGHT)) continue;
+        store.flags[i] = (uint8_t)((store.flags[i] & ~(PRIZE_CAUGHT | PRIZE_ASLEEP)) | PRIZE_FALLING);
+        store.velocity[i] = glm::vec3(0.0f);
+        store.sleepTimer[i] = 0.0f;
+        ++released;
+    }
+    return released;
+}
+
+int markPrizesInside(PrizeStore& store, const AABB& region, uint8_t flag) {
+    int marked = 0;
+    for (size_t i = 0; i < store.flags.size(); ++i) {
+        if (store.flags[i] & (PRIZE_TAKEN | PRIZE_CAUGHT | flag)) continue;
+        glm::vec3 c = store.position[i] + glm::vec3(0.0f, store.halfExtents[i].y, 0.0f);
+        if (c.x < region.min.x || c.y < region.min.y || c.z < region.min.z) continue;
+        if (c.x > region.max.x || c.y > region.max.y || c.z > region.max.z) continue;
+        store.flags[i] |= flag;
+        ++marked;
+    }
+    return marked;
+}
+
+void updateCaughtPrizes(PrizeStore& store, glm::vec3 clawPos) {
+    const float baseOffset = 0.35f;
+    const float glassInset = 0.06f;
+    const float topLimit = 6.8f;
+    const float bottomLimit = 0.36f;
+    const float followLerp = 0.35f;
+
+    for (size_t i = 0; i < store.flags.size(); ++i) {
+        if (!(store.flags[i] & PRIZE_CAUGHT)) continue;
+        glm::vec3 halfE = store.halfExtents[i];
+        float offset = baseOffset + halfE.y * 0.6f;
+
+        glm::vec3 desiredPos = glm::vec3(clawPos.x, clawPos.y - offset, clawPos.z);
+        desiredPos.x = glm::clamp(desiredPos.x, -1.95f + halfE.x + glassInset, 1.95f - halfE.x - glassInset);
+        desiredPos.z = glm::clamp(desiredPos.z, -1.95f + halfE.z + glassInset, 1.95f - halfE.z - glassInset);
+        desiredPos.y = glm::clamp(desiredPos.y, bottomLimit + halfE.y, topLimit - halfE.y);
+
+        store.position[i] = glm::mix(store.position[i], desiredPos, followLerp);
+    }
+}
+
+void queuePrizeDraws(PrizeStore& store, const std::vector<const Model*>& meshes, DrawList& list) {
+    const float extraYOffset = 0.01f;
+    clearTRS(store.transforms);
+    for (size_t i = 0; i < store.flags.size(); ++i) {
+        if (store.flags[i] & PRIZE_TAKEN) continue;
+        const glm::vec3& pos = store.position[i];
+        float lift = meshes[store.mesh[i]]->halfHeight * store.scale[i].y + extraYOffset;
+        addTRS(store.transforms, glm::vec3(pos.x, pos.y + lift, pos.z), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), store.scale[i]);
+    }
+    store.models.resize(store.transforms.count);
+    composeTRS(store.transforms, store.models.data());
+
+    size_t n = 0;
+    for (size_t i = 0; i < store.flags.size(); ++i) {
+        if (store.flags[i] & PRIZE_TAKEN) continue;
+        const Model& m = *meshes[store.mesh[i]];
+        if (!m.meshlets.meshlets.empty()) queueMeshletDraw(list, m.mesh, m.meshlets, store.models[n++], store.color[i], m.bounds);
+        else queueDraw(list, m.mesh, store.models[n++], store.color[i], 1.0f, nullptr, m.bounds);
+    }
+}
@@ -0,0 +1,37 @@
+#include "../Header/SceneGraph.h"
+#include <algorithm>
+#include <cstring>
+
+int addNode(TransformHierarchy& h, int parent, const glm::mat4& local) {
+    int index = (int)h.parent.size();
+    if (parent >= index) parent = -1;
+    h.parent.push_back(parent);
+    h.local.push_back(local);
+    h.world.push_back(local);
+    h.dirty.push_back(1);
+    h.firstDirty = std::min(h.firstDirty, (size_t)index);
+    return index;
+}
+
+void setLocal(TransformHierarchy& h, int node, const glm::mat4& local) {
+    if (std::memcmp(&h.local[node], &local, sizeof(glm::mat4)) == 0) return;
+    h.local[node] = local;
+    h.dirty[node] = 1;
+    h.firstDirty = std::min(h.firstDirty, (size_t)node);
+}
+
+int updateWorldTransforms(TransformHierarchy& h) {
+    const size_t n = h.parent.size();
+    int updated = 0;
+    for (size_t i = h.firstDirty; i < n; ++i) {
+        int p = h.parent[i];
+        if (p >= 0 && h.dirty[p]) h.dirty[i] = 1;
+        if (!h.dirty[i]) continue;
+        h.world[i] = p >= 0 ? h.world[p] * h.local[i] : h.local[i];
+        ++updated;
+    }
+    // Flags are cleared only after the pass so children can still see a dirty parent.
+    if (h.firstDirty < n) std::fill(h.dirty.begin() + h.firstDirty, h.dirty.end(), 0);
+    h.firstDirty = n;
+    return updated;
+}
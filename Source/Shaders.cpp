@@ -0,0 +1,387 @@
+#include "../Header/Shaders.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+struct FeatureDefine {
+    uint32_t bit;
+    const char* name;
+};
+
+const FeatureDefine kFeatureDefines[] = {
+    { SHADER_TEXTURED, "TEXTURED" },
+    { SHADER_LIT, "LIT" },
+    { SHADER_LOCAL_LIGHTS, "LOCAL_LIGHTS" },
+    { SHADER_ALPHA_TEST, "ALPHA_TEST" },
+    { SHADER_INSTANCED, "INSTANCED" }
+};
+
+bool readFile(const char* path, std::string& out) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cout << "Greska pri citanju fajla sa putanje \"" << path << "\"!" << std::endl;
+        return false;
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    out = ss.str();
+    return true;
+}
+
+const char kBinaryMagic[4] = { 'K', 'P', 'B', '2' };
+
+// Stored field by field, little endian, with no padding: magic, format, key, length.
+struct BinaryHeader {
+    char magic[4];
+    uint32_t format;
+    uint64_t key;
+    uint32_t length;
+};
+const size_t kBinaryHeaderBytes = 4 + 4 + 8 + 4;
+
+void writeBytes(std::ofstream& file, uint64_t value, int bytes) {
+    char out[8];
+    for (int i = 0; i < bytes; ++i) out[i] = (char)((value >> (8 * i)) & 0xFF);
+    file.write(out, bytes);
+}
+
+uint64_t readBytes(const unsigned char* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) value |= (uint64_t)in[i] << (8 * i);
+    return value;
+}
+
+uint64_t hashString(uint64_t h, const std::string& s) {
+    for (unsigned char c : s) h = (h ^ c) * 1099511628211ull;
+    return (h ^ 0xFF) * 1099511628211ull;
+}
+
+std::string cachePath(const ShaderLibrary& lib, uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return lib.cacheDirectory + "/" + name;
+}
+
+bool binaryCacheSupported() {
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary) return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+unsigned int loadProgramBinary(const ShaderLibrary& lib, uint64_t key) {
+    std::ifstream file(cachePath(lib, key), std::ios::binary);
+    if (!file.is_open()) return 0;
+    file.seekg(0, std::ios::end);
+    const std::streamoff fileBytes = file.tellg();
+    file.seekg(0, std::ios::beg);
+    unsigned char raw[kBinaryHeaderBytes];
+    if (fileBytes < (std::streamoff)kBinaryHeaderBytes || !file.read((char*)raw, kBinaryHeaderBytes)) return 0;
+    BinaryHeader header;
+    std::memcpy(header.magic, raw, 4);
+    header.format = (uint32_t)readBytes(raw + 4, 4);
+    header.key = readBytes(raw + 8, 8);
+    header.length = (uint32_t)readBytes(raw + 16, 4);
+    // A truncated or padded file is a miss, before anything is allocated from its length.
+    if (std::memcmp(header.magic, kBinaryMagic, 4) != 0 || header.key != key || header.length == 0
+        || (std::streamoff)header.length != fileBytes - (std::streamoff)kBinaryHeaderBytes) return 0;
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), header.length)) return 0;
+    file.close();
+
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)header.length);
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success == GL_FALSE) {
+        // Usually a driver update that the version string did not reflect.
+        std::cout << "Odbacen kes sejdera " << cachePath(lib, key) << std::endl;
+        glDeleteProgram(program);
+        std::remove(cachePath(lib, key).c_str());
+        return 0;
+    }
+    return program;
+}
+
+void saveProgramBinary(const ShaderLibrary& lib, uint64_t key, unsigned int program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    std::vector<char> binary(length);
+    BinaryHeader header;
+    std::memcpy(header.magic, kBinaryMagic, 4);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, NULL, &format, binary.data());
+    header.format = format;
+    header.key = key;
+    header.length = (uint32_t)length;
+#ifdef _WIN32
+    _mkdir(lib.cacheDirectory.c_str());
+#else
+    mkdir(lib.cacheDirectory.c_str(), 0755);
+#endif
+    std::ofstream file(cachePath(lib, key), std::ios::binary);
+    if (!file.is_open()) return;
+    file.write(header.magic, 4);
+    writeBytes(file, header.format, 4);
+    writeBytes(file, header.key, 8);
+    writeBytes(file, header.length, 4);
+    file.write(binary.data(), length);
+}
+
+// The defines go right after #version; #line keeps compiler messages on the file's lines.
+std::string specialize(const std::string& source, uint32_t features) {
+    size_t versionEnd = source.find('\n', source.find("#version"));
+    if (versionEnd == std::string::npos) versionEnd = 0;
+    else ++versionEnd;
+    std::string defines;
+    for (const FeatureDefine& f : kFeatureDefines)
+        if (features & f.bit) defines += std::string("#define ") + f.name + "\n";
+    defines += "#line 2\n";
+    return source.substr(0, versionEnd) + defines + source.substr(versionEnd);
+}
+
+unsigned int startStage(GLenum type, const std::string& source) {
+    unsigned int shader = glCreateShader(type);
+    const char* code = source.c_str();
+    glShaderSource(shader, 1, &code, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+bool stageCompiled(unsigned int shader, GLenum type, uint32_t features) {
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (success == GL_FALSE) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cout << (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT") << " sejder varijante " << features << " ima gresku! Greska: \n" << infoLog << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Sampler units and block bindings never change, so they are set once per program.
+void bindProgramSlots(unsigned int program) {
+    GLint previous = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previous);
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "uTex"), kMaterialTextureUnit);
+    glUniform1i(glGetUniformLocation(program, "clusterData"), kClusterTextureUnit);
+    glUniform1i(glGetUniformLocation(program, "shadowMap"), kShadowTextureUnit);
+    glUseProgram(previous);
+    GLuint frameBlock = glGetUniformBlockIndex(program, "Frame");
+    if (frameBlock != GL_INVALID_INDEX) glUniformBlockBinding(program, frameBlock, kFrameBlockBinding);
+    GLuint lightsBlock = glGetUniformBlockIndex(program, "Lights");
+    if (lightsBlock != GL_INVALID_INDEX) glUniformBlockBinding(program, lightsBlock, kLightsBlockBinding);
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Issues the compile and link without asking for any status, so with
+// KHR_parallel_shader_compile the driver works on it in the background. Variants found
+// in the binary cache are ready at once.
+void startVariant(ShaderLibrary& lib, uint32_t features) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    PendingShader pending;
+    pending.features = features;
+    pending.requested = start;
+    const std::string vertexSource = specialize(lib.vertexSource, features);
+    const std::string fragmentSource = specialize(lib.fragmentSource, features);
+    pending.cached = !lib.cacheDirectory.empty() && binaryCacheSupported();
+    if (pending.cached) {
+        if (lib.driverKey.empty()) {
+            const GLenum names[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+            for (GLenum name : names) {
+                const GLubyte* value = glGetString(name);
+                lib.driverKey += value ? (const char*)value : "?";
+                lib.driverKey += '\n';
+            }
+        }
+        pending.key = hashString(hashString(hashString(14695981039346656037ull, lib.driverKey), vertexSource), fragmentSource);
+        unsigned int program = loadProgramBinary(lib, pending.key);
+        if (program) {
+            bindProgramSlots(program);
+            lib.programs[features] = program;
+            ++lib.cacheHits;
+            double ms = msSince(start);
+            lib.buildMs += ms;
+            std::cout << "Sejder varijanta " << features << " ucitana iz kesa za " << ms << " ms" << std::endl;
+            return;
+        }
+    }
+
+    pending.vertexShader = startStage(GL_VERTEX_SHADER, vertexSource);
+    pending.fragmentShader = startStage(GL_FRAGMENT_SHADER, fragmentSource);
+    pending.program = glCreateProgram();
+    glAttachShader(pending.program, pending.vertexShader);
+    glAttachShader(pending.program, pending.fragmentShader);
+    if (pending.cached) glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(pending.program);
+    lib.pending.push_back(pending);
+    lib.buildMs += msSince(start);
+}
+
+// Collects the result of a pending variant; blocks if the driver is not done yet.
+void finishVariant(ShaderLibrary& lib, size_t index) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    PendingShader pending = lib.pending[index];
+    lib.pending.erase(lib.pending.begin() + index);
+
+    bool compiled = stageCompiled(pending.vertexShader, GL_VERTEX_SHADER, pending.features);
+    compiled = stageCompiled(pending.fragmentShader, GL_FRAGMENT_SHADER, pending.features) && compiled;
+    unsigned int program = pending.program;
+    glDetachShader(program, pending.vertexShader);
+    glDeleteShader(pending.vertexShader);
+    glDetachShader(program, pending.fragmentShader);
+    glDeleteShader(pending.fragmentShader);
+
+    int success = GL_FALSE;
+    if (compiled) glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success == GL_FALSE) {
+        if (compiled) {
+            char infoLog[512];
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "Objedinjeni sejder varijante " << pending.features << " ima gresku! Greska: \n" << infoLog << std::endl;
+        }
+        glDeleteProgram(program);
+        program = 0;
+    } else {
+        if (pending.cached) saveProgramBinary(lib, pending.key, program);
+        bindProgramSlots(program);
+        ++lib.cacheMisses;
+        std::cout << "Sejder varijanta " << pending.features << " kompajlirana, spremna " << msSince(pending.requested) << " ms posle zahteva" << std::endl;
+    }
+    lib.programs[pending.features] = program;
+    lib.buildMs += msSince(start);
+}
+
+int findPending(const ShaderLibrary& lib, uint32_t features) {
+    for (size_t i = 0; i < lib.pending.size(); ++i)
+        if (lib.pending[i].features == features) return (int)i;
+    return -1;
+}
+}
+
+bool initShaderLibrary(ShaderLibrary& lib, const char* vertexPath, const char* fragmentPath, const char* cacheDirectory) {
+    lib.cacheDirectory = cacheDirectory ? cacheDirectory : "";
+    if (GLEW_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+    if (!readFile(vertexPath, lib.vertexSource) || !readFile(fragmentPath, lib.fragmentSource)) return false;
+    lib.latestVertexSource = lib.vertexSource;
+    lib.latestFragmentSource = lib.fragmentSource;
+    return true;
+}
+
+void requestShaderVariants(ShaderLibrary& lib, const uint32_t* features, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        if (lib.programs.find(features[i]) == lib.programs.end() && findPending(lib, features[i]) < 0) startVariant(lib, features[i]);
+}
+
+size_t pollShaderVariants(ShaderLibrary& lib) {
+    if (!GLEW_KHR_parallel_shader_compile) return lib.pending.size();
+    for (size_t i = 0; i < lib.pending.size();) {
+        GLint done = GL_FALSE;
+        glGetProgramiv(lib.pending[i].program, GL_COMPLETION_STATUS_KHR, &done);
+        if (done) finishVariant(lib, i);
+        else ++i;
+    }
+    return lib.pending.size();
+}
+
+unsigned int getShaderVariant(ShaderLibrary& lib, uint32_t features) {
+    auto it = lib.programs.find(features);
+    if (it != lib.programs.end()) return it->second;
+    if (findPending(lib, features) < 0) startVariant(lib, features);
+    int index = findPending(lib, features);
+    if (index >= 0) finishVariant(lib, index);
+    return lib.programs[features];
+}
+
+bool reloadShaderSources(ShaderLibrary& lib, const std::string& vertexSource, const std::string& fragmentSource) {
+    lib.latestVertexSource = vertexSource;
+    lib.latestFragmentSource = fragmentSource;
+    while (!lib.pending.empty()) finishVariant(lib, 0);
+    ShaderLibrary fresh;
+    fresh.vertexSource = vertexSource;
+    fresh.fragmentSource = fragmentSource;
+    fresh.cacheDirectory = lib.cacheDirectory;
+    fresh.driverKey = lib.driverKey;
+    std::vector<uint32_t> features;
+    for (const auto& entry : lib.programs) features.push_back(entry.first);
+    requestShaderVariants(fresh, features.data(), features.size());
+    bool ok = true;
+    for (const auto& entry : lib.programs)
+        if (entry.second != 0 && getShaderVariant(fresh, entry.first) == 0) ok = false;
+    lib.cacheHits += fresh.cacheHits;
+    lib.cacheMisses += fresh.cacheMisses;
+    lib.buildMs += fresh.buildMs;
+    if (!ok) {
+        std::cout << "Sejderi nisu zamenjeni, zadrzane su stare varijante." << std::endl;
+        deleteShaderLibrary(fresh);
+        return false;
+    }
+    // Swap only once every variant in use has built, so a typo never leaves a hole.
+    std::swap(lib.programs, fresh.programs);
+    lib.vertexSource = vertexSource;
+    lib.fragmentSource = fragmentSource;
+    deleteShaderLibrary(fresh);
+    return true;
+}
+
+bool reloadShaderStage(ShaderLibrary& lib, GLenum stage, const std::string& source) {
+    // Copies, since reloadShaderSources overwrites the latest sources it is handed.
+    std::string vertexSource = stage == GL_VERTEX_SHADER ? source : lib.latestVertexSource;
+    std::string fragmentSource = stage == GL_FRAGMENT_SHADER ? source : lib.latestFragmentSource;
+    return reloadShaderSources(lib, vertexSource, fragmentSource);
+}
+
+unsigned int useShaderVariant(ShaderLibrary& lib, uint32_t features) {
+    unsigned int program = getShaderVariant(lib, features);
+    glUseProgram(program);
+    return program;
+}
+
+void deleteShaderLibrary(ShaderLibrary& lib) {
+    while (!lib.pending.empty()) finishVariant(lib, 0);
+    for (auto& entry : lib.programs)
+        if (entry.second) glDeleteProgram(entry.second);
+    lib.programs.clear();
+}
+
+uint32_t surfaceVariant(bool textured, bool instanced) {
+    uint32_t features = textured ? (SHADER_TEXTURED | SHADER_ALPHA_TEST) : (SHADER_LIT | SHADER_LOCAL_LIGHTS);
+    if (instanced) features |= SHADER_INSTANCED;
+    return features;
+}
+
+uint32_t shadowVariant(bool instanced) {
+    return instanced ? (uint32_t)SHADER_INSTANCED : 0u;
+}
+
+size_t uniformBlockAlignment() {
+    static GLint alignment = 0;
+    if (alignment == 0) glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    return (size_t)std::max<GLint>(alignment, 16);
+}
+
+void bindFrameUniforms(StreamRing& ring, const FrameUniforms& frame) {
+    size_t offset;
+    unsigned char* dst = streamAllocate(ring, sizeof(FrameUniforms), uniformBlockAlignment(), offset);
+    *(FrameUniforms*)dst = frame;
+    streamCommit(ring, offset, sizeof(FrameUniforms));
+    streamBindUniforms(ring, kFrameBlockBinding, offset, sizeof(FrameUniforms), uniformBlockAlignment());
+}
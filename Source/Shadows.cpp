@@ -0,0 +1,182 @@
+#include "../Header/Shadows.h"
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+
+// Keeps the cone edge inside the map despite PCF taps reaching outward.
+const float kConeMargin = 1.1f;
+// Depth slope bias of the shadow passes, against acne on lit surfaces.
+const float kOffsetFactor = 2.0f;
+const float kOffsetUnits = 4.0f;
+
+bool createDepthTarget(int size, bool sampled, unsigned int& texture, unsigned int& framebuffer) {
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size, size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, sampled ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, sampled ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    const float border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+    if (sampled) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return complete;
+}
+
+uint64_t hashBytes(uint64_t h, const void* data, size_t bytes) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < bytes; ++i) h = (h ^ p[i]) * 1099511628211ull;
+    return h;
+}
+
+// Only what reaches the map: surviving commands and the transforms they draw with.
+uint64_t hashCasters(const DrawList& casters) {
+    uint64_t h = hashBytes(14695981039346656037ull, casters.commands.data(), casters.commands.size() * sizeof(DrawElementsIndirectCommand));
+    uint32_t last = UINT32_MAX;
+    for (const DrawElementsIndirectCommand& cmd : casters.commands) {
+        if (cmd.baseInstance == last) continue;
+        last = cmd.baseInstance;
+        h = hashBytes(h, &casters.models[cmd.baseInstance], sizeof(glm::mat4));
+    }
+    return h;
+}
+
+void drawDepth(SpotShadow& shadow, unsigned int framebuffer, bool clear, DrawList& casters, MeshPool& pool, StreamRing& ring, ShaderLibrary& shaders) {
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, shadow.size, shadow.size);
+    glEnable(GL_DEPTH_TEST);
+    if (clear) glClear(GL_DEPTH_BUFFER_BIT);
+    if (!casters.commands.empty()) {
+        FrameUniforms frame;
+        frame.view = shadow.view;
+        frame.projection = shadow.projection;
+        frame.viewPos = glm::vec4(shadow.position, 1.0f);
+        bindFrameUniforms(ring, frame);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(kOffsetFactor, kOffsetUnits);
+        submitDrawList(casters, pool, ring, shaders, true);
+        glDisable(GL_POLYGON_OFFSET_FILL);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (!depthTest) glDisable(GL_DEPTH_TEST);
+}
+
+int cullCasters(const SpotShadow& shadow, DrawList& casters) {
+    CullStats cull;
+    cullDrawList(casters, shadow.frustum, cull);
+    buildDrawCommands(casters, shadow.frustum, shadow.position, cull);
+    return cull.tested - cull.culled;
+}
+
+}
+
+bool initSpotShadow(SpotShadow& shadow, int size) {
+    shadow.size = size;
+    bool ok = createDepthTarget(size, false, shadow.staticTexture, shadow.staticFramebuffer)
+        && createDepthTarget(size, true, shadow.texture, shadow.framebuffer);
+    if (!ok) {
+        std::cout << "Mapa senki nije napravljena, senke su iskljucene." << std::endl;
+        deleteSpotShadow(shadow);
+    }
+    return ok;
+}
+
+void deleteSpotShadow(SpotShadow& shadow) {
+    glDeleteFramebuffers(1, &shadow.staticFramebuffer);
+    glDeleteFramebuffers(1, &shadow.framebuffer);
+    glDeleteTextures(1, &shadow.staticTexture);
+    glDeleteTextures(1, &shadow.texture);
+    shadow.staticFramebuffer = shadow.framebuffer = 0;
+    shadow.staticTexture = shadow.texture = 0;
+    shadow.staticValid = shadow.dynamicValid = false;
+}
+
+void setSpotShadowLight(SpotShadow& shadow, const Light& light, float nearPlane) {
+    glm::vec3 dir = glm::normalize(light.direction);
+    glm::vec3 up = std::fabs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    float fov = std::min(2.0f * std::acos(std::max(light.spotCos, 0.0f)) * kConeMargin, glm::radians(170.0f));
+    glm::mat4 view = glm::lookAt(light.position, light.position + dir, up);
+    glm::mat4 projection = glm::perspective(fov, 1.0f, nearPlane, light.radius);
+    if (view != shadow.view || projection != shadow.projection) shadow.staticValid = false;
+    shadow.position = light.position;
+    shadow.view = view;
+    shadow.projection = projection;
+    shadow.frustum = extractFrustum(projection * view);
+}
+
+void renderStaticShadows(SpotShadow& shadow, DrawList& casters, MeshPool& pool, StreamRing& ring, ShaderLibrary& shaders) {
+    if (shadow.texture != 0 && !shadow.staticValid) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        cullCasters(shadow, casters);
+        drawDepth(shadow, shadow.staticFramebuffer, true, casters, pool, ring, shaders);
+        shadow.staticValid = true;
+        shadow.dynamicValid = false;
+        ++shadow.stats.staticRenders;
+        shadow.stats.renderMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    clearDrawList(casters);
+}
+
+void renderDynamicShadows(SpotShadow& shadow, DrawList& casters, MeshPool& pool, StreamRing& ring, ShaderLibrary& shaders) {
+    if (shadow.texture == 0 || !shadow.staticValid) {
+        clearDrawList(casters);
+        return;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    shadow.stats.casters = cullCasters(shadow, casters);
+    uint64_t key = hashCasters(casters);
+    if (shadow.dynamicValid && key == shadow.dynamicKey) {
+        ++shadow.stats.reused;
+        clearDrawList(casters);
+        return;
+    }
+
+    if (GLEW_VERSION_4_3 || GLEW_ARB_copy_image) {
+        glCopyImageSubData(shadow.staticTexture, GL_TEXTURE_2D, 0, 0, 0, 0, shadow.texture, GL_TEXTURE_2D, 0, 0, 0, 0, shadow.size, shadow.size, 1);
+    } else {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, shadow.staticFramebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, shadow.framebuffer);
+        glBlitFramebuffer(0, 0, shadow.size, shadow.size, 0, 0, shadow.size, shadow.size, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    drawDepth(shadow, shadow.framebuffer, false, casters, pool, ring, shaders);
+    shadow.dynamicKey = key;
+    shadow.dynamicValid = true;
+    ++shadow.stats.dynamicRenders;
+    shadow.stats.renderMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    clearDrawList(casters);
+}
+
+void bindSpotShadow(const SpotShadow& shadow, FrameUniforms& frame, int lightIndex) {
+    if (shadow.texture == 0 || !shadow.dynamicValid) {
+        frame.shadowParams = glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f);
+        return;
+    }
+    const glm::mat4 toTexture = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+    frame.shadowMatrix = toTexture * shadow.projection * shadow.view;
+    frame.shadowParams = glm::vec4((float)lightIndex, 1.0f / shadow.size, 0.0f, 0.0f);
+    glActiveTexture(GL_TEXTURE0 + kShadowTextureUnit);
+    glBindTexture(GL_TEXTURE_2D, shadow.texture);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,152 @@
+#include "../Header/StreamRing.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// Returns true if the wait had to block.
+bool waitFence(GLsync& fence) {
+    if (!fence) return false;
+    bool blocked = false;
+    GLbitfield flags = 0;
+    for (;;) {
+        GLenum result = glClientWaitSync(fence, flags, 1000000);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) break;
+        blocked = true;
+        flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    }
+    glDeleteSync(fence);
+    fence = 0;
+    return blocked;
+}
+
+void createStorage(StreamRing& ring, size_t regionBytes) {
+    const size_t total = regionBytes * kStreamRegions;
+    ring.regionBytes = regionBytes;
+    ring.mapped = nullptr;
+    ring.staging.clear();
+    glGenBuffers(1, &ring.buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ring.buffer);
+    if (GLEW_ARB_buffer_storage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, total, NULL, flags);
+        ring.mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags);
+        if (!ring.mapped) {
+            // Immutable storage cannot be respecified, so the fallback needs a new buffer.
+            std::cout << "Persistent mapping failed, using buffer orphaning" << std::endl;
+            glDeleteBuffers(1, &ring.buffer);
+            glGenBuffers(1, &ring.buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, ring.buffer);
+        }
+    }
+    if (!ring.mapped) {
+        glBufferData(GL_COPY_WRITE_BUFFER, total, NULL, GL_STREAM_DRAW);
+        ring.staging.resize(total);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Waits for and deletes the fences too.
+void releaseStorage(StreamRing& ring) {
+    for (int i = 0; i < kStreamRegions; ++i) waitFence(ring.fences[i]);
+    if (ring.buffer == 0) return;
+    if (ring.mapped) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ring.buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &ring.buffer);
+    ring.buffer = 0;
+    ring.mapped = nullptr;
+}
+
+}
+
+void initStreamRing(StreamRing& ring, size_t regionBytes) {
+    createStorage(ring, regionBytes);
+    ring.region = 0;
+    ring.head = 0;
+}
+
+void beginStreamFrame(StreamRing& ring) {
+    ring.region = (ring.region + 1) % kStreamRegions;
+    ring.head = 0;
+    ring.bindings.clear();
+    if (waitFence(ring.fences[ring.region])) ++ring.stalls;
+    if (!ring.mapped) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ring.buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, ring.regionBytes * kStreamRegions, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+void endStreamFrame(StreamRing& ring) {
+    // Orphaning lets the driver handle reuse, so only the mapped path needs fences.
+    if (!ring.mapped || ring.head == 0) return;
+    if (ring.fences[ring.region]) glDeleteSync(ring.fences[ring.region]);
+    ring.fences[ring.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+unsigned char* streamAllocate(StreamRing& ring, size_t bytes, size_t alignment, size_t& offset) {
+    size_t start = ring.region * ring.regionBytes;
+    offset = (start + ring.head + alignment - 1) / alignment * alignment;
+    if (offset + bytes > start + ring.regionBytes) {
+        // Deleting the old buffer would unbind the uniform ranges bound from it this frame,
+        // so they are copied over and bound again. Draws already issued keep it alive
+        // until they finish.
+        size_t needed = bytes + alignment;
+        for (const StreamBinding& b : ring.bindings) needed += b.bytes + b.alignment;
+        size_t regionBytes = std::max(ring.regionBytes * 2, needed);
+        std::cout << "Stream ring grown to " << regionBytes * kStreamRegions / 1024 << " KB" << std::endl;
+        StreamRing old;
+        old.buffer = ring.buffer;
+        old.mapped = ring.mapped;
+        for (int i = 0; i < kStreamRegions; ++i) std::swap(old.fences[i], ring.fences[i]);
+        createStorage(ring, regionBytes);
+        ring.region = 0;
+        ring.head = 0;
+        glBindBuffer(GL_COPY_READ_BUFFER, old.buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ring.buffer);
+        for (StreamBinding& b : ring.bindings) {
+            const size_t to = (ring.head + b.alignment - 1) / b.alignment * b.alignment;
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, b.offset, to, b.bytes);
+            b.offset = to;
+            ring.head = to + b.bytes;
+            glBindBufferRange(GL_UNIFORM_BUFFER, b.index, ring.buffer, b.offset, b.bytes);
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        releaseStorage(old);
+        start = 0;
+        offset = (ring.head + alignment - 1) / alignment * alignment;
+    }
+    ring.head = offset + bytes - start;
+    return (ring.mapped ? ring.mapped : ring.staging.data()) + offset;
+}
+
+void streamBindUniforms(StreamRing& ring, GLuint index, size_t offset, size_t bytes, size_t alignment) {
+    glBindBufferRange(GL_UNIFORM_BUFFER, index, ring.buffer, offset, bytes);
+    StreamBinding binding;
+    binding.index = index;
+    binding.offset = offset;
+    binding.bytes = bytes;
+    binding.alignment = alignment;
+    for (StreamBinding& b : ring.bindings)
+        if (b.index == index) {
+            b = binding;
+            return;
+        }
+    ring.bindings.push_back(binding);
+}
+
+void streamCommit(StreamRing& ring, size_t offset, size_t bytes) {
+    if (ring.mapped || bytes == 0) return;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ring.buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, offset, bytes, ring.staging.data() + offset);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void deleteStreamRing(StreamRing& ring) {
+    releaseStorage(ring);
+    ring = StreamRing();
+}
@@ -0,0 +1,395 @@
+#include "../Header/TextureCache.h"
+#include "../Header/Mipmaps.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <algorithm>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+namespace {
+
+const unsigned char kKTXIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+const uint32_t kKTXEndianness = 0x04030201;
+
+// Fields of the KTX 1.1 header after the identifier.
+struct KTXHeader {
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+// Bumped whenever the encoder changes, so old files are not picked up.
+const uint32_t kEncoderVersion = 2;
+
+uint16_t packColor565(const float* c) {
+    int r = std::min(31, std::max(0, (int)(c[0] * (31.0f / 255.0f) + 0.5f)));
+    int g = std::min(63, std::max(0, (int)(c[1] * (63.0f / 255.0f) + 0.5f)));
+    int b = std::min(31, std::max(0, (int)(c[2] * (31.0f / 255.0f) + 0.5f)));
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+void unpackColor565(uint16_t c, int* out) {
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+}
+
+// Picks the palette entry nearest to each texel; returns the 32 index bits.
+uint32_t matchColors(const unsigned char* rgba, uint16_t c0, uint16_t c1) {
+    int palette[4][3];
+    unpackColor565(c0, palette[0]);
+    unpackColor565(c1, palette[1]);
+    for (int k = 0; k < 3; ++k) {
+        palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+        palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+    }
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; ++i) {
+        const unsigned char* p = rgba + i * 4;
+        int best = 0, bestError = INT32_MAX;
+        for (int j = 0; j < 4; ++j) {
+            int dr = p[0] - palette[j][0], dg = p[1] - palette[j][1], db = p[2] - palette[j][2];
+            int error = dr * dr + dg * dg + db * db;
+            if (error < bestError) { bestError = error; best = j; }
+        }
+        bits |= (uint32_t)best << (2 * i);
+    }
+    return bits;
+}
+
+// Endpoints at the extremes of the block along its principal axis.
+void principalEndpoints(const unsigned char* rgba, float* lo, float* hi) {
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+        for (int k = 0; k < 3; ++k) mean[k] += rgba[i * 4 + k];
+    for (int k = 0; k < 3; ++k) mean[k] /= 16.0f;
+    float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i) {
+        float r = rgba[i * 4] - mean[0], g = rgba[i * 4 + 1] - mean[1], b = rgba[i * 4 + 2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+    float axis[3] = { 0.9f, 1.0f, 0.7f };
+    for (int iter = 0; iter < 4; ++iter) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float m = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+        if (m < 1e-4f) break;
+        axis[0] = x / m; axis[1] = y / m; axis[2] = z / m;
+    }
+    float minDot = 1e30f, maxDot = -1e30f;
+    int minIndex = 0, maxIndex = 0;
+    for (int i = 0; i < 16; ++i) {
+        float d = rgba[i * 4] * axis[0] + rgba[i * 4 + 1] * axis[1] + rgba[i * 4 + 2] * axis[2];
+        if (d < minDot) { minDot = d; minIndex = i; }
+        if (d > maxDot) { maxDot = d; maxIndex = i; }
+    }
+    for (int k = 0; k < 3; ++k) {
+        lo[k] = rgba[minIndex * 4 + k];
+        hi[k] = rgba[maxIndex * 4 + k];
+    }
+}
+
+// Least-squares endpoints for the current index assignment. Returns false when the
+// assignment is degenerate and the endpoints should stay.
+bool refineEndpoints(const unsigned char* rgba, uint32_t bits, float* c0, float* c1) {
+    const float w0[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i) {
+        float a = w0[(bits >> (2 * i)) & 3], b = 1.0f - a;
+        aa += a * a; bb += b * b; ab += a * b;
+        for (int k = 0; k < 3; ++k) {
+            ax[k] += a * rgba[i * 4 + k];
+            bx[k] += b * rgba[i * 4 + k];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f) return false;
+    for (int k = 0; k < 3; ++k) {
+        c0[k] = std::min(255.0f, std::max(0.0f, (ax[k] * bb - bx[k] * ab) / det));
+        c1[k] = std::min(255.0f, std::max(0.0f, (bx[k] * aa - ax[k] * ab) / det));
+    }
+    return true;
+}
+
+void writeColorBlock(unsigned char* out, uint16_t c0, uint16_t c1, uint32_t bits) {
+    out[0] = (unsigned char)(c0 & 0xFF); out[1] = (unsigned char)(c0 >> 8);
+    out[2] = (unsigned char)(c1 & 0xFF); out[3] = (unsigned char)(c1 >> 8);
+    for (int i = 0; i < 4; ++i) out[4 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+void encodeAlphaBlock(const unsigned char* rgba, unsigned char* out) {
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 16; ++i) {
+        lo = std::min(lo, (int)rgba[i * 4 + 3]);
+        hi = std::max(hi, (int)rgba[i * 4 + 3]);
+    }
+    out[0] = (unsigned char)hi;
+    out[1] = (unsigned char)lo;
+    uint64_t bits = 0;
+    if (hi > lo) {
+        // Eight-value mode: entry 0 is hi, 1 is lo, 2..7 step from hi towards lo.
+        int palette[8] = { hi, lo };
+        for (int j = 2; j < 8; ++j) palette[j] = ((8 - j) * hi + (j - 1) * lo) / 7;
+        for (int i = 0; i < 16; ++i) {
+            int a = rgba[i * 4 + 3], best = 0, bestError = 256;
+            for (int j = 0; j < 8; ++j) {
+                int error = std::abs(a - palette[j]);
+                if (error < bestError) { bestError = error; best = j; }
+            }
+            bits |= (uint64_t)best << (3 * i);
+        }
+    }
+    for (int i = 0; i < 6; ++i) out[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// Copies the 4x4 block at (bx, by), clamping at the right and bottom edges.
+void gatherBlock(const unsigned char* rgba, int width, int height, int bx, int by, unsigned char* block) {
+    for (int y = 0; y < 4; ++y) {
+        int sy = std::min(by * 4 + y, height - 1);
+        for (int x = 0; x < 4; ++x) {
+            int sx = std::min(bx * 4 + x, width - 1);
+            std::memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+        }
+    }
+}
+
+size_t rgbaChainBytes(int width, int height) {
+    size_t bytes = 0;
+    for (;;) {
+        bytes += (size_t)width * height * 4;
+        if (width == 1 && height == 1) return bytes;
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+}
+
+std::string cachePath(const TextureCache& cache, const char* filePath) {
+    struct stat info;
+    if (stat(filePath, &info) != 0) return std::string();
+    uint64_t h = 14695981039346656037ull;
+    for (const char* c = filePath; *c; ++c) h = (h ^ (unsigned char)*c) * 1099511628211ull;
+    const uint64_t parts[3] = { (uint64_t)info.st_size, (uint64_t)info.st_mtime, kEncoderVersion };
+    for (uint64_t part : parts)
+        for (int i = 0; i < 8; ++i) h = (h ^ ((part >> (8 * i)) & 0xFF)) * 1099511628211ull;
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ktx", (unsigned long long)h);
+    return cache.directory + "/" + name;
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Decodes bytes when given, else the file itself.
+bool readOrEncode(const TextureCache& cache, const char* filePath, const std::vector<unsigned char>* bytes, ThreadPool* threads, CompressedLoad& load) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const std::string path = cachePath(cache, filePath);
+    load.cached = !path.empty() && readKTX(path, load.image);
+    if (!load.cached) {
+        DecodedImage decoded;
+        if (bytes ? !decodeImage(bytes->data(), bytes->size(), filePath, decoded) : !decodeImage(filePath, decoded)) return false;
+        std::chrono::steady_clock::time_point encodeStart = std::chrono::steady_clock::now();
+        compressImage(decoded, load.image, threads);
+        load.encodeMs = msSince(encodeStart);
+#ifdef _WIN32
+        _mkdir(cache.directory.c_str());
+#else
+        mkdir(cache.directory.c_str(), 0755);
+#endif
+        if (!path.empty() && !writeKTX(path, load.image)) std::cout << "Kes teksture nije upisan: " << path << std::endl;
+    }
+    load.ms = msSince(start);
+    return true;
+}
+
+}
+
+void encodeBC1Block(const unsigned char* rgba, unsigned char* out) {
+    float lo[3], hi[3];
+    principalEndpoints(rgba, lo, hi);
+    uint16_t c0 = packColor565(hi), c1 = packColor565(lo);
+    uint32_t bits = 0;
+    if (c0 != c1) {
+        if (c0 < c1) std::swap(c0, c1);
+        bits = matchColors(rgba, c0, c1);
+        float r0[3], r1[3];
+        if (refineEndpoints(rgba, bits, r0, r1)) {
+            uint16_t n0 = packColor565(r0), n1 = packColor565(r1);
+            if (n0 < n1) std::swap(n0, n1);
+            if (n0 != n1 && (n0 != c0 || n1 != c1)) {
+                c0 = n0; c1 = n1;
+                bits = matchColors(rgba, c0, c1);
+            }
+        }
+    }
+    // c0 > c1 keeps the four-colour mode; equal endpoints need no indices.
+    writeColorBlock(out, c0, c1, c0 == c1 ? 0 : bits);
+}
+
+void encodeBC3Block(const unsigned char* rgba, unsigned char* out) {
+    encodeAlphaBlock(rgba, out);
+    encodeBC1Block(rgba, out + 8);
+}
+
+void compressImage(const DecodedImage& image, CompressedImage& out, ThreadPool* threads) {
+    std::vector<MipLevel> mips;
+    buildMipChain(image, mips, threads);
+    bool opaque = true;
+    for (size_t i = 3; i < mips[0].pixels.size() && opaque; i += 4) opaque = mips[0].pixels[i] == 255;
+    out.format = opaque ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    out.width = image.width;
+    out.height = image.height;
+    out.levels.assign(mips.size(), std::vector<unsigned char>());
+    const size_t blockBytes = opaque ? 8 : 16;
+
+    for (size_t l = 0; l < mips.size(); ++l) {
+        const MipLevel& level = mips[l];
+        const int blocksX = (level.width + 3) / 4, blocksY = (level.height + 3) / 4;
+        out.levels[l].resize((size_t)blocksX * blocksY * blockBytes);
+        auto encodeRows = [&](size_t begin, size_t end) {
+            unsigned char block[64];
+            for (size_t by = begin; by < end; ++by) {
+                unsigned char* dst = &out.levels[l][by * blocksX * blockBytes];
+                for (int bx = 0; bx < blocksX; ++bx, dst += blockBytes) {
+                    gatherBlock(level.pixels.data(), level.width, level.height, bx, (int)by, block);
+                    if (opaque) encodeBC1Block(block, dst);
+                    else encodeBC3Block(block, dst);
+                }
+            }
+        };
+        if (threads && !threads->workers.empty() && blocksY > 1) parallelFor(*threads, blocksY, std::max(1, 1024 / blocksX), encodeRows);
+        else encodeRows(0, blocksY);
+    }
+}
+
+bool writeKTX(const std::string& path, const CompressedImage& image) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    KTXHeader header = {};
+    header.endianness = kKTXEndianness;
+    header.glTypeSize = 1;
+    header.glInternalFormat = image.format;
+    header.glBaseInternalFormat = image.format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? GL_RGB : GL_RGBA;
+    header.pixelWidth = image.width;
+    header.pixelHeight = image.height;
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = (uint32_t)image.levels.size();
+    file.write((const char*)kKTXIdentifier, sizeof(kKTXIdentifier));
+    file.write((const char*)&header, sizeof(header));
+    // Compressed block sizes are multiples of 8, so no mip padding is needed.
+    for (const std::vector<unsigned char>& level : image.levels) {
+        uint32_t size = (uint32_t)level.size();
+        file.write((const char*)&size, sizeof(size));
+        file.write((const char*)level.data(), size);
+    }
+    return (bool)file;
+}
+
+bool readKTX(const std::string& path, CompressedImage& image) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    unsigned char identifier[12];
+    KTXHeader header;
+    if (!file.read((char*)identifier, sizeof(identifier)) || std::memcmp(identifier, kKTXIdentifier, sizeof(identifier)) != 0) return false;
+    if (!file.read((char*)&header, sizeof(header)) || header.endianness != kKTXEndianness) return false;
+    if (header.glInternalFormat != GL_COMPRESSED_RGB_S3TC_DXT1_EXT && header.glInternalFormat != GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) return false;
+    if (header.numberOfFaces != 1 || header.numberOfArrayElements != 0 || header.numberOfMipmapLevels == 0) return false;
+    file.seekg(header.bytesOfKeyValueData, std::ios::cur);
+    image.format = header.glInternalFormat;
+    image.width = (int)header.pixelWidth;
+    image.height = (int)header.pixelHeight;
+    image.levels.resize(header.numberOfMipmapLevels);
+    const size_t blockBytes = image.format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16;
+    int width = image.width, height = image.height;
+    for (std::vector<unsigned char>& level : image.levels) {
+        uint32_t size = 0;
+        if (!file.read((char*)&size, sizeof(size)) || size != (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes) return false;
+        level.resize(size);
+        if (!file.read((char*)level.data(), size)) return false;
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return true;
+}
+
+bool compressedTexturesSupported() {
+    return GLEW_EXT_texture_compression_s3tc != 0;
+}
+
+void uploadCompressedImage(unsigned texture, const CompressedImage& image, GLenum target) {
+    glBindTexture(target, texture);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+    int width = image.width, height = image.height;
+    for (size_t i = 0; i < image.levels.size(); ++i) {
+        if (target == GL_TEXTURE_2D_ARRAY)
+            glCompressedTexImage3D(target, (GLint)i, image.format, width, height, 1, 0, (GLsizei)image.levels[i].size(), image.levels[i].data());
+        else
+            glCompressedTexImage2D(target, (GLint)i, image.format, width, height, 0, (GLsizei)image.levels[i].size(), image.levels[i].data());
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    glBindTexture(target, 0);
+}
+
+bool loadCompressedImage(TextureCache& cache, const char* filePath, CompressedImage& image) {
+    CompressedLoad load;
+    if (!readOrEncode(cache, filePath, nullptr, cache.threads, load)) return false;
+    countCompressedLoad(cache, filePath, load);
+    image = std::move(load.image);
+    return true;
+}
+
+bool prepareCompressedImage(const TextureCache& cache, const char* filePath, const std::vector<unsigned char>& bytes, CompressedLoad& load) {
+    return readOrEncode(cache, filePath, &bytes, nullptr, load);
+}
+
+void countCompressedLoad(TextureCache& cache, const char* filePath, const CompressedLoad& load) {
+    const CompressedImage& image = load.image;
+    size_t bytes = 0;
+    for (const std::vector<unsigned char>& level : image.levels) bytes += level.size();
+    cache.stats.compressedBytes += bytes;
+    cache.stats.uncompressedBytes += rgbaChainBytes(image.width, image.height);
+    ++cache.stats.textures;
+    ++(load.cached ? cache.stats.hits : cache.stats.misses);
+    cache.stats.loadMs += load.ms;
+    cache.stats.encodeMs += load.encodeMs;
+    std::cout << "Tekstura " << filePath << (load.cached ? " ucitana iz kesa" : " kompresovana") << " za " << load.ms << " ms, "
+        << bytes / 1024 << " KB (" << (image.format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? "BC1" : "BC3") << ")" << std::endl;
+}
+
+unsigned loadCompressedTexture(TextureCache& cache, const char* filePath) {
+    if (!compressedTexturesSupported()) return loadImageToTexture(filePath);
+    CompressedImage image;
+    if (!loadCompressedImage(cache, filePath, image)) return 0;
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    uploadCompressedImage(texture, image);
+    return texture;
+}
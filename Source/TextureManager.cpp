@@ -0,0 +1,394 @@
+#include "../Header/TextureManager.h"
+#include "../Header/Mipmaps.h"
+#include "../Header/stb_image.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+
+namespace {
+
+// Mips used from the atlas. A slot starts on a multiple of kGutter and is padded by
+// kGutter repeated edge texels, so down to the last level every texel a draw samples
+// comes from its own image.
+const int kAtlasLevels = 4;
+const int kGutter = 1 << (kAtlasLevels - 1);
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int roundUp(int value, int multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+bool fitsAtlas(const TextureManager& manager, int width, int height) {
+    const int limit = std::min(manager.maxPackedSize, manager.layerSize - 2 * kGutter);
+    return width <= limit && height <= limit;
+}
+
+void texel(const DecodedImage& image, int x, int y, unsigned char* out) {
+    const unsigned char* p = &image.pixels[((size_t)y * image.width + x) * image.channels];
+    if (image.channels >= 3) {
+        out[0] = p[0]; out[1] = p[1]; out[2] = p[2];
+        out[3] = image.channels == 4 ? p[3] : 255;
+    } else {
+        out[0] = out[1] = out[2] = p[0];
+        out[3] = image.channels == 2 ? p[1] : 255;
+    }
+}
+
+// Smallest free slot that fits, else the best-fitting shelf with room, else a new shelf,
+// else a new layer.
+void allocateSlot(TextureManager& manager, int width, int height, ManagedImage& m) {
+    const int slotWidth = roundUp(width + 2 * kGutter, kGutter), slotHeight = roundUp(height + 2 * kGutter, kGutter);
+    int freeLayer = -1;
+    size_t freeIndex = 0;
+    for (size_t l = 0; l < manager.layers.size(); ++l) {
+        const std::vector<AtlasSlot>& slots = manager.layers[l].freeSlots;
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].width < slotWidth || slots[i].height < slotHeight) continue;
+            if (freeLayer < 0 || slots[i].width * slots[i].height < manager.layers[freeLayer].freeSlots[freeIndex].width * manager.layers[freeLayer].freeSlots[freeIndex].height) {
+                freeLayer = (int)l;
+                freeIndex = i;
+            }
+        }
+    }
+    if (freeLayer >= 0) {
+        std::vector<AtlasSlot>& slots = manager.layers[freeLayer].freeSlots;
+        m.layer = freeLayer;
+        m.x = slots[freeIndex].x;
+        m.y = slots[freeIndex].y;
+        m.width = slots[freeIndex].width;
+        m.height = slots[freeIndex].height;
+        slots.erase(slots.begin() + freeIndex);
+        return;
+    }
+    for (size_t l = 0; l < manager.layers.size(); ++l) {
+        AtlasLayer& layer = manager.layers[l];
+        AtlasShelf* best = nullptr;
+        for (AtlasShelf& shelf : layer.shelves)
+            if (shelf.height >= slotHeight && shelf.used + slotWidth <= manager.layerSize && (!best || shelf.height < best->height)) best = &shelf;
+        if (!best && layer.top + slotHeight <= manager.layerSize) {
+            AtlasShelf shelf;
+            shelf.y = layer.top;
+            shelf.height = slotHeight;
+            layer.shelves.push_back(shelf);
+            layer.top += slotHeight;
+            best = &layer.shelves.back();
+        }
+        if (!best) continue;
+        m.layer = (int)l;
+        m.x = best->used;
+        m.y = best->y;
+        best->used += slotWidth;
+        m.width = slotWidth;
+        m.height = slotHeight;
+        return;
+    }
+    AtlasLayer layer;
+    layer.image.width = layer.image.height = manager.layerSize;
+    layer.image.channels = 4;
+    layer.image.pixels.assign((size_t)manager.layerSize * manager.layerSize * 4, 0);
+    manager.layers.push_back(std::move(layer));
+    allocateSlot(manager, width, height, m);
+}
+
+void uploadLayer(TextureManager& manager, int index) {
+    std::vector<MipLevel> levels;
+    buildMipChain(manager.layers[index].image, levels, manager.cache.threads);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, manager.atlas);
+    for (int l = 0; l < kAtlasLevels && l < (int)levels.size(); ++l)
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, l, 0, 0, index, levels[l].width, levels[l].height, 1, GL_RGBA, GL_UNSIGNED_BYTE, levels[l].pixels.data());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+// Makes room for every CPU layer. Growing re-creates the texture with all layers
+// uploaded again, and every packed region is pointed at the new one.
+bool growAtlas(TextureManager& manager) {
+    if ((int)manager.layers.size() <= manager.atlasCapacity) return false;
+    if (manager.atlas != 0) glDeleteTextures(1, &manager.atlas);
+    manager.atlasCapacity = std::max((int)manager.layers.size(), manager.atlasCapacity * 2);
+    glGenTextures(1, &manager.atlas);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, manager.atlas);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, kAtlasLevels - 1);
+    manager.stats.atlasBytes = 0;
+    for (int l = 0; l < kAtlasLevels; ++l) {
+        const int size = std::max(1, manager.layerSize >> l);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, l, GL_RGBA8, size, size, manager.atlasCapacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        manager.stats.atlasBytes += (size_t)size * size * 4 * manager.atlasCapacity;
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    for (int l = 0; l < (int)manager.layers.size(); ++l) uploadLayer(manager, l);
+    for (ManagedImage& m : manager.images)
+        if (m.layer >= 0) m.region.texture = manager.atlas;
+    return true;
+}
+
+// Copies image into m's slot with its edges repeated over the gutter. Slots are aligned
+// to whole texels of the last atlas level, so their mips are filtered from the slot
+// alone and only the slot is uploaded.
+void writeSlot(TextureManager& manager, ManagedImage& m, const DecodedImage& image) {
+    DecodedImage slot;
+    slot.width = m.width;
+    slot.height = m.height;
+    slot.channels = 4;
+    slot.pixels.resize((size_t)m.width * m.height * 4);
+    for (int y = 0; y < m.height; ++y) {
+        const int sy = std::min(std::max(y - kGutter, 0), image.height - 1);
+        unsigned char* row = &slot.pixels[(size_t)y * m.width * 4];
+        for (int x = 0; x < m.width; ++x) texel(image, std::min(std::max(x - kGutter, 0), image.width - 1), sy, row + x * 4);
+    }
+    DecodedImage& layer = manager.layers[m.layer].image;
+    for (int y = 0; y < m.height; ++y)
+        std::copy(slot.pixels.begin() + (size_t)y * m.width * 4, slot.pixels.begin() + (size_t)(y + 1) * m.width * 4,
+            layer.pixels.begin() + ((size_t)(m.y + y) * layer.width + m.x) * 4);
+
+    if (!growAtlas(manager)) {
+        std::vector<MipLevel> levels;
+        buildMipChain(slot, levels, manager.cache.threads);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, manager.atlas);
+        for (int l = 0; l < kAtlasLevels; ++l)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, l, m.x >> l, m.y >> l, m.layer, levels[l].width, levels[l].height, 1, GL_RGBA, GL_UNSIGNED_BYTE, levels[l].pixels.data());
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+    const float size = (float)manager.layerSize;
+    m.region.texture = manager.atlas;
+    m.region.layer = (float)m.layer;
+    m.region.rect = glm::vec4((m.x + kGutter) / size, (m.y + kGutter) / size, image.width / size, image.height / size);
+    m.bytes = 0;
+    for (int l = 0; l < kAtlasLevels; ++l) m.bytes += (size_t)(m.width >> l) * (m.height >> l) * 4;
+    m.cpuBytes = (size_t)m.width * m.height * 4;
+}
+
+void packImage(TextureManager& manager, ManagedImage& m, const DecodedImage& image) {
+    allocateSlot(manager, image.width, image.height, m);
+    writeSlot(manager, m, image);
+    ++manager.stats.packed;
+}
+
+void freeSlot(TextureManager& manager, ManagedImage& m) {
+    AtlasSlot slot;
+    slot.x = m.x;
+    slot.y = m.y;
+    slot.width = m.width;
+    slot.height = m.height;
+    manager.layers[m.layer].freeSlots.push_back(slot);
+    m.layer = -1;
+    m.region.texture = 0;
+    m.bytes = m.cpuBytes = 0;
+    --manager.stats.packed;
+}
+
+void releaseStandalone(TextureManager& manager, ManagedImage& m) {
+    glDeleteTextures(1, &m.region.texture);
+    m.region.texture = 0;
+    manager.stats.standaloneBytes -= m.bytes;
+    m.bytes = 0;
+    --manager.stats.standalone;
+}
+
+// A texture of its own, as a one-layer array so it samples like the atlas.
+void uploadStandalone(TextureManager& manager, ManagedImage& m, const std::vector<MipLevel>* mips, const CompressedImage* compressed) {
+    if (m.region.texture == 0) {
+        glGenTextures(1, &m.region.texture);
+        ++manager.stats.standalone;
+    }
+    m.region.layer = 0.0f;
+    m.region.rect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    manager.stats.standaloneBytes -= m.bytes;
+    m.bytes = 0;
+    if (compressed) {
+        uploadCompressedImage(m.region.texture, *compressed, GL_TEXTURE_2D_ARRAY);
+        for (const std::vector<unsigned char>& level : compressed->levels) m.bytes += level.size();
+    } else {
+        const std::vector<MipLevel>& levels = *mips;
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m.region.texture);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+        for (size_t i = 0; i < levels.size(); ++i) {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, (GLint)i, GL_RGBA8, levels[i].width, levels[i].height, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, levels[i].pixels.data());
+            m.bytes += levels[i].pixels.size();
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+    manager.stats.standaloneBytes += m.bytes;
+}
+
+void countArrays(TextureManager& manager) {
+    manager.stats.arrays = (manager.atlas != 0 ? 1 : 0) + manager.stats.standalone;
+}
+
+}
+
+bool readTextureFile(const char* filePath, std::vector<unsigned char>& bytes, uint64_t& hash) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) return false;
+    bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    hash = 14695981039346656037ull;
+    for (unsigned char c : bytes) hash = (hash ^ c) * 1099511628211ull;
+    return true;
+}
+
+bool prepareTexture(const TextureManager& manager, const char* filePath, PreparedTexture& prepared) {
+    prepared.path = filePath;
+    std::vector<unsigned char> bytes;
+    int channels;
+    if (!readTextureFile(filePath, bytes, prepared.hash)
+        || !stbi_info_from_memory(bytes.data(), (int)bytes.size(), &prepared.width, &prepared.height, &channels)) {
+        std::cout << "Textura nije ucitana! Putanja texture: " << filePath << std::endl;
+        return false;
+    }
+    // Decoded from the bytes that were hashed, so the two agree even if the file changes.
+    if (fitsAtlas(manager, prepared.width, prepared.height)) return decodeImage(bytes.data(), bytes.size(), filePath, prepared.image);
+    if (compressedTexturesSupported()) return prepareCompressedImage(manager.cache, filePath, bytes, prepared.compressed);
+    DecodedImage decoded;
+    if (!decodeImage(bytes.data(), bytes.size(), filePath, decoded)) return false;
+    buildMipChain(decoded, prepared.mips);
+    return true;
+}
+
+TextureHandle addTexture(TextureManager& manager, const PreparedTexture& prepared) {
+    ++manager.stats.requests;
+    std::unordered_map<std::string, TextureHandle>::const_iterator known = manager.byPath.find(prepared.path);
+    if (known != manager.byPath.end()) {
+        ++manager.stats.pathHits;
+        return known->second;
+    }
+    int image;
+    std::unordered_map<uint64_t, int>::const_iterator same = manager.byContent.find(prepared.hash);
+    if (same != manager.byContent.end()) {
+        image = same->second;
+        ++manager.stats.contentHits;
+    } else {
+        ManagedImage m;
+        m.hash = prepared.hash;
+        if (fitsAtlas(manager, prepared.width, prepared.height)) packImage(manager, m, prepared.image);
+        else if (prepared.compressed.image.levels.empty()) uploadStandalone(manager, m, &prepared.mips, nullptr);
+        else {
+            countCompressedLoad(manager.cache, prepared.path.c_str(), prepared.compressed);
+            uploadStandalone(manager, m, nullptr, &prepared.compressed.image);
+        }
+        image = (int)manager.images.size();
+        manager.images.push_back(m);
+        manager.byContent[prepared.hash] = image;
+        countArrays(manager);
+    }
+
+    ++manager.images[image].users;
+    ManagedTexture texture;
+    texture.path = prepared.path;
+    texture.image = image;
+    const TextureHandle handle = (TextureHandle)manager.textures.size();
+    manager.textures.push_back(texture);
+    manager.byPath[prepared.path] = handle;
+    return handle;
+}
+
+TextureHandle loadTexture(TextureManager& manager, const char* filePath) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::unordered_map<std::string, TextureHandle>::const_iterator known = manager.byPath.find(filePath);
+    if (known != manager.byPath.end()) {
+        ++manager.stats.requests;
+        ++manager.stats.pathHits;
+        return known->second;
+    }
+    PreparedTexture prepared;
+    if (!prepareTexture(manager, filePath, prepared)) return kNoTexture;
+    TextureHandle handle = addTexture(manager, prepared);
+    manager.stats.loadMs += msSince(start);
+    return handle;
+}
+
+void unloadTexture(TextureManager& manager, TextureHandle handle) {
+    if (handle < 0 || handle >= (TextureHandle)manager.textures.size() || manager.textures[handle].image < 0) return;
+    ManagedTexture& texture = manager.textures[handle];
+    manager.byPath.erase(texture.path);
+    ManagedImage& m = manager.images[texture.image];
+    if (--m.users == 0) {
+        std::unordered_map<uint64_t, int>::iterator same = manager.byContent.find(m.hash);
+        if (same != manager.byContent.end() && same->second == texture.image) manager.byContent.erase(same);
+        if (m.layer >= 0) freeSlot(manager, m);
+        else if (m.region.texture != 0) releaseStandalone(manager, m);
+        countArrays(manager);
+    }
+    texture.image = -1;
+}
+
+const TextureRegion& textureRegion(const TextureManager& manager, TextureHandle handle) {
+    static const TextureRegion none;
+    if (handle < 0 || handle >= (TextureHandle)manager.textures.size() || manager.textures[handle].image < 0) return none;
+    return manager.images[manager.textures[handle].image].region;
+}
+
+void textureBytes(const TextureManager& manager, TextureHandle handle, size_t& cpuBytes, size_t& gpuBytes) {
+    cpuBytes = gpuBytes = 0;
+    if (handle < 0 || handle >= (TextureHandle)manager.textures.size() || manager.textures[handle].image < 0) return;
+    // Split between the paths sharing the image, so summing over paths counts it once.
+    const ManagedImage& m = manager.images[manager.textures[handle].image];
+    const size_t users = (size_t)std::max(m.users, 1);
+    cpuBytes = m.cpuBytes / users;
+    gpuBytes = m.bytes / users;
+}
+
+bool reloadTexture(TextureManager& manager, const std::string& path, uint64_t hash, const DecodedImage& image, const CompressedImage& compressed) {
+    std::unordered_map<std::string, TextureHandle>::const_iterator known = manager.byPath.find(path);
+    if (known == manager.byPath.end() || image.pixels.empty()) return false;
+    ManagedTexture& texture = manager.textures[known->second];
+
+    // Other paths that shared the old contents keep them.
+    if (manager.images[texture.image].users > 1) {
+        --manager.images[texture.image].users;
+        texture.image = (int)manager.images.size();
+        manager.images.push_back(ManagedImage());
+        manager.images.back().users = 1;
+    } else {
+        std::unordered_map<uint64_t, int>::iterator old = manager.byContent.find(manager.images[texture.image].hash);
+        if (old != manager.byContent.end() && old->second == texture.image) manager.byContent.erase(old);
+    }
+    ManagedImage& m = manager.images[texture.image];
+    m.hash = hash;
+    if (!manager.byContent.count(hash)) manager.byContent[hash] = texture.image;
+
+    if (fitsAtlas(manager, image.width, image.height)) {
+        if (m.layer < 0 && m.region.texture != 0) releaseStandalone(manager, m);
+        if (m.layer >= 0 && image.width + 2 * kGutter <= m.width && image.height + 2 * kGutter <= m.height) {
+            writeSlot(manager, m, image);
+        } else {
+            if (m.layer >= 0) freeSlot(manager, m);
+            packImage(manager, m, image);
+        }
+    } else {
+        if (m.layer >= 0) freeSlot(manager, m);
+        if (compressed.levels.empty()) {
+            std::vector<MipLevel> mips;
+            buildMipChain(image, mips, manager.cache.threads);
+            uploadStandalone(manager, m, &mips, nullptr);
+        } else {
+            uploadStandalone(manager, m, nullptr, &compressed);
+        }
+    }
+    countArrays(manager);
+    return true;
+}
+
+void deleteTextureManager(TextureManager& manager) {
+    for (ManagedImage& m : manager.images)
+        if (m.layer < 0 && m.region.texture != 0) glDeleteTextures(1, &m.region.texture);
+    if (manager.atlas != 0) glDeleteTextures(1, &manager.atlas);
+    manager.atlas = 0;
+    manager.atlasCapacity = 0;
+    manager.layers.clear();
+    manager.images.clear();
+    manager.textures.clear();
+    manager.byPath.clear();
+    manager.byContent.clear();
+}
@@ -0,0 +1,69 @@
+#include "../Header/ThreadPool.h"
+#include <algorithm>
+
+namespace {
+
+void runChunks(ThreadPool& pool) {
+    for (;;) {
+        size_t begin = pool.next.fetch_add(pool.grain);
+        if (begin >= pool.count) break;
+        pool.job(begin, std::min(begin + pool.grain, pool.count));
+    }
+}
+
+void workerLoop(ThreadPool* pool) {
+    unsigned long long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->wake.wait(lock, [&] { return pool->quit || pool->generation != seen; });
+            if (pool->quit) return;
+            seen = pool->generation;
+            ++pool->busy;
+        }
+        runChunks(*pool);
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (--pool->busy == 0) pool->done.notify_all();
+    }
+}
+
+}
+
+void startThreadPool(ThreadPool& pool, int threads) {
+    if (threads <= 0) threads = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    pool.quit = false;
+    for (int i = 0; i < threads; ++i) pool.workers.push_back(std::thread(workerLoop, &pool));
+}
+
+void stopThreadPool(ThreadPool& pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.quit = true;
+    }
+    pool.wake.notify_all();
+    for (std::thread& t : pool.workers) t.join();
+    pool.workers.clear();
+}
+
+void parallelFor(ThreadPool& pool, size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    if (pool.workers.empty() || count <= grain) {
+        for (size_t begin = 0; begin < count; begin += grain) fn(begin, std::min(begin + grain, count));
+        return;
+    }
+    {
+        // Workers that woke late for the previous loop may still be leaving it.
+        std::unique_lock<std::mutex> lock(pool.mutex);
+        pool.done.wait(lock, [&] { return pool.busy == 0; });
+        pool.job = fn;
+        pool.count = count;
+        pool.grain = grain;
+        pool.next = 0;
+        ++pool.generation;
+    }
+    pool.wake.notify_all();
+    runChunks(pool);
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.done.wait(lock, [&] { return pool.busy == 0; });
+}
@@ -0,0 +1,127 @@
+#include "../Header/Transparency.h"
+#include "../Header/MathBatch.h"
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+namespace {
+    const size_t kInsertionSortLimit = 32;
+
+    // Maps a float to an unsigned key with the same ordering, inverted so that
+    // ascending keys mean descending depth (farthest first).
+    uint32_t backToFrontKey(float depth) {
+        uint32_t bits;
+        std::memcpy(&bits, &depth, sizeof(bits));
+        bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+        return ~bits;
+    }
+}
+
+void sortBackToFront(const std::vector<float>& depths, std::vector<uint32_t>& order, DepthSortScratch& scratch) {
+    const size_t n = depths.size();
+    order.resize(n);
+    for (size_t i = 0; i < n; ++i) order[i] = (uint32_t)i;
+
+    if (n <= kInsertionSortLimit) {
+        for (size_t i = 1; i < n; ++i) {
+            uint32_t idx = order[i];
+            float d = depths[idx];
+            size_t j = i;
+            while (j > 0 && depths[order[j - 1]] < d) { order[j] = order[j - 1]; --j; }
+            order[j] = idx;
+        }
+        return;
+    }
+
+    scratch.keys.resize(n);
+    scratch.temp.resize(n);
+    for (size_t i = 0; i < n; ++i) scratch.keys[i] = backToFrontKey(depths[i]);
+
+    uint32_t* src = order.data();
+    uint32_t* dst = scratch.temp.data();
+    for (int shift = 0; shift < 32; shift += 8) {
+        size_t count[256] = { 0 };
+        for (size_t i = 0; i < n; ++i) ++count[(scratch.keys[src[i]] >> shift) & 0xFF];
+        if (count[(scratch.keys[src[0]] >> shift) & 0xFF] == n) continue;
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; ++b) { size_t c = count[b]; count[b] = offset; offset += c; }
+        for (size_t i = 0; i < n; ++i) dst[count[(scratch.keys[src[i]] >> shift) & 0xFF]++] = src[i];
+        std::swap(src, dst);
+    }
+    if (src != order.data()) std::memcpy(order.data(), src, n * sizeof(uint32_t));
+}
+
+void initTransparencyPass(TransparencyPass& pass, const MeshRange& mesh) {
+    pass.mesh = mesh;
+}
+
+void addTransparentInstance(TransparencyPass& pass, const glm::mat4& model, glm::vec3 color, float alpha) {
+    TransparentInstance inst;
+    inst.model = model;
+    inst.color = glm::vec4(color, alpha);
+    inst.center = glm::vec3(model[3]);
+    pass.instances.push_back(inst);
+    addBounds(pass.bounds, transformAABB(AABB(), model));
+}
+
+void cullTransparencyPass(TransparencyPass& pass, const Frustum& frustum, CullStats& stats) {
+    stats.tested += (int)pass.instances.size();
+    stats.culled += cullBounds(frustum, pass.bounds);
+}
+
+void drawTransparencyPass(TransparencyPass& pass, MeshPool& pool, StreamRing& ring, ShaderLibrary& shaders, const glm::mat4& view) {
+    size_t n = 0;
+    for (size_t i = 0; i < pass.instances.size(); ++i)
+        if (pass.bounds.visible[i]) pass.instances[n++] = pass.instances[i];
+    pass.instances.resize(n);
+    clearBounds(pass.bounds);
+    if (n == 0 || pass.mesh.indexCount == 0) { pass.instances.clear(); return; }
+
+    pass.depths.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        pass.depths[i] = -(view * glm::vec4(pass.instances[i].center, 1.0f)).z;
+    sortBackToFront(pass.depths, pass.order, pass.scratch);
+
+    pass.sortedModels.resize(n);
+    for (size_t i = 0; i < n; ++i) pass.sortedModels[i] = pass.instances[pass.order[i]].model;
+    pass.normalMatrices.resize(n);
+    computeNormalMatrices(pass.sortedModels.data(), pass.normalMatrices.data(), n);
+    const size_t bytes = n * sizeof(DrawInstance);
+    size_t offset;
+    DrawInstance* dst = (DrawInstance*)streamAllocate(ring, bytes, sizeof(float), offset);
+    for (size_t i = 0; i < n; ++i) {
+        dst[i].model = pass.sortedModels[i];
+        dst[i].color = pass.instances[pass.order[i]].color;
+        dst[i].normalMatrix = pass.normalMatrices[i];
+        dst[i].texRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        dst[i].texLayer = 0.0f;
+    }
+    streamCommit(ring, offset, bytes);
+
+    // Each pane is a closed thin box; culling its back faces leaves exactly one
+    // blended layer per pane instead of two, halving the glass overdraw.
+    GLboolean cullWasEnabled = glIsEnabled(GL_CULL_FACE);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glDepthMask(GL_FALSE);
+
+    useShaderVariant(shaders, surfaceVariant(false, true));
+    glBindVertexArray(pool.VAO);
+    bindInstanceAttributes(ring.buffer, offset);
+    // The rows start at offset rather than at a base instance, so the next opaque pass
+    // has to point the attributes back at the start of the ring.
+    pool.instanceBuffer = 0;
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)pass.mesh.indexCount, GL_UNSIGNED_INT,
+        (const void*)(size_t)(pass.mesh.firstIndex * sizeof(uint32_t)), (GLsizei)n, (GLint)pass.mesh.firstVertex);
+    glBindVertexArray(0);
+
+    glDepthMask(GL_TRUE);
+    if (!cullWasEnabled) glDisable(GL_CULL_FACE);
+
+    pass.instances.clear();
+}
+
+void deleteTransparencyPass(TransparencyPass& pass) {
+    pass = TransparencyPass();
+}
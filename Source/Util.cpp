@@ -1,4 +1,5 @@
 #include "../Header/Util.h"
+#include "../Header/Mipmaps.h"
 
 #define _CRT_SECURE_NO_WARNINGS
 #include <fstream>
@@ -14,118 +15,52 @@ int endProgram(std::string message) {
     return -1;
 }
 
-unsigned int compileShader(GLenum type, const char* source)
-{
-    std::string content = "";
-    std::ifstream file(source);
-    std::stringstream ss;
-    if (file.is_open())
-    {
-        ss << file.rdbuf();
-        file.close();
-        std::cout << "Uspjesno procitao fajl sa putanje \"" << source << "\"!" << std::endl;
-    }
-    else {
-        ss << "";
-        std::cout << "Greska pri citanju fajla sa putanje \"" << source << "\"!" << std::endl;
-    }
-    std::string temp = ss.str();
-    const char* sourceCode = temp.c_str();
+namespace {
 
-    int shader = glCreateShader(type);
-
-    int success;
-    char infoLog[512];
-    glShaderSource(shader, 1, &sourceCode, NULL);
-    glCompileShader(shader);
-
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (success == GL_FALSE)
-    {
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        if (type == GL_VERTEX_SHADER)
-            printf("VERTEX");
-        else if (type == GL_FRAGMENT_SHADER)
-            printf("FRAGMENT");
-        printf(" sejder ima gresku! Greska: \n");
-        printf(infoLog);
+bool takeDecoded(unsigned char* ImageData, const char* filePath, DecodedImage& image) {
+    if (ImageData == NULL) {
+        std::cout << "Textura nije ucitana! Putanja texture: " << filePath << std::endl;
+        return false;
     }
-    return shader;
+    stbi__vertical_flip(ImageData, image.width, image.height, image.channels);
+    image.pixels.assign(ImageData, ImageData + (size_t)image.width * image.height * image.channels);
+    stbi_image_free(ImageData);
+    return true;
 }
-unsigned int createShader(const char* vsSource, const char* fsSource)
-{
-    unsigned int program;
-    unsigned int vertexShader;
-    unsigned int fragmentShader;
-
-    program = glCreateProgram();
-
-    vertexShader = compileShader(GL_VERTEX_SHADER, vsSource);
-    fragmentShader = compileShader(GL_FRAGMENT_SHADER, fsSource);
-
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
 
-    glLinkProgram(program);
-    glValidateProgram(program);
+}
 
-    int success;
-    char infoLog[512];
-    glGetProgramiv(program, GL_VALIDATE_STATUS, &success);
-    if (success == GL_FALSE)
-    {
-        glGetShaderInfoLog(program, 512, NULL, infoLog);
-        std::cout << "Objedinjeni sejder ima gresku! Greska: \n";
-        std::cout << infoLog << std::endl;
-    }
+bool decodeImage(const char* filePath, DecodedImage& image) {
+    return takeDecoded(stbi_load(filePath, &image.width, &image.height, &image.channels, 0), filePath, image);
+}
 
-    glDetachShader(program, vertexShader);
-    glDeleteShader(vertexShader);
-    glDetachShader(program, fragmentShader);
-    glDeleteShader(fragmentShader);
+bool decodeImage(const unsigned char* data, size_t size, const char* filePath, DecodedImage& image) {
+    return takeDecoded(stbi_load_from_memory(data, (int)size, &image.width, &image.height, &image.channels, 0), filePath, image);
+}
 
-    return program;
+void uploadImageToTexture(unsigned texture, const DecodedImage& image) {
+    // Built on the CPU: glGenerateMipmap filters in gamma space and is slow on software GL.
+    std::vector<MipLevel> levels;
+    buildMipChain(image, levels);
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+    for (size_t i = 0; i < levels.size(); ++i)
+        glTexImage2D(GL_TEXTURE_2D, (GLint)i, GL_RGBA8, levels[i].width, levels[i].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, levels[i].pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 unsigned loadImageToTexture(const char* filePath) {
-    int TextureWidth;
-    int TextureHeight;
-    int TextureChannels;
-    unsigned char* ImageData = stbi_load(filePath, &TextureWidth, &TextureHeight, &TextureChannels, 0);
-    if (ImageData != NULL)
-    {
-        stbi__vertical_flip(ImageData, TextureWidth, TextureHeight, TextureChannels);
-
-        GLint InternalFormat = -1;
-        GLenum Format = GL_RGB;
-        switch (TextureChannels) {
-        case 1: InternalFormat = GL_RED; Format = GL_RED; break;
-        case 2: InternalFormat = GL_RG; Format = GL_RG; break;
-        case 3: InternalFormat = GL_RGB; Format = GL_RGB; break;
-        case 4: InternalFormat = GL_RGBA; Format = GL_RGBA; break;
-        default: InternalFormat = GL_RGB; Format = GL_RGB; break;
-        }
-
-        unsigned int Texture;
-        glGenTextures(1, &Texture);
-        glBindTexture(GL_TEXTURE_2D, Texture);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-        glTexImage2D(GL_TEXTURE_2D, 0, InternalFormat, TextureWidth, TextureHeight, 0, Format, GL_UNSIGNED_BYTE, ImageData);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        stbi_image_free(ImageData);
-        return Texture;
-    }
-    else
-    {
-        std::cout << "Textura nije ucitana! Putanja texture: " << filePath << std::endl;
-        stbi_image_free(ImageData);
-        return 0;
-    }
+    DecodedImage image;
+    if (!decodeImage(filePath, image)) return 0;
+    unsigned int Texture;
+    glGenTextures(1, &Texture);
+    uploadImageToTexture(Texture, image);
+    return Texture;
 }
 
 GLFWcursor* loadImageToCursor(const char* filePath) {